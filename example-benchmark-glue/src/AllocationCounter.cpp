@@ -0,0 +1,102 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cerrno>
+#include <new>
+
+static std::atomic<uint64_t> numAllocations{0};
+static std::atomic<uint64_t> numAllocatedBytes{0};
+
+static inline void countAllocation(std::size_t size){
+    numAllocations.fetch_add(1, std::memory_order_relaxed);
+    numAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+AllocationCounter::Snapshot AllocationCounter::get(){
+    Snapshot snapshot;
+    snapshot.count = numAllocations.load(std::memory_order_relaxed);
+    snapshot.bytes = numAllocatedBytes.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+#if defined(__GLIBC__) && !defined(BENCHMARK_NO_MALLOC_REPLACEMENT)
+// glibc supports replacing malloc, as long as the whole family is replaced : forward everything to its internal allocator
+extern "C" {
+    void* __libc_malloc(std::size_t size);
+    void* __libc_calloc(std::size_t num, std::size_t size);
+    void* __libc_realloc(void* ptr, std::size_t size);
+    void* __libc_memalign(std::size_t alignment, std::size_t size);
+    void* __libc_valloc(std::size_t size);
+    void* __libc_pvalloc(std::size_t size);
+    void __libc_free(void* ptr);
+
+    void* malloc(std::size_t size){
+        countAllocation(size);
+        return __libc_malloc(size);
+    }
+    void* calloc(std::size_t num, std::size_t size){
+        countAllocation(num*size);
+        return __libc_calloc(num, size);
+    }
+    void* realloc(void* ptr, std::size_t size){
+        countAllocation(size); // Growing a buffer counts as an allocation, even when done in place
+        return __libc_realloc(ptr, size);
+    }
+    void* memalign(std::size_t alignment, std::size_t size){
+        countAllocation(size);
+        return __libc_memalign(alignment, size);
+    }
+    void* aligned_alloc(std::size_t alignment, std::size_t size){
+        countAllocation(size);
+        return __libc_memalign(alignment, size);
+    }
+    int posix_memalign(void** ptr, std::size_t alignment, std::size_t size){
+        countAllocation(size);
+        *ptr = __libc_memalign(alignment, size);
+        return *ptr!=nullptr ? 0 : ENOMEM;
+    }
+    void* valloc(std::size_t size){
+        countAllocation(size);
+        return __libc_valloc(size);
+    }
+    void* pvalloc(std::size_t size){
+        countAllocation(size);
+        return __libc_pvalloc(size);
+    }
+    void free(void* ptr){
+        __libc_free(ptr);
+    }
+}
+
+bool AllocationCounter::isCountingMalloc(){
+    return true;
+}
+
+#else
+// operator new only (the other overloads forward to these)
+void* operator new(std::size_t size){
+    countAllocation(size);
+    if(void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size){
+    return operator new(size);
+}
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+bool AllocationCounter::isCountingMalloc(){
+    return false;
+}
+#endif
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+// Allocation counter
+// - - - -
+// Counts heap allocations made by the whole process, to report allocations per operation.
+// On glibc, the malloc family is replaced (forwarding to glibc), which also covers Blend2D's own allocations.
+// Elsewhere, only C++ allocations (operator new) are counted.
+// Define BENCHMARK_NO_MALLOC_REPLACEMENT to only count operator new everywhere.
+
+namespace AllocationCounter {
+    struct Snapshot {
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+    };
+
+    Snapshot get();
+    // True when malloc calls are counted too
+    bool isCountingMalloc();
+}
@@ -0,0 +1,297 @@
+#include "ofApp.h"
+#include "ofxBlend2DGlue.h"
+#include "AllocationCounter.h"
+
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+
+// Results are folded into this, so the compiler can't drop the measured work
+static volatile uint64_t benchmarkSink = 0;
+
+//--------------------------------------------------------------
+// Deterministic inputs
+static float getRandomValue(uint32_t& state){
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return (state & 0xFFFFFF) / float(0xFFFFFF);
+}
+
+// Mixed commands, like an imported SVG : sub-paths of lines, cubics and quads
+static ofPath makeCommandsPath(std::size_t numCommands){
+    ofPath path;
+    path.setMode(ofPath::Mode::COMMANDS);
+    uint32_t state = 0x9E3779B9u;
+    auto randomPoint = [&state](){ return glm::vec3(getRandomValue(state)*1920.f, getRandomValue(state)*1080.f, 0.f); };
+    for(std::size_t i=0; i<numCommands; ++i){
+        switch(i%8){
+            case 0: path.moveTo(randomPoint()); break;
+            case 1: case 2: case 3: path.lineTo(randomPoint()); break;
+            case 4: case 5: path.bezierTo(randomPoint(), randomPoint(), randomPoint()); break;
+            case 6: path.quadBezierTo(randomPoint(), randomPoint(), randomPoint()); break;
+            case 7: path.close(); break;
+        }
+    }
+    return path;
+}
+
+static ofPolyline makePolyline(std::size_t numVertices){
+    ofPolyline polyline;
+    uint32_t state = 0x85EBCA6Bu;
+    for(std::size_t i=0; i<numVertices; ++i){
+        polyline.addVertex(getRandomValue(state)*1920.f, getRandomValue(state)*1080.f);
+    }
+    polyline.close();
+    return polyline;
+}
+
+// 10, 100, ... up to max
+static std::vector<std::size_t> getItemCounts(std::size_t maxItems){
+    std::vector<std::size_t> counts;
+    for(std::size_t count=10; count<=maxItems; count*=10) counts.push_back(count);
+    return counts;
+}
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+    std::string error;
+    if(!parseArguments(error)){
+        if(!error.empty()){
+            ofLogError("example-benchmark-glue") << error;
+            printUsage();
+        }
+        ofExit(error.empty() ? 0 : 1);
+        return;
+    }
+
+#ifdef DEBUG
+    ofLogWarning("example-benchmark-glue") << "This is a debug build, the timings don't reflect release builds !";
+#endif
+    if(!AllocationCounter::isCountingMalloc()){
+        ofLogNotice("example-benchmark-glue") << "Only operator new is counted on this platform, Blend2D's allocations are missing from allocs/op.";
+    }
+
+    std::printf("%-28s %10s %12s %12s %10s %10s %12s\n", "case", "items", "ns/op", "ns/item", "Mitems/s", "allocs/op", "bytes/op");
+    std::vector<Result> results;
+    auto run = [&](const std::string& name, std::size_t numItems, const std::function<void()>& operation){
+        results.push_back(measure(name, numItems, operation));
+        printResult(results.back());
+    };
+
+    const std::vector<std::size_t> itemCounts = getItemCounts(settings.maxItems);
+
+    // toBLPath(ofPath)
+    if(isEnabled("path")){
+        for(std::size_t numCommands : itemCounts){
+            const ofPath path = makeCommandsPath(numCommands);
+            run("toBLPath(ofPath)", numCommands, [&path](){
+                BLPath blPath = toBLPath(path);
+                benchmarkSink += blPath.size();
+            });
+        }
+    }
+
+    // toBLPath(ofPolyline)
+    if(isEnabled("polyline")){
+        for(std::size_t numVertices : itemCounts){
+            const ofPolyline polyline = makePolyline(numVertices);
+            run("toBLPath(ofPolyline)", numVertices, [&polyline](){
+                BLPath blPath = toBLPath(polyline);
+                benchmarkSink += blPath.size();
+            });
+        }
+    }
+
+    // toBLColor, into a preallocated array (only the conversion is measured)
+    if(isEnabled("color")){
+        for(std::size_t numColors : itemCounts){
+            std::vector<ofFloatColor> colors(numColors);
+            uint32_t state = 0xC2B2AE35u;
+            for(ofFloatColor& color : colors) color = ofFloatColor(getRandomValue(state), getRandomValue(state), getRandomValue(state), getRandomValue(state));
+            std::vector<BLRgba32> blColors(numColors);
+            run("toBLColor", numColors, [&colors, &blColors](){
+                for(std::size_t i=0; i<colors.size(); ++i) blColors[i] = toBLColor(colors[i]);
+                benchmarkSink += blColors.back().value;
+            });
+        }
+    }
+
+    // toBLPoint
+    if(isEnabled("point")){
+        for(std::size_t numPoints : itemCounts){
+            std::vector<glm::vec3> points(numPoints);
+            uint32_t state = 0x27D4EB2Fu;
+            for(glm::vec3& point : points) point = glm::vec3(getRandomValue(state), getRandomValue(state), 0.f);
+            std::vector<glm::vec2> points2D(points.begin(), points.end());
+            std::vector<BLPoint> blPoints(numPoints);
+            run("toBLPoint(vec2)", numPoints, [&points2D, &blPoints](){
+                for(std::size_t i=0; i<points2D.size(); ++i) blPoints[i] = toBLPoint(points2D[i]);
+                benchmarkSink += (uint64_t)blPoints.back().x;
+            });
+            run("toBLPoint(vec3)", numPoints, [&points, &blPoints](){
+                for(std::size_t i=0; i<points.size(); ++i) blPoints[i] = toBLPoint(points[i]);
+                benchmarkSink += (uint64_t)blPoints.back().x;
+            });
+        }
+    }
+
+    // Pixel format lookups, done for every frame by the renderer
+    if(isEnabled("format")){
+        const uint16_t formats[] = { BL_FORMAT_PRGB32, BL_FORMAT_XRGB32, BL_FORMAT_A8 };
+        const std::size_t numLookups = 1000;
+        run("blFormatToGlFormat", numLookups, [&formats, numLookups](){
+            for(std::size_t i=0; i<numLookups; ++i) benchmarkSink += blFormatToGlFormat(formats[i%3]);
+        });
+        run("GLFormat to ofPixelFormat", numLookups, [&formats, numLookups](){
+            for(std::size_t i=0; i<numLookups; ++i) benchmarkSink += ofxBlend2DGetOfPixelFormatFromGLFormat(blFormatToGlFormat(formats[i%3]));
+        });
+    }
+
+    // BLImage to ofPixels (saving and reading back frames), 1080p
+    if(isEnabled("pixels")){
+        const std::pair<BLFormat, const char*> formats[] = { {BL_FORMAT_PRGB32, "prgb32"}, {BL_FORMAT_XRGB32, "xrgb32"}, {BL_FORMAT_A8, "a8"} };
+        for(const std::pair<BLFormat, const char*>& format : formats){
+            BLImage image(1920, 1080, format.first);
+            BLImageData data;
+            if(image.get_data(&data)!=BL_SUCCESS){
+                ofLogError("example-benchmark-glue") << "Couldn't create a " << format.second << " image";
+                continue;
+            }
+            const std::size_t numPixels = (std::size_t)data.size.w*data.size.h;
+            ofPixels pixels;
+            run(std::string("ofPixels from ") + format.second, numPixels, [&data, &pixels](){
+                pixels.setFromAlignedPixels(static_cast<const uint8_t*>(data.pixel_data), data.size.w, data.size.h, ofxBlend2DGetOfPixelFormatFromGLFormat(blFormatToGlFormat(data.format)), data.stride);
+                benchmarkSink += pixels.size();
+            });
+            if(format.first!=BL_FORMAT_A8){
+                // Blend2D is BGRA, most encoders want RGBA
+                run(std::string("ofPixels swapRgb ") + format.second, numPixels, [&pixels](){
+                    pixels.swapRgb();
+                    benchmarkSink += pixels.size();
+                });
+            }
+        }
+    }
+
+    ofExit(saveReport(results) ? 0 : 1);
+}
+
+//--------------------------------------------------------------
+ofApp::Result ofApp::measure(const std::string& name, std::size_t numItems, const std::function<void()>& operation) const {
+    typedef std::chrono::steady_clock Clock;
+
+    Result result;
+    result.name = name;
+    result.numItems = numItems;
+
+    // Warmup : caches, lazy allocations and growing buffers to their final size
+    operation();
+
+    const AllocationCounter::Snapshot allocationsBefore = AllocationCounter::get();
+    const Clock::time_point beginTime = Clock::now();
+    const Clock::duration minTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(settings.minTimeMs));
+    Clock::duration elapsed = Clock::duration::zero();
+    while(result.numOperations<3 || elapsed<minTime){
+        operation();
+        ++result.numOperations;
+        elapsed = Clock::now()-beginTime;
+    }
+    const AllocationCounter::Snapshot allocationsAfter = AllocationCounter::get();
+
+    result.nsPerOperation = std::chrono::duration<double, std::nano>(elapsed).count()/result.numOperations;
+    result.allocationsPerOperation = double(allocationsAfter.count-allocationsBefore.count)/result.numOperations;
+    result.allocatedBytesPerOperation = double(allocationsAfter.bytes-allocationsBefore.bytes)/result.numOperations;
+    return result;
+}
+
+void ofApp::printResult(const Result& result) const {
+    const double nsPerItem = result.numItems>0 ? result.nsPerOperation/result.numItems : 0.0;
+    std::printf("%-28s %10zu %12.1f %12.3f %10.2f %10.2f %12.0f\n", result.name.c_str(), result.numItems, result.nsPerOperation, nsPerItem,
+        nsPerItem>0.0 ? 1000.0/nsPerItem : 0.0, result.allocationsPerOperation, result.allocatedBytesPerOperation);
+    std::fflush(stdout);
+}
+
+//--------------------------------------------------------------
+bool ofApp::isEnabled(const std::string& caseName) const {
+    return settings.cases.empty() || std::find(settings.cases.begin(), settings.cases.end(), caseName)!=settings.cases.end();
+}
+
+bool ofApp::parseArguments(std::string& error){
+    for(std::size_t i=0; i<args.size(); ++i){
+        const std::string& arg = args[i];
+        if(arg=="--help" || arg=="-h"){
+            printUsage();
+            return false;
+        }
+        // Options with a value
+        if(i+1>=args.size()){
+            error = "Missing value for " + arg;
+            return false;
+        }
+        const std::string& value = args[++i];
+        if(arg=="--cases"){
+            settings.cases = ofSplitString(ofToLower(value), ",", true, true);
+            if(settings.cases.size()==1 && settings.cases[0]=="all") settings.cases.clear();
+        }
+        else if(arg=="--max-items"){
+            const int64_t maxItems = ofToInt64(value);
+            if(maxItems<10){
+                error = "--max-items must be at least 10";
+                return false;
+            }
+            settings.maxItems = (std::size_t)maxItems;
+        }
+        else if(arg=="--min-time") settings.minTimeMs = std::max(0.0, ofToDouble(value));
+        else if(arg=="--out") settings.outputFile = value;
+        else {
+            error = "Unknown option " + arg;
+            return false;
+        }
+    }
+    return true;
+}
+
+void ofApp::printUsage(){
+    std::printf(
+        "Usage: example-benchmark-glue [options]\n"
+        "  --cases LIST      path,polyline,color,point,format,pixels (default: all)\n"
+        "  --max-items N     Largest path/array size, sizes go from 10 to N by x10 (default: 10000000)\n"
+        "                    Note: a 10M commands ofPath needs about 1GB of memory.\n"
+        "  --min-time MS     Minimum measured time per case (default: 200)\n"
+        "  --out FILE        JSON report, relative to the data folder (default: glue-benchmark.json)\n");
+}
+
+//--------------------------------------------------------------
+bool ofApp::saveReport(const std::vector<Result>& results) const {
+    ofJson report;
+#ifdef DEBUG
+    report["build"] = "debug";
+#else
+    report["build"] = "release";
+#endif
+    report["timestamp"] = ofGetTimestampString("%Y-%m-%dT%H:%M:%S");
+    report["countsMalloc"] = AllocationCounter::isCountingMalloc();
+    report["minTimeMs"] = settings.minTimeMs;
+
+    ofJson& cases = report["results"];
+    cases = ofJson::array();
+    for(const Result& result : results){
+        ofJson entry;
+        entry["case"] = result.name;
+        entry["items"] = result.numItems;
+        entry["operations"] = result.numOperations;
+        entry["nsPerOp"] = result.nsPerOperation;
+        entry["nsPerItem"] = result.numItems>0 ? result.nsPerOperation/result.numItems : 0.0;
+        entry["allocsPerOp"] = result.allocationsPerOperation;
+        entry["bytesPerOp"] = result.allocatedBytesPerOperation;
+        cases.push_back(entry);
+    }
+
+    if(!ofSavePrettyJson(settings.outputFile, report)){
+        ofLogError("example-benchmark-glue") << "Couldn't write the report to " << settings.outputFile;
+        return false;
+    }
+    ofLogNotice("example-benchmark-glue") << "Report written to " << ofToDataPath(settings.outputFile, true);
+    return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "ofMain.h"
+
+#include <functional>
+
+// Headless micro-benchmarks of the OF <-> Blend2D glue (ofxBlend2DGlue.h) : path, polyline, color and point conversions
+// from 10 to 10M items, pixel format lookups and BLImage to ofPixels copies.
+// Reports the time and the heap allocations per operation, then writes a JSON report. Doesn't need GL nor a window.
+class ofApp : public ofBaseApp{
+
+	public:
+        explicit ofApp(const std::vector<std::string>& _args) : args(_args) {};
+		void setup();
+
+        struct Settings {
+            std::vector<std::string> cases; // Empty = all
+            std::size_t maxItems = 10000000;
+            double minTimeMs = 200.0; // Per measurement
+            std::string outputFile = "glue-benchmark.json";
+        };
+
+        struct Result {
+            std::string name;
+            std::size_t numItems = 0; // Per operation
+            uint64_t numOperations = 0;
+            double nsPerOperation = 0.0;
+            double allocationsPerOperation = 0.0;
+            double allocatedBytesPerOperation = 0.0;
+        };
+
+        bool parseArguments(std::string& error);
+        static void printUsage();
+        bool isEnabled(const std::string& caseName) const;
+        // Runs operation until settings.minTimeMs elapsed (at least 3 times), after one unmeasured run
+        Result measure(const std::string& name, std::size_t numItems, const std::function<void()>& operation) const;
+        void printResult(const Result& result) const;
+        bool saveReport(const std::vector<Result>& results) const;
+
+        std::vector<std::string> args;
+        Settings settings;
+};
@@ -0,0 +1,234 @@
+#include "BenchmarkScenes.h"
+#include "ofxBlend2D.h" // GetDefaultFont()
+#include "ofxBlend2DGlue.h"
+#include "ofLog.h"
+
+#include <sstream>
+#include <cmath>
+
+// Deterministic pseudo random numbers (identical on every platform, unlike std distributions)
+struct BenchmarkRandom {
+    uint32_t state;
+    explicit BenchmarkRandom(uint32_t seed) : state(seed ? seed : 1u) {}
+    uint32_t next(){
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    // [0, 1)
+    double nextDouble(){
+        return (next() >> 8) * (1.0/16777216.0);
+    }
+};
+
+// Loops over 300 frames
+static double getLoopProgress(unsigned int frameNum){
+    return (frameNum%300)/300.0;
+}
+
+// - - - - Bezier grid
+
+bool BezierGridScene::setup(){
+    // Same shape as example-compare
+    const double shapeSize = 50;
+    const BLPoint p1(shapeSize*.1, shapeSize*.1);
+    const BLPoint p2(shapeSize*.9, shapeSize*.1);
+    const BLPoint p3(shapeSize*.9, shapeSize*.9);
+    const BLPoint p4(shapeSize*.1, shapeSize*.9);
+    const double h = shapeSize*.3;
+
+    shape.clear();
+    shape.move_to(p1.x, p1.y);
+    shape.cubic_to(p1.x+h, p1.y, p2.x, p2.y-h, p2.x, p2.y);
+    shape.cubic_to(p2.x, p2.y+h, p3.x+h, p3.y, p3.x, p3.y);
+    shape.cubic_to(p3.x-h, p3.y, p4.x, p4.y+h, p4.x, p4.y);
+    shape.cubic_to(p4.x, p4.y-h, p1.x-h, p1.y, p1.x, p1.y);
+    shape.close();
+    return true;
+}
+
+void BezierGridScene::draw(BLContext& ctx, unsigned int frameNum, int width, int height){
+    const double stepX = std::max(1.0, width/(double)cols);
+    const double stepY = std::max(1.0, height/(double)rows);
+    const double rotation = getLoopProgress(frameNum)*TWO_PI;
+    const BLRgba32 color = toBLColor(ofFloatColor::orange);
+
+    for(unsigned int posY=0; posY<rows; ++posY){
+        for(unsigned int posX=0; posX<cols; ++posX){
+            ctx.save();
+            ctx.translate(posX*stepX, posY*stepY);
+            ctx.rotate(rotation);
+            ctx.fill_path(shape, color);
+            ctx.restore();
+        }
+    }
+}
+
+// - - - - Gradient shapes
+
+void GradientShapesScene::draw(BLContext& ctx, unsigned int frameNum, int width, int height){
+    // example-simple's layout is made for 1024x768
+    ctx.scale(width/1024.0, height/768.0);
+
+    const double variation = std::sin(frameNum*0.05)*.5+.5;
+    const BLRect rect1(40, 40, 440, 440);
+
+    BLGradient linear(BLLinearGradientValues(rect1.x, rect1.y, rect1.w+rect1.x, rect1.h+rect1.x));
+    linear.add_stop(0.0, BLRgba32(0xFFFFFFFF));
+    linear.add_stop(variation, BLRgba32(0xFF5FAFDF));
+    linear.add_stop(1.0, BLRgba32(0xFF2F5FDF));
+    ctx.fill_round_rect(BLRoundRect(rect1.x, rect1.y, rect1.w, rect1.h, 45.5*variation), linear);
+
+    const BLRoundRect rect2(rect1.x*2+rect1.w, rect1.y*2+rect1.h, rect1.w, rect1.h, 45.5*variation);
+    BLGradient radial(BLRadialGradientValues(rect2.x+rect2.w*.5, rect2.y+rect2.h*.5, rect2.x+rect2.w*.5, rect2.y+rect2.h*.5, rect2.w*variation+1.0));
+    radial.add_stop(0.0, BLRgba32(0xFF00FF00));
+    radial.add_stop(1.0, BLRgba32(0xFF0000FF));
+    ctx.fill_round_rect(rect2, radial);
+    ctx.stroke_round_rect(rect2, BLRgba32(0xFF000000));
+
+    BLPath line;
+    line.move_to(119, 49);
+    line.cubic_to(259, 29, 99, 279, 275, 267);
+    line.cubic_to(537, 245, 300, -170, 274, 430);
+    ctx.save();
+    ctx.set_stroke_width(15);
+    ctx.set_stroke_start_cap(BL_STROKE_CAP_ROUND);
+    ctx.set_stroke_end_cap(BL_STROKE_CAP_BUTT);
+    ctx.translate(400, 40+variation*400);
+    ctx.stroke_path(line, toBLColor(ofFloatColor::purple));
+    ctx.restore();
+
+    ctx.save();
+    ctx.translate(rect1.x, rect1.y*2+rect1.h);
+    ctx.rotate(variation*TWO_PI);
+    ctx.fill_triangle(0, 0, 400, 0, 200, 400, toBLColor(ofFloatColor::orange));
+    ctx.restore();
+}
+
+// - - - - SVG
+
+bool SvgScene::setup(){
+    if(!filePath.empty()){
+        if(!loader.load(filePath)){
+            ofLogWarning("SvgScene") << "Couldn't load " << filePath;
+            return false;
+        }
+        return !loader.getShapes().empty();
+    }
+
+    // Generated document : overlapping paths with curves, fills and strokes
+    BenchmarkRandom random(0x5167u);
+    std::ostringstream svg;
+    svg << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"1000\" height=\"1000\" viewBox=\"0 0 1000 1000\">\n";
+    for(unsigned int i=0; i<numGeneratedShapes; ++i){
+        const double x = random.nextDouble()*1000.0;
+        const double y = random.nextDouble()*1000.0;
+        const double size = 5.0+random.nextDouble()*40.0;
+        svg << "<path d=\"M" << x << "," << y
+            << " c" << size << "," << -size*.5 << " " << size << "," << size*.5 << " " << size*.5 << "," << size
+            << " q" << -size*.5 << "," << size*.3 << " " << -size*.5 << "," << -size << " z\""
+            << " fill=\"rgb(" << (random.next()%256) << "," << (random.next()%256) << "," << (random.next()%256) << ")\""
+            << " fill-opacity=\"0.7\"";
+        if(i%4==0) svg << " stroke=\"#202020\" stroke-width=\"1.5\"";
+        svg << "/>\n";
+    }
+    svg << "</svg>\n";
+    return loader.loadFromString(svg.str()) && !loader.getShapes().empty();
+}
+
+void SvgScene::draw(BLContext& ctx, unsigned int frameNum, int width, int height){
+    // Fit the document, with a slow zoom
+    const BLSize& documentSize = loader.getDocumentSize();
+    const double docWidth = documentSize.w>0 ? documentSize.w : 1000.0;
+    const double docHeight = documentSize.h>0 ? documentSize.h : 1000.0;
+    const double zoom = 1.0+0.25*std::sin(getLoopProgress(frameNum)*TWO_PI);
+    const double scale = std::min(width/docWidth, height/docHeight)*zoom;
+    ctx.translate(width*.5, height*.5);
+    ctx.scale(scale);
+    ctx.translate(-docWidth*.5, -docHeight*.5);
+
+    for(const ofxBlend2DSvgShape& shape : loader.getShapes()){
+        shape.style.draw(ctx, shape.path);
+    }
+}
+
+// - - - - Text
+
+bool TextScene::setup(){
+#ifndef ofxBlend2D_DISABLE_DEFAULT_FONT
+    // The addon's font, if the data folder has it
+    if(ofxBlend2D::GetDefaultFont().face().is_valid()){
+        font = ofxBlend2D::GetDefaultFont();
+        return true;
+    }
+#endif
+    // System fonts
+    static const char* candidates[] = {
+        "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+        "/usr/share/fonts/TTF/DejaVuSans.ttf",
+        "/usr/share/fonts/dejavu/DejaVuSans.ttf",
+        "/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf",
+        "/usr/share/fonts/truetype/freefont/FreeSans.ttf",
+        "/System/Library/Fonts/Helvetica.ttc",
+        "C:/Windows/Fonts/arial.ttf",
+    };
+    for(const char* candidate : candidates){
+        if(fontFace.create_from_file(candidate)==BL_SUCCESS && font.create_from_face(fontFace, fontSize)==BL_SUCCESS){
+            return true;
+        }
+    }
+    ofLogWarning("TextScene") << "No font found (add data/fonts/gohufont-14.ttf), skipping the text scene.";
+    return false;
+}
+
+void TextScene::draw(BLContext& ctx, unsigned int frameNum, int width, int height){
+    static const char* lines[] = {
+        "The quick brown fox jumps over the lazy dog.",
+        "Sphinx of black quartz, judge my vow !",
+        "0123456789 +-*/=<>()[]{} @#$%&",
+        "Blend2D renders text with its own rasterizer.",
+    };
+    const BLFontMetrics metrics = font.metrics();
+    const double lineHeight = std::max(1.0, (double)(metrics.ascent+metrics.descent+metrics.line_gap));
+    const double offset = getLoopProgress(frameNum)*lineHeight*4.0; // Scrolling
+
+    const BLRgba32 colors[] = { BLRgba32(0xFF202020), BLRgba32(0xFF2F5FDF), BLRgba32(0xFFDF5F2F) };
+    unsigned int lineIndex = 0;
+    for(double y=lineHeight-offset; y<height+lineHeight; y+=lineHeight, ++lineIndex){
+        const char* text = lines[lineIndex%4];
+        // Repeat the line over the width
+        for(double x=(lineIndex%3)*-30.0; x<width; x+=fontSize*30.0){
+            ctx.fill_utf8_text(BLPoint(x, y), font, text, SIZE_MAX, colors[lineIndex%3]);
+        }
+    }
+}
+
+// - - - - Particles
+
+void ParticlesScene::draw(BLContext& ctx, unsigned int frameNum, int width, int height){
+    BenchmarkRandom random(0xC10Du);
+    const double time = getLoopProgress(frameNum)*TWO_PI;
+    for(unsigned int i=0; i<numParticles; ++i){
+        // Each particle orbits around its own center
+        const double cx = random.nextDouble()*width;
+        const double cy = random.nextDouble()*height;
+        const double orbit = 5.0+random.nextDouble()*30.0;
+        const double phase = random.nextDouble()*TWO_PI;
+        const double radius = 1.0+random.nextDouble()*4.0;
+        const uint32_t color = random.next();
+        ctx.fill_circle(cx+std::cos(time+phase)*orbit, cy+std::sin(time+phase)*orbit, radius, BLRgba32((color & 0x00FFFFFFu) | 0x80000000u));
+    }
+}
+
+// - - - -
+
+std::vector<std::unique_ptr<BenchmarkScene> > createBenchmarkScenes(const std::string& svgFile){
+    std::vector<std::unique_ptr<BenchmarkScene> > scenes;
+    scenes.emplace_back(new BezierGridScene());
+    scenes.emplace_back(new GradientShapesScene());
+    scenes.emplace_back(new SvgScene(svgFile));
+    scenes.emplace_back(new TextScene());
+    scenes.emplace_back(new ParticlesScene());
+    return scenes;
+}
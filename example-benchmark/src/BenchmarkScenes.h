@@ -0,0 +1,87 @@
+#pragma once
+
+#include "blend2d/blend2d.h"
+#include "ofxBlend2DSvg.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Benchmark scenes
+// - - - -
+// Representative workloads, drawn straight into a BLContext (no window, no GL).
+// Scenes only depend on the frame number and the canvas size, so the output checksums can be compared between builds and machines.
+
+class BenchmarkScene {
+    public:
+        virtual ~BenchmarkScene() = default;
+
+        virtual const char* getName() const = 0;
+        // Loads resources (paths, fonts), returns false when the scene can't run here (it's then skipped)
+        virtual bool setup() { return true; }
+        // The canvas is cleared before each frame
+        virtual void draw(BLContext& ctx, unsigned int frameNum, int width, int height) = 0;
+};
+
+// The bezier shape grid from example-compare
+class BezierGridScene : public BenchmarkScene {
+    public:
+        const char* getName() const override { return "bezier-grid"; }
+        bool setup() override;
+        void draw(BLContext& ctx, unsigned int frameNum, int width, int height) override;
+
+        unsigned int cols = 100;
+        unsigned int rows = 100;
+
+    protected:
+        BLPath shape;
+};
+
+// The gradient shapes from example-simple
+class GradientShapesScene : public BenchmarkScene {
+    public:
+        const char* getName() const override { return "gradients"; }
+        void draw(BLContext& ctx, unsigned int frameNum, int width, int height) override;
+};
+
+// Paths loaded by ofxBlend2DSvgLoader, from a file or a generated document
+class SvgScene : public BenchmarkScene {
+    public:
+        explicit SvgScene(const std::string& _filePath="") : filePath(_filePath) {}
+        const char* getName() const override { return "svg"; }
+        bool setup() override;
+        void draw(BLContext& ctx, unsigned int frameNum, int width, int height) override;
+
+        // Shapes of the generated document (when no file is given)
+        unsigned int numGeneratedShapes = 5000;
+
+    protected:
+        std::string filePath;
+        ofxBlend2DSvgLoader loader;
+};
+
+// Lines of text covering the canvas
+class TextScene : public BenchmarkScene {
+    public:
+        const char* getName() const override { return "text"; }
+        bool setup() override;
+        void draw(BLContext& ctx, unsigned int frameNum, int width, int height) override;
+
+        float fontSize = 14.f;
+
+    protected:
+        BLFontFace fontFace;
+        BLFont font;
+};
+
+// Many small translucent circles
+class ParticlesScene : public BenchmarkScene {
+    public:
+        const char* getName() const override { return "particles"; }
+        void draw(BLContext& ctx, unsigned int frameNum, int width, int height) override;
+
+        unsigned int numParticles = 50000;
+};
+
+// All scenes, in report order
+std::vector<std::unique_ptr<BenchmarkScene> > createBenchmarkScenes(const std::string& svgFile="");
@@ -0,0 +1,13 @@
+#include "ofMain.h"
+#include "ofApp.h"
+#include "ofAppNoWindow.h"
+
+//========================================================================
+int main(int argc, char* argv[]){
+    std::vector<std::string> args(argv+1, argv+argc);
+
+    // No window nor GL context : runs on GPU-less machines
+    auto window = std::make_shared<ofAppNoWindow>();
+    ofRunApp(window, std::make_shared<ofApp>(args));
+    return ofRunMainLoop();
+}
@@ -0,0 +1,426 @@
+#include "ofApp.h"
+#include "ofxBlend2DGlue.h"
+#include "ofxBlend2DUtils.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <algorithm>
+#include <sstream>
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+    std::string error;
+    if(!parseArguments(error)){
+        if(!error.empty()){
+            ofLogError("example-benchmark") << error;
+            printUsage();
+        }
+        ofExit(error.empty() ? 0 : 1);
+        return;
+    }
+
+#ifdef DEBUG
+    ofLogWarning("example-benchmark") << "This is a debug build, Blend2D is a lot slower than in release builds !";
+#endif
+
+    // Scenes
+    std::vector<std::unique_ptr<BenchmarkScene> > scenes = createBenchmarkScenes(settings.svgFile);
+    if(!settings.scenes.empty()){
+        scenes.erase(std::remove_if(scenes.begin(), scenes.end(), [this](const std::unique_ptr<BenchmarkScene>& scene){
+            return std::find(settings.scenes.begin(), settings.scenes.end(), scene->getName())==settings.scenes.end();
+        }), scenes.end());
+    }
+
+    // Context settings of each run : the presets, or every thread count and JIT mode
+    std::vector<std::pair<ofxBlend2DContextConfig, std::string> > contextConfigs;
+    for(ofxBlend2DContextConfig::Preset preset : settings.presets){
+        contextConfigs.emplace_back(ofxBlend2DContextConfig::fromPreset(preset), ofxBlend2DContextConfig::getPresetName(preset));
+    }
+    if(settings.presets.empty()){
+        for(uint32_t threadCount : settings.threadCounts)
+        for(bool jit : settings.jitModes){
+            ofxBlend2DContextConfig contextConfig;
+            contextConfig.threadCount = threadCount;
+            contextConfig.bDisableJit = !jit;
+            contextConfigs.emplace_back(contextConfig, "");
+        }
+    }
+
+    std::printf("%-12s %11s %-7s %-10s %7s %4s %9s %9s %9s %8s %8s  %-16s\n", "scene", "size", "format", "preset", "threads", "jit", "p50 ms", "p95 ms", "max ms", "fps", "rss MB", "checksum");
+    std::vector<Result> results;
+    bool bFailed = false;
+    for(std::unique_ptr<BenchmarkScene>& scene : scenes){
+        if(!scene->setup()){
+            ofLogWarning("example-benchmark") << "Skipping scene " << scene->getName();
+            continue;
+        }
+        for(const std::pair<int, int>& size : settings.sizes)
+        for(BLFormat format : settings.formats)
+        for(const std::pair<ofxBlend2DContextConfig, std::string>& contextConfig : contextConfigs){
+            results.push_back(runBenchmark(*scene, size.first, size.second, format, contextConfig.first, contextConfig.second));
+            const Result& result = results.back();
+            bFailed |= result.bFailed;
+
+            std::vector<double> frameMs = result.frameMs;
+            std::sort(frameMs.begin(), frameMs.end());
+            const double p50 = frameMs.empty() ? 0.0 : frameMs[frameMs.size()/2];
+            const double p95 = frameMs.empty() ? 0.0 : frameMs[std::min(frameMs.size()-1, frameMs.size()*95/100)];
+            const double max = frameMs.empty() ? 0.0 : frameMs.back();
+            std::printf("%-12s %5dx%-5d %-7s %-10s %7u %4s %9.3f %9.3f %9.3f %8.1f %8.1f  %016llx%s\n", result.scene.c_str(), result.width, result.height, getFormatName(result.format),
+                result.preset.empty() ? "-" : result.preset.c_str(), result.threadCount, result.jit ? "on" : "off", p50, p95, max, p50>0.0 ? 1000.0/p50 : 0.0, result.rssGrowthMb,
+                (unsigned long long)result.checksum, result.bFailed ? "  FAILED" : "");
+            std::fflush(stdout);
+        }
+    }
+
+    if(!settings.presets.empty()){
+        const ofJson summary = getPresetSummary(results);
+        std::printf("\nPresets (median over runs, relative to %s) :\n", ofxBlend2DContextConfig::getPresetName(settings.presets.front()));
+        for(const ofJson& preset : summary){
+            std::printf("%-10s frame %6.2fx  flush %6.2fx  rss %+8.1f MB  (%s)\n", preset["preset"].get<std::string>().c_str(), preset["frameRatio"].get<double>(),
+                preset["flushRatio"].get<double>(), preset["rssGrowthDeltaMb"].get<double>(), preset["contextConfig"].get<std::string>().c_str());
+        }
+    }
+
+    if(!saveReport(results)) bFailed = true;
+    ofExit(bFailed ? 1 : 0);
+}
+
+//--------------------------------------------------------------
+// Comma separated values
+static std::vector<std::string> splitList(const std::string& value){
+    std::vector<std::string> items = ofSplitString(value, ",", true, true);
+    for(std::string& item : items) item = ofToLower(item);
+    return items;
+}
+
+bool ofApp::parseArguments(std::string& error){
+    for(std::size_t i=0; i<args.size(); ++i){
+        const std::string& arg = args[i];
+        if(arg=="--help" || arg=="-h"){
+            printUsage();
+            return false;
+        }
+        if(arg=="--save-images"){
+            settings.bSaveImages = true;
+            continue;
+        }
+        // Options with a value
+        if(i+1>=args.size()){
+            error = "Missing value for " + arg;
+            return false;
+        }
+        const std::string& value = args[++i];
+        if(arg=="--scenes"){
+            settings.scenes = splitList(value);
+            if(settings.scenes.size()==1 && settings.scenes[0]=="all") settings.scenes.clear();
+        }
+        else if(arg=="--sizes"){
+            settings.sizes.clear();
+            for(const std::string& item : splitList(value)){
+                const std::vector<std::string> dimensions = ofSplitString(item, "x");
+                const int width = dimensions.size()==2 ? ofToInt(dimensions[0]) : 0;
+                const int height = dimensions.size()==2 ? ofToInt(dimensions[1]) : 0;
+                if(width<=0 || height<=0){
+                    error = "Invalid size \"" + item + "\", use WIDTHxHEIGHT";
+                    return false;
+                }
+                settings.sizes.emplace_back(width, height);
+            }
+        }
+        else if(arg=="--formats"){
+            settings.formats.clear();
+            for(const std::string& item : splitList(value)){
+                if(item=="prgb32") settings.formats.push_back(BL_FORMAT_PRGB32);
+                else if(item=="xrgb32") settings.formats.push_back(BL_FORMAT_XRGB32);
+                else if(item=="a8") settings.formats.push_back(BL_FORMAT_A8);
+                else {
+                    error = "Unknown format \"" + item + "\"";
+                    return false;
+                }
+            }
+        }
+        else if(arg=="--threads"){
+            settings.threadCounts.clear();
+            for(const std::string& item : splitList(value)){
+                settings.threadCounts.push_back((uint32_t)std::max(0, ofToInt(item)));
+            }
+        }
+        else if(arg=="--jit"){
+            settings.jitModes.clear();
+            for(const std::string& item : splitList(value)){
+                if(item=="on" || item=="off") settings.jitModes.push_back(item=="on");
+                else {
+                    error = "Unknown JIT mode \"" + item + "\", use on,off";
+                    return false;
+                }
+            }
+        }
+        else if(arg=="--presets"){
+            settings.presets.clear();
+            for(const std::string& item : splitList(value)){
+                ofxBlend2DContextConfig::Preset preset;
+                if(item=="all"){
+                    for(uint8_t i=0; i<ofxBlend2DContextConfig::NumPresets; ++i) settings.presets.push_back((ofxBlend2DContextConfig::Preset)i);
+                }
+                else if(ofxBlend2DContextConfig::getPresetFromName(item, preset)) settings.presets.push_back(preset);
+                else {
+                    error = "Unknown preset \"" + item + "\", use default,latency,throughput,memory";
+                    return false;
+                }
+            }
+        }
+        else if(arg=="--frames") settings.numFrames = std::max(1, ofToInt(value));
+        else if(arg=="--warmup") settings.numWarmupFrames = std::max(0, ofToInt(value));
+        else if(arg=="--svg") settings.svgFile = value;
+        else if(arg=="--out") settings.outputFile = value;
+        else {
+            error = "Unknown option " + arg;
+            return false;
+        }
+    }
+    if(settings.sizes.empty() || settings.formats.empty() || settings.threadCounts.empty() || settings.jitModes.empty()){
+        error = "Nothing to run, the sizes, formats, threads and jit lists can't be empty.";
+        return false;
+    }
+    return true;
+}
+
+void ofApp::printUsage(){
+    std::printf(
+        "Usage: example-benchmark [options]\n"
+        "  --scenes LIST    bezier-grid,gradients,svg,text,particles (default: all)\n"
+        "  --sizes LIST     Canvas sizes (default: 640x360,1280x720,1920x1080)\n"
+        "  --formats LIST   prgb32,xrgb32,a8 (default: prgb32)\n"
+        "  --threads LIST   Blend2D worker threads, 0 = synchronous (default: 0,2,4)\n"
+        "  --jit LIST       on,off (default: on,off)\n"
+        "  --presets LIST   default,latency,throughput,memory or all : context presets instead of --threads and --jit,\n"
+        "                   compared to the first one. Run them separately for exact memory growth (freed memory is reused)\n"
+        "  --frames N       Measured frames per run (default: 60)\n"
+        "  --warmup N       Unmeasured frames per run (default: 5)\n"
+        "  --svg FILE       SVG file for the svg scene (default: a generated document)\n"
+        "  --out FILE       JSON report, relative to the data folder (default: benchmark.json)\n"
+        "  --save-images    Saves the last frame of each run as PNG\n");
+}
+
+//--------------------------------------------------------------
+ofApp::Result ofApp::runBenchmark(BenchmarkScene& scene, int width, int height, BLFormat format, const ofxBlend2DContextConfig& contextConfig, const std::string& preset){
+    typedef std::chrono::steady_clock Clock;
+    auto toMs = [](Clock::duration duration){ return std::chrono::duration<double, std::milli>(duration).count(); };
+
+    Result result;
+    result.scene = scene.getName();
+    result.width = width;
+    result.height = height;
+    result.format = format;
+    result.threadCount = contextConfig.threadCount;
+    result.jit = !contextConfig.bDisableJit;
+    result.preset = preset;
+    result.contextConfig = contextConfig.getDescription();
+
+    const BLContextCreateInfo createInfo = contextConfig.toCreateInfo();
+    const uint64_t baseRss = ofxBlend2D::GetResidentBytes(); // The canvas is part of the growth
+    uint64_t peakRss = baseRss;
+
+    // One canvas per run, reused by all frames (like the renderer's pool)
+    BLImage canvas(width, height, format);
+    result.frameMs.reserve(settings.numFrames);
+    result.submitMs.reserve(settings.numFrames);
+    result.flushMs.reserve(settings.numFrames);
+
+    const unsigned int numFrames = settings.numWarmupFrames+settings.numFrames;
+    for(unsigned int frame=0; frame<numFrames; ++frame){
+        // Measured frames are always 0 to numFrames-1, so the checksums only depend on the frame count
+        const unsigned int frameNum = frame<settings.numWarmupFrames ? settings.numFrames+frame : frame-settings.numWarmupFrames;
+
+        const Clock::time_point beginTime = Clock::now();
+        BLContext ctx;
+        const BLResult blResult = ctx.begin(canvas, createInfo);
+        if(blResult!=BL_SUCCESS){
+            ofLogError("example-benchmark") << "Couldn't create the context : " << blResultToString(blResult);
+            result.bFailed = true;
+            return result;
+        }
+        ctx.clear_all();
+        scene.draw(ctx, frameNum, width, height);
+        const Clock::time_point submitTime = Clock::now();
+        ctx.flush(BL_CONTEXT_FLUSH_SYNC);
+        // The context's memory peaks before end() releases it (not timed)
+        const Clock::time_point rssBeginTime = Clock::now();
+        peakRss = std::max(peakRss, ofxBlend2D::GetResidentBytes());
+        const Clock::duration rssDuration = Clock::now()-rssBeginTime;
+        result.contextErrorFlags |= ctx.accumulated_error_flags();
+        ctx.end();
+        const Clock::time_point endTime = Clock::now();
+
+        if(frame<settings.numWarmupFrames) continue;
+        result.submitMs.push_back(toMs(submitTime-beginTime));
+        result.flushMs.push_back(toMs(endTime-submitTime-rssDuration));
+        result.frameMs.push_back(toMs(endTime-beginTime-rssDuration));
+    }
+    result.rssGrowthMb = (peakRss-baseRss)/(1024.0*1024.0);
+
+    result.checksum = getChecksum(canvas);
+    if(result.contextErrorFlags!=0){
+        ofLogWarning("example-benchmark") << result.scene << " : context errors (flags=" << result.contextErrorFlags << ")";
+    }
+
+    if(settings.bSaveImages){
+        BLImageData data;
+        ofPixels pixels;
+        const std::string fileName = "benchmark_" + result.scene + "_" + ofToString(width) + "x" + ofToString(height) + "_" + getFormatName(format) +
+            (preset.empty() ? "_t" + ofToString(result.threadCount) + (result.jit ? "_jit" : "_nojit") : "_" + preset) + ".png";
+        if(canvas.get_data(&data)!=BL_SUCCESS ||
+           !toOfPixels(data, pixels) ||
+           !ofSaveImage(pixels, fileName)){
+            ofLogWarning("example-benchmark") << "Couldn't save " << fileName;
+        }
+    }
+    return result;
+}
+
+//--------------------------------------------------------------
+// FNV-1a over the visible pixels (row padding excluded)
+uint64_t ofApp::getChecksum(const BLImage& image){
+    BLImageData data;
+    if(image.get_data(&data)!=BL_SUCCESS) return 0;
+    const std::size_t rowSize = (std::size_t)data.size.w * (data.format==BL_FORMAT_A8 ? 1 : 4);
+    uint64_t hash = 14695981039346656037ull;
+    for(int y=0; y<data.size.h; ++y){
+        const uint8_t* row = static_cast<const uint8_t*>(data.pixel_data) + y*data.stride;
+        for(std::size_t x=0; x<rowSize; ++x){
+            hash ^= row[x];
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+const char* ofApp::getFormatName(BLFormat format){
+    switch(format){
+        case BL_FORMAT_PRGB32: return "prgb32";
+        case BL_FORMAT_XRGB32: return "xrgb32";
+        case BL_FORMAT_A8: return "a8";
+        default: return "unknown";
+    }
+}
+
+//--------------------------------------------------------------
+static ofJson getStats(std::vector<double> values){
+    ofJson stats;
+    if(values.empty()) return stats;
+    std::sort(values.begin(), values.end());
+    double sum = 0.0;
+    for(double value : values) sum += value;
+    auto percentile = [&values](double p){ return values[std::min(values.size()-1, (std::size_t)(p*values.size()))]; };
+    stats["min"] = values.front();
+    stats["mean"] = sum/values.size();
+    stats["p50"] = percentile(.50);
+    stats["p95"] = percentile(.95);
+    stats["p99"] = percentile(.99);
+    stats["max"] = values.back();
+    return stats;
+}
+
+// Runs of the same scene, size and format are compared to the first preset's.
+// Frame times (submit + flush) are the ones to compare : synchronous contexts (ex: the memory preset) rasterize while submitting, their flush is near 0.
+ofJson ofApp::getPresetSummary(const std::vector<Result>& results) const {
+    auto isSameRun = [](const Result& a, const Result& b){
+        return a.scene==b.scene && a.width==b.width && a.height==b.height && a.format==b.format;
+    };
+    const std::string referencePreset = settings.presets.empty() ? "" : ofxBlend2DContextConfig::getPresetName(settings.presets.front());
+
+    ofJson summary = ofJson::array();
+    for(ofxBlend2DContextConfig::Preset preset : settings.presets){
+        const std::string name = ofxBlend2DContextConfig::getPresetName(preset);
+        std::vector<double> frameMs, frameRatios, flushMs, flushRatios, rssGrowthMb, rssGrowthDeltaMb;
+        for(const Result& result : results){
+            if(result.preset!=name || result.bFailed) continue;
+            frameMs.push_back(ofxBlend2D::GetMedian(result.frameMs));
+            flushMs.push_back(ofxBlend2D::GetMedian(result.flushMs));
+            rssGrowthMb.push_back(result.rssGrowthMb);
+            for(const Result& reference : results){
+                if(reference.preset!=referencePreset || reference.bFailed || !isSameRun(reference, result)) continue;
+                const double referenceFrameMs = ofxBlend2D::GetMedian(reference.frameMs);
+                if(referenceFrameMs>0.0) frameRatios.push_back(frameMs.back()/referenceFrameMs);
+                const double referenceFlushMs = ofxBlend2D::GetMedian(reference.flushMs);
+                if(referenceFlushMs>0.0) flushRatios.push_back(flushMs.back()/referenceFlushMs);
+                rssGrowthDeltaMb.push_back(result.rssGrowthMb-reference.rssGrowthMb);
+            }
+        }
+        ofJson entry;
+        entry["preset"] = name;
+        entry["contextConfig"] = ofxBlend2DContextConfig::fromPreset(preset).getDescription();
+        entry["runs"] = frameMs.size();
+        entry["frameP50Ms"] = ofxBlend2D::GetMedian(frameMs);
+        entry["frameRatio"] = ofxBlend2D::GetMedian(frameRatios);
+        entry["flushP50Ms"] = ofxBlend2D::GetMedian(flushMs);
+        entry["flushRatio"] = ofxBlend2D::GetMedian(flushRatios);
+        entry["rssGrowthMb"] = ofxBlend2D::GetMedian(rssGrowthMb);
+        entry["rssGrowthDeltaMb"] = ofxBlend2D::GetMedian(rssGrowthDeltaMb);
+        summary.push_back(entry);
+    }
+    return summary;
+}
+
+bool ofApp::saveReport(const std::vector<Result>& results) const {
+    ofJson report;
+
+    // Where it ran, to compare builds and machines
+    ofJson& system = report["system"];
+    system["blend2dVersion"] = ofToString(BL_VERSION >> 16) + "." + ofToString((BL_VERSION >> 8) & 0xFF) + "." + ofToString(BL_VERSION & 0xFF);
+    system["hardwareConcurrency"] = std::thread::hardware_concurrency();
+#ifdef DEBUG
+    system["build"] = "debug";
+#else
+    system["build"] = "release";
+#endif
+#if defined(TARGET_LINUX)
+    system["platform"] = "linux";
+#elif defined(TARGET_OSX)
+    system["platform"] = "osx";
+#elif defined(TARGET_WIN32)
+    system["platform"] = "windows";
+#else
+    system["platform"] = "other";
+#endif
+    system["timestamp"] = ofGetTimestampString("%Y-%m-%dT%H:%M:%S");
+
+    report["frames"] = settings.numFrames;
+    report["warmupFrames"] = settings.numWarmupFrames;
+    if(!settings.presets.empty()) report["presets"] = getPresetSummary(results);
+
+    ofJson& runs = report["results"];
+    runs = ofJson::array();
+    for(const Result& result : results){
+        std::ostringstream checksum;
+        checksum << std::hex << std::setw(16) << std::setfill('0') << result.checksum;
+
+        ofJson run;
+        run["scene"] = result.scene;
+        run["width"] = result.width;
+        run["height"] = result.height;
+        run["format"] = getFormatName(result.format);
+        run["threads"] = result.threadCount;
+        run["jit"] = result.jit;
+        if(!result.preset.empty()) run["preset"] = result.preset;
+        run["contextConfig"] = result.contextConfig;
+        run["rssGrowthMb"] = result.rssGrowthMb;
+        run["failed"] = result.bFailed;
+        run["contextErrorFlags"] = result.contextErrorFlags;
+        run["checksum"] = checksum.str();
+        run["frameMs"] = getStats(result.frameMs);
+        run["submitMs"] = getStats(result.submitMs);
+        run["flushMs"] = getStats(result.flushMs);
+        run["frames"] = result.frameMs; // Every measured frame, in order
+        runs.push_back(run);
+    }
+
+    if(!ofSavePrettyJson(settings.outputFile, report)){
+        ofLogError("example-benchmark") << "Couldn't write the report to " << settings.outputFile;
+        return false;
+    }
+    ofLogNotice("example-benchmark") << "Report written to " << ofToDataPath(settings.outputFile, true);
+    return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "ofMain.h"
+#include "BenchmarkScenes.h"
+#include "ofxBlend2DContextConfig.h"
+
+// Headless benchmark : runs every scene for each combination of canvas size, pixel format, thread count and JIT mode
+// (or context presets), then prints a summary and writes a JSON report (per frame timings, percentiles, memory, output checksums).
+// Doesn't use GL nor ofxBlend2DThreadedRenderer : frames are rendered synchronously, so the timings only include Blend2D.
+class ofApp : public ofBaseApp{
+
+	public:
+        explicit ofApp(const std::vector<std::string>& _args) : args(_args) {};
+		void setup();
+
+        struct Settings {
+            std::vector<std::string> scenes; // Empty = all
+            std::vector<std::pair<int, int> > sizes = { {640, 360}, {1280, 720}, {1920, 1080} };
+            std::vector<BLFormat> formats = { BL_FORMAT_PRGB32 };
+            std::vector<uint32_t> threadCounts = { 0, 2, 4 };
+            std::vector<bool> jitModes = { true, false };
+            std::vector<ofxBlend2DContextConfig::Preset> presets; // Replaces the thread counts and JIT modes when set
+            unsigned int numFrames = 60;
+            unsigned int numWarmupFrames = 5;
+            std::string svgFile; // Empty = generated document
+            std::string outputFile = "benchmark.json";
+            bool bSaveImages = false;
+        };
+
+        struct Result {
+            std::string scene;
+            int width = 0;
+            int height = 0;
+            BLFormat format = BL_FORMAT_PRGB32;
+            uint32_t threadCount = 0;
+            bool jit = true;
+            std::string preset; // Empty without presets
+            std::string contextConfig;
+            std::vector<double> submitMs; // Per frame
+            std::vector<double> flushMs;
+            std::vector<double> frameMs;
+            double rssGrowthMb = 0.0; // Peak resident memory growth during the run (context buffers, worker threads)
+            uint32_t contextErrorFlags = 0; // Accumulated over all frames
+            uint64_t checksum = 0; // Of the last frame
+            bool bFailed = false;
+        };
+
+        bool parseArguments(std::string& error);
+        static void printUsage();
+        Result runBenchmark(BenchmarkScene& scene, int width, int height, BLFormat format, const ofxBlend2DContextConfig& contextConfig, const std::string& preset="");
+        // Each preset's frame time (submit + flush), flush time and memory, relative to the first preset on the same runs
+        ofJson getPresetSummary(const std::vector<Result>& results) const;
+        bool saveReport(const std::vector<Result>& results) const;
+
+        static uint64_t getChecksum(const BLImage& image);
+        static const char* getFormatName(BLFormat format);
+
+        std::vector<std::string> args;
+        Settings settings;
+};
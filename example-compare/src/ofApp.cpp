@@ -10,6 +10,9 @@ void ofApp::setup(){
     // Gui Setup
     gui.setup();
     gui.add( useBlend2DForRendering.setup("Render using ofxBlend2D", true) );
+    gui.add( useOfApiWithBlend2D.setup("Use OF draw calls (ofxBlend2DRenderer)", false) );
+    gui.add( useParallelSubmission.setup("Submit from multiple threads", false) );
+    gui.add( useParallelSubContexts.setup("Rasterize in sub-contexts", false) );
     gui.add( numThreads.setup("Blend2D threads", 4, 1, 16) );
     gui.add( cols.setup("Columns", 20, 1, 5000) );
     gui.add( rows.setup("Rows", 20, 1, 5000) );
@@ -23,6 +26,7 @@ void ofApp::setup(){
 
     // Blend2D setup
     blend2d.allocate(ofGetWidth(), ofGetHeight(), GL_RGBA); // RGBA to stay identical to OF renderer
+    blRenderer = std::make_shared<ofxBlend2DRenderer>();
 
     // Define shape
     const double shapeSize = 50;
@@ -46,6 +50,11 @@ void ofApp::setup(){
     blShape.cubic_to(h3o.x, h3o.y, h4i.x, h4i.y, p4.x, p4.y);
     blShape.cubic_to(h4o.x, h4o.y, h1i.x, h1i.y, p1.x, p1.y);
     blShape.close();
+    // Furthest point from the shape's origin (it rotates around it)
+    BLBox shapeBox;
+    if(blShape.get_bounding_box(&shapeBox)==BL_SUCCESS){
+        blShapeRadius = std::ceil(glm::length(glm::dvec2(std::max(std::abs(shapeBox.x0), std::abs(shapeBox.x1)), std::max(std::abs(shapeBox.y0), std::abs(shapeBox.y1)))));
+    }
 
     ofShape.setFilled(true);
     ofFloatColor ofCol = (const ofColor) shapeColor;
@@ -108,20 +117,42 @@ void ofApp::draw(){
             // Get the context
             BLContext ctx = blend2d.getBlContext();
             ctx.set_comp_op(BL_COMP_OP_SRC_OVER); // match OF's comp mode
-            auto blColor = toBLColor(ofFloatColor((const ofColor) shapeColor));
-            // Draw shapes
-            for(unsigned int posY=0; posY<rows; posY+=1){
-                if(posY > 0) ctx.translate(0, stepY);
-                for(unsigned int posX=0; posX<cols; posX+=1){
-                    if(posX==0){
-                        if(posY != 0) ctx.translate(-1.0*((cols-1)*stepX), 0);
-                    }
-                    else ctx.translate(stepX, 0);
 
-                    // Draw the shape !
-                    if(doAnimate) ctx.rotate(loopProgress*TWO_PI);
-                    ctx.fill_path(blShape, blColor);
-                    if(doAnimate) ctx.rotate(loopProgress*TWO_PI*-1);
+            if(useOfApiWithBlend2D){
+                // Same OF code as below, rasterized by Blend2D
+                ofxBlend2DBeginRenderer(blRenderer, ctx);
+                drawShapesOF(stepX, stepY, loopProgress);
+                ofxBlend2DEndRenderer();
+            }
+            else {
+                const BLRgba32 blColor = toBLColor(ofFloatColor((const ofColor) shapeColor));
+                const unsigned int numRows = rows;
+                const unsigned int numCols = cols;
+                const float rotation = doAnimate ? loopProgress*TWO_PI : 0.f;
+
+                if(useParallelSubmission){
+                    // Bands of rows, one job each, merged in order
+                    const std::size_t numJobs = std::min<std::size_t>(numRows, std::max(1u, std::thread::hardware_concurrency()));
+                    auto bandStart = [numRows, numJobs](std::size_t job){ return (unsigned int)(job*numRows/numJobs); };
+                    if(useParallelSubContexts){
+                        // Each band's canvas only covers its rows (and the shapes overflowing them)
+                        const int margin = (int)blShapeRadius;
+                        parallelSubmitter.submitLayered(ctx, numJobs, [&](BLContext& subCtx, std::size_t job){
+                            drawShapesBL(subCtx, bandStart(job), bandStart(job+1), numCols, stepX, stepY, rotation, blColor);
+                        }, [&](std::size_t job){
+                            const int y0 = (int)(bandStart(job)*stepY)-margin;
+                            const int y1 = (int)(bandStart(job+1)*stepY)+margin;
+                            return BLRectI(0, y0, ofGetWidth(), y1-y0);
+                        });
+                    }
+                    else {
+                        parallelSubmitter.submitRecorded(ctx, numJobs, [&](ofxBlend2DCommandBuffer& cmd, std::size_t job){
+                            drawShapesBL(cmd, bandStart(job), bandStart(job+1), numCols, stepX, stepY, rotation, blColor);
+                        });
+                    }
+                }
+                else {
+                    drawShapesBL(ctx, 0, numRows, numCols, stepX, stepY, rotation, blColor);
                 }
             }
 
@@ -168,27 +199,7 @@ void ofApp::draw(){
         TS_SCOPE("OpenFrameworks/SubmitGeometry");
         TSGL_START("OpenFrameworks/DrawGeometry(GPU)");
 
-        ofPushStyle();
-        ofFill();
-        ofShape.setColor(shapeColor);
-        ofPushMatrix();
-
-        for(unsigned int posY=0; posY<rows; posY+=1){
-            if(posY > 0) ofTranslate(0, stepY);
-            for(unsigned int posX=0; posX<cols; posX+=1){
-                if(posX==0){
-                    if(posY != 0) ofTranslate(-1.0*((cols-1)*stepX), 0);
-                }
-                else ofTranslate(stepX, 0);
-
-                if(doAnimate) ofRotateRad(loopProgress*TWO_PI);
-                ofShape.draw();
-                if(doAnimate) ofRotateRad(loopProgress*TWO_PI*-1);
-            }
-        }
-
-        ofPopMatrix();
-        ofPopStyle();
+        drawShapesOF(stepX, stepY, loopProgress);
 
         TSGL_STOP("OpenFrameworks/DrawGeometry(GPU)");
 
@@ -224,6 +235,10 @@ void ofApp::draw(){
     yPos+=10;
     ofDrawBitmapStringHighlight( ofToString("       Blend2D FPS = ")+blRendererFps.toString(), {20,yPos+=20});
     ofDrawBitmapStringHighlight( ofToString("OpenFrameworks FPS = ")+ofToString(ofGetFrameRate()), {20, yPos+=20});
+    if(useBlend2DForRendering && useParallelSubmission && !useOfApiWithBlend2D){
+        const ofxBlend2DParallelSubmitter::Stats& stats = parallelSubmitter.getStats();
+        ofDrawBitmapStringHighlight( ofToString("   Parallel submit = ")+ofToString(stats.numJobs)+" jobs in "+ofToString(stats.jobsTimeMs, 2)+" ms, merged in "+ofToString(stats.mergeTimeMs, 2)+" ms", {20, yPos+=20});
+    }
     yPos+=10;
     ofDrawBitmapStringHighlight( "Press space to record 1 frame as a PNG file in the data folder.", {20, yPos+=20});
 
@@ -237,6 +252,51 @@ void ofApp::draw(){
 
 }
 
+//--------------------------------------------------------------
+void ofApp::drawShapesOF(unsigned int stepX, unsigned int stepY, float loopProgress){
+    ofPushStyle();
+    ofFill();
+    ofShape.setColor(shapeColor);
+    ofPushMatrix();
+
+    for(unsigned int posY=0; posY<rows; posY+=1){
+        if(posY > 0) ofTranslate(0, stepY);
+        for(unsigned int posX=0; posX<cols; posX+=1){
+            if(posX==0){
+                if(posY != 0) ofTranslate(-1.0*((cols-1)*stepX), 0);
+            }
+            else ofTranslate(stepX, 0);
+
+            if(doAnimate) ofRotateRad(loopProgress*TWO_PI);
+            ofShape.draw();
+            if(doAnimate) ofRotateRad(loopProgress*TWO_PI*-1);
+        }
+    }
+
+    ofPopMatrix();
+    ofPopStyle();
+}
+
+//--------------------------------------------------------------
+template<typename ContextT>
+void ofApp::drawShapesBL(ContextT& ctx, unsigned int rowStart, unsigned int rowEnd, unsigned int numCols, unsigned int stepX, unsigned int stepY, float rotation, const BLRgba32& color) const {
+    if(rowStart > 0) ctx.translate(0, rowStart*stepY);
+    for(unsigned int posY=rowStart; posY<rowEnd; posY+=1){
+        if(posY > rowStart) ctx.translate(0, stepY);
+        for(unsigned int posX=0; posX<numCols; posX+=1){
+            if(posX==0){
+                if(posY != rowStart) ctx.translate(-1.0*((numCols-1)*stepX), 0);
+            }
+            else ctx.translate(stepX, 0);
+
+            // Draw the shape !
+            if(rotation != 0.f) ctx.rotate(rotation);
+            ctx.fill_path(blShape, color);
+            if(rotation != 0.f) ctx.rotate(-rotation);
+        }
+    }
+}
+
 //--------------------------------------------------------------
 void ofApp::keyPressed(int key){
     if(key==' '){
@@ -2,6 +2,8 @@
 
 #include "ofMain.h"
 #include "ofxBlend2D.h"
+#include "ofxBlend2DRenderer.h"
+#include "ofxBlend2DParallelSubmitter.h"
 #include <list>
 #include "ofxGui.h"
 #include "ofxFps.h"
@@ -27,17 +29,28 @@ class ofApp : public ofBaseApp{
 		void dragEvent(ofDragInfo dragInfo);
 		void gotMessage(ofMessage msg);
 
+        // The OF draw code, used by both the OF renderer and ofxBlend2DRenderer
+        void drawShapesOF(unsigned int stepX, unsigned int stepY, float loopProgress);
+        // The Blend2D draw code for rows [rowStart, rowEnd), with a BLContext or an ofxBlend2DCommandBuffer
+        template<typename ContextT>
+        void drawShapesBL(ContextT& ctx, unsigned int rowStart, unsigned int rowEnd, unsigned int numCols, unsigned int stepX, unsigned int stepY, float rotation, const BLRgba32& color) const;
+
         void onThreadsChanged(int& value){
             if(value<1) value = 1;
             blend2d.setNumThreads(value);
         }
 		
         ofxBlend2DThreadedRenderer blend2d;
+        std::shared_ptr<ofxBlend2DRenderer> blRenderer; // ofBaseRenderer API for Blend2D
+        ofxBlend2DParallelSubmitter parallelSubmitter; // Submits rows from several threads
         ofxFps blRendererFps;
 
         ofxPanel gui;
         ofxIntSlider numThreads;
         ofxToggle useBlend2DForRendering;
+        ofxToggle useOfApiWithBlend2D;
+        ofxToggle useParallelSubmission;
+        ofxToggle useParallelSubContexts;
         ofxIntSlider rows;
         ofxIntSlider cols;
         //ofxToggle drawFilled;
@@ -49,6 +62,7 @@ class ofApp : public ofBaseApp{
         // Cached vector graphics
         // Both native types to the respective libs
         BLPath blShape;
+        double blShapeRadius = 100; // Bounds margin of the parallel sub-contexts
         ofPath ofShape;
 
         bool bSaveNextFrame = false;
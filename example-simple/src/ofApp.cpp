@@ -7,6 +7,9 @@ void ofApp::setup(){
 
     blend2d.allocate(ofGetWidth(), ofGetHeight(), GL_RGBA);
 
+    // Compile the pipelines now, so the first frames don't hitch (on a background thread)
+    blend2d.prewarm(ofxBlend2DJitPrewarmer::Settings(), true);
+
     // Show Blend2d build info
     bl_debug_runtime_build_info();
 }
@@ -0,0 +1,376 @@
+#include "ofApp.h"
+#include "ofxBlend2DUtils.h"
+
+#include <cstdio>
+#include <algorithm>
+
+static bool getChance(std::mt19937& random, float chance){
+    return std::uniform_real_distribution<float>(0.f, 1.f)(random) < chance;
+}
+
+static int getRandomInt(std::mt19937& random, int min, int max){
+    return std::uniform_int_distribution<int>(min, max)(random);
+}
+
+static float getRandomFloat(std::mt19937& random, float min, float max){
+    return std::uniform_real_distribution<float>(min, max)(random);
+}
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+    std::string error;
+    if(!parseArguments(error)){
+        if(!error.empty()){
+            ofLogError("example-soak") << error;
+            printUsage();
+        }
+        bFinished = true;
+        ofExit(error.empty() ? 0 : 1);
+        return;
+    }
+
+#ifdef DEBUG
+    ofLogWarning("example-soak") << "This is a debug build, latencies are a lot higher than in release builds.";
+#endif
+    ofSetFrameRate(settings.fps);
+    random.seed(settings.seed);
+
+    // No GL here : frames are received by update() without uploading them
+    renderer = std::make_unique<ofxBlend2DThreadedRenderer>(false);
+    width = std::min(1280, settings.maxWidth);
+    height = std::min(720, settings.maxHeight);
+    renderer->allocate(width, height, GL_RGBA);
+    lastProgressTime = ofGetElapsedTimeMicros();
+
+    if(settings.durationSeconds>0.f) ofLogNotice("example-soak") << "Running for " << settings.durationSeconds << " seconds (seed " << settings.seed << ")";
+    else ofLogNotice("example-soak") << "Running " << settings.numFrames << " frames (seed " << settings.seed << ")";
+    std::printf("%8s %8s %9s %9s %9s %9s %9s %8s %8s %8s\n", "frame", "time s", "lat p50", "lat p95", "lat p99", "flush p95", "RSS MB", "canvases", "dropped", "errors");
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+    if(bFinished) return;
+
+    const uint64_t now = ofGetElapsedTimeMicros();
+    if(renderer->update()){
+        lastProgressTime = now;
+    }
+    else if(renderer->isDirty() && now-lastProgressTime > uint64_t(settings.stallSeconds*1000000.f)){
+        // The frame in flight never came back
+        ofLogError("example-soak") << "The pipeline stalled : no frame received for " << settings.stallSeconds << " seconds, at frame " << submittedFrames;
+        bStalled = true;
+        finish();
+        return;
+    }
+
+    if(renderer->begin()){
+        drawLoad(renderer->getBlContext(), submittedFrames);
+        // Always the same file : exercises the encoder without filling the disk
+        std::string fileToSave;
+        if(getChance(random, settings.saveChance)){
+            fileToSave = "soak-frame.png";
+            numSaves++;
+        }
+        renderer->end(submittedFrames, fileToSave);
+        submittedFrames++;
+        lastProgressTime = now;
+
+        // Once per frame, while it's in flight
+        applyRandomEvents();
+
+        if(submittedFrames%settings.sampleInterval==0) takeSample();
+    }
+
+    const bool bDone = settings.durationSeconds>0.f ? ofGetElapsedTimef()>=settings.durationSeconds : submittedFrames>=settings.numFrames;
+    if(bDone) finish();
+}
+
+//--------------------------------------------------------------
+// Changes happening in long running installations, while a frame is in flight
+void ofApp::applyRandomEvents(){
+    if(getChance(random, settings.resizeChance)){
+        width = getRandomInt(random, 16, settings.maxWidth);
+        height = getRandomInt(random, 16, settings.maxHeight);
+        renderer->allocate(width, height, 0); // Keeps the format
+        numResizes++;
+    }
+    if(getChance(random, settings.formatChance)){
+        const GLint formats[] = { GL_RGBA, GL_RGB, GL_LUMINANCE };
+        renderer->allocate(width, height, formats[getRandomInt(random, 0, 2)]);
+        numResizes++;
+    }
+    if(getChance(random, settings.threadsChance)){
+        renderer->setNumThreads(getRandomInt(random, 0, 8));
+        numThreadChanges++;
+    }
+    if(getChance(random, settings.restartChance)){
+        renderer->stopBlThread();
+        renderer->startBlThread();
+        numRestarts++;
+    }
+}
+
+// A slow wave with random spikes, like a scene getting busier then calmer
+void ofApp::drawLoad(BLContext& ctx, unsigned int frameNum){
+    const float wave = .5f + .5f*std::sin(frameNum*.005f);
+    const bool bSpike = getChance(random, .01f);
+    const unsigned int numShapes = (unsigned int)(settings.maxShapes * (.25f+wave) * (bSpike ? 3.f : 1.f));
+
+    for(unsigned int i=0; i<numShapes; ++i){
+        const double x = getRandomFloat(random, 0.f, width);
+        const double y = getRandomFloat(random, 0.f, height);
+        const double size = getRandomFloat(random, 2.f, 60.f);
+        const BLRgba32 color(getRandomInt(random, 0, 255), getRandomInt(random, 0, 255), getRandomInt(random, 0, 255), getRandomInt(random, 32, 255));
+        switch(i%8){
+            case 0: case 1: case 2:
+                ctx.fill_circle(x, y, size*.5, color);
+                break;
+            case 3: case 4:
+                ctx.fill_rect(x, y, size, size*.5, color);
+                break;
+            case 5: case 6: {
+                BLPath path;
+                path.move_to(x, y);
+                path.cubic_to(x+size, y-size, x-size, y+size*2., x+size*.5, y+size);
+                ctx.set_stroke_width(1.+size*.05);
+                ctx.stroke_path(path, color);
+                break;
+            }
+            case 7: {
+                BLGradient gradient(BLLinearGradientValues(x, y, x+size, y+size));
+                gradient.add_stop(0.0, color);
+                gradient.add_stop(1.0, BLRgba32(0x00000000u));
+                ctx.fill_rect(BLRect(x, y, size, size), gradient);
+                break;
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void ofApp::takeSample(){
+    const ofxBlend2DFrameProfiler& profiler = renderer->getProfiler();
+    const uint64_t numRecorded = profiler.getNumRecorded();
+    // Frames received since the previous sample (the profiler keeps capacity-1 readable frames)
+    const std::size_t numNewFrames = (std::size_t)std::min<uint64_t>(numRecorded-lastNumRecorded, profiler.getCapacity()-1);
+    lastNumRecorded = numRecorded;
+
+    Sample sample;
+    sample.frame = submittedFrames;
+    sample.elapsedSeconds = ofGetElapsedTimef();
+    sample.numUploaded = numRecorded;
+    sample.numDropped = profiler.getNumDropped();
+    if(numNewFrames>0){
+        sample.latency = profiler.getLatencyStats(numNewFrames).latency;
+        sample.flush = profiler.getSummary(ofxBlend2DFrameProfiler::FlushSpan, numNewFrames);
+        for(const ofxBlend2DFrameTimings& timings : profiler.getHistory(numNewFrames)){
+            sample.contextErrorFlags |= timings.contextErrorFlags;
+        }
+    }
+    sample.residentBytes = ofxBlend2D::GetResidentBytes();
+    sample.numCanvases = renderer->getCanvasPool()->getNumAllocated();
+    sample.numResizes = numResizes;
+    sample.numThreadChanges = numThreadChanges;
+    sample.numRestarts = numRestarts;
+    sample.numSaves = numSaves;
+    samples.push_back(sample);
+
+    std::printf("%8u %8.1f %9.2f %9.2f %9.2f %9.2f %9.1f %8zu %8llu %8u\n", sample.frame, sample.elapsedSeconds, sample.latency.p50Ms, sample.latency.p95Ms, sample.latency.p99Ms,
+        sample.flush.p95Ms, sample.residentBytes/(1024.*1024.), sample.numCanvases, (unsigned long long)sample.numDropped, sample.contextErrorFlags);
+    std::fflush(stdout);
+}
+
+//--------------------------------------------------------------
+std::vector<std::string> ofApp::analyze(ofJson& summary) const {
+    std::vector<std::string> issues;
+    if(bStalled) issues.push_back("The pipeline stalled at frame " + ofToString(submittedFrames));
+
+    uint32_t contextErrorFlags = 0;
+    for(const Sample& sample : samples) contextErrorFlags |= sample.contextErrorFlags;
+    summary["contextErrorFlags"] = contextErrorFlags;
+    if(contextErrorFlags!=0) issues.push_back("Context errors : " + ofxBlend2DThreadedRenderer::getContextErrors(contextErrorFlags));
+
+    // The first 10% are warmup (caches, pools, JIT)
+    const std::size_t numWarmupSamples = std::max<std::size_t>(1, samples.size()/10);
+    if(samples.size()<numWarmupSamples+4){
+        summary["drift"] = "not enough samples";
+        ofLogWarning("example-soak") << "Not enough samples to measure drift, run more frames.";
+        return issues;
+    }
+    const Sample& warmupEnd = samples[numWarmupSamples-1];
+    const Sample& last = samples.back();
+
+    // Memory : total growth and slope (least squares over the samples)
+    const double rssGrowthMb = (double(last.residentBytes)-double(warmupEnd.residentBytes))/(1024.*1024.);
+    double meanFrame = 0., meanRss = 0.;
+    const std::size_t numSamples = samples.size()-numWarmupSamples;
+    for(std::size_t i=numWarmupSamples; i<samples.size(); ++i){
+        meanFrame += samples[i].frame;
+        meanRss += samples[i].residentBytes/(1024.*1024.);
+    }
+    meanFrame /= numSamples;
+    meanRss /= numSamples;
+    double covariance = 0., variance = 0.;
+    for(std::size_t i=numWarmupSamples; i<samples.size(); ++i){
+        covariance += (samples[i].frame-meanFrame)*(samples[i].residentBytes/(1024.*1024.)-meanRss);
+        variance += (samples[i].frame-meanFrame)*(samples[i].frame-meanFrame);
+    }
+    const double rssSlope = variance>0. ? covariance/variance*10000. : 0.; // MB per 10k frames
+    summary["rssGrowthMb"] = rssGrowthMb;
+    summary["rssMbPer10kFrames"] = rssSlope;
+    if(rssGrowthMb>settings.maxRssGrowthMb) issues.push_back("Resident memory grew by " + ofToString(rssGrowthMb, 1) + " MB after warmup (" + ofToString(rssSlope, 2) + " MB per 10k frames)");
+
+    // Latency : the last quarter against the first quarter
+    const std::size_t quarter = std::max<std::size_t>(1, numSamples/4);
+    double startP95 = 0., endP95 = 0.;
+    for(std::size_t i=0; i<quarter; ++i){
+        startP95 += samples[numWarmupSamples+i].latency.p95Ms;
+        endP95 += samples[samples.size()-1-i].latency.p95Ms;
+    }
+    startP95 /= quarter;
+    endP95 /= quarter;
+    const double latencyDrift = startP95>0. ? endP95/startP95 : 1.;
+    summary["latencyP95StartMs"] = startP95;
+    summary["latencyP95EndMs"] = endP95;
+    summary["latencyDrift"] = latencyDrift;
+    if(latencyDrift>settings.maxLatencyDrift) issues.push_back("Latency p95 went from " + ofToString(startP95, 2) + " ms to " + ofToString(endP95, 2) + " ms");
+
+    // Canvases : new ones are only expected after a size or format change (in the same or the previous interval)
+    std::size_t numUnexplainedCanvases = 0;
+    for(std::size_t i=std::max<std::size_t>(numWarmupSamples, 2); i<samples.size(); ++i){
+        const bool bResized = samples[i].numResizes!=samples[i-1].numResizes || samples[i-1].numResizes!=samples[i-2].numResizes;
+        if(!bResized) numUnexplainedCanvases += samples[i].numCanvases-samples[i-1].numCanvases;
+    }
+    summary["canvasesAllocated"] = last.numCanvases;
+    summary["canvasesWithoutResize"] = numUnexplainedCanvases;
+    if(numUnexplainedCanvases>0) issues.push_back(ofToString(numUnexplainedCanvases) + " canvases were allocated without a resize, the pool isn't recycling them");
+
+    return issues;
+}
+
+void ofApp::finish(){
+    bFinished = true;
+
+    // Receive the last frame
+    if(!bStalled && renderer->isDirty()) renderer->update(true);
+    if(submittedFrames%settings.sampleInterval!=0) takeSample();
+
+    ofJson report;
+    ofJson& summary = report["summary"];
+    const std::vector<std::string> issues = analyze(summary);
+    summary["frames"] = submittedFrames;
+    summary["seconds"] = ofGetElapsedTimef();
+    summary["uploaded"] = renderer->getProfiler().getNumRecorded();
+    summary["dropped"] = renderer->getProfiler().getNumDropped();
+    summary["resizes"] = numResizes;
+    summary["threadChanges"] = numThreadChanges;
+    summary["restarts"] = numRestarts;
+    summary["saves"] = numSaves;
+    summary["issues"] = issues;
+    summary["passed"] = issues.empty();
+
+    ofJson& settingsJson = report["settings"];
+    settingsJson["seed"] = settings.seed;
+    settingsJson["sampleInterval"] = settings.sampleInterval;
+    settingsJson["maxWidth"] = settings.maxWidth;
+    settingsJson["maxHeight"] = settings.maxHeight;
+    settingsJson["maxShapes"] = settings.maxShapes;
+    settingsJson["maxRssGrowthMb"] = settings.maxRssGrowthMb;
+    settingsJson["maxLatencyDrift"] = settings.maxLatencyDrift;
+
+    ofJson& samplesJson = report["samples"];
+    samplesJson = ofJson::array();
+    for(const Sample& sample : samples){
+        ofJson entry;
+        entry["frame"] = sample.frame;
+        entry["seconds"] = sample.elapsedSeconds;
+        entry["uploaded"] = sample.numUploaded;
+        entry["dropped"] = sample.numDropped;
+        entry["latencyP50Ms"] = sample.latency.p50Ms;
+        entry["latencyP95Ms"] = sample.latency.p95Ms;
+        entry["latencyP99Ms"] = sample.latency.p99Ms;
+        entry["latencyMaxMs"] = sample.latency.maxMs;
+        entry["flushP95Ms"] = sample.flush.p95Ms;
+        entry["residentBytes"] = sample.residentBytes;
+        entry["canvases"] = sample.numCanvases;
+        entry["contextErrorFlags"] = sample.contextErrorFlags;
+        entry["resizes"] = sample.numResizes;
+        entry["threadChanges"] = sample.numThreadChanges;
+        entry["restarts"] = sample.numRestarts;
+        entry["saves"] = sample.numSaves;
+        samplesJson.push_back(entry);
+    }
+
+    // Also exercises the shutdown
+    renderer.reset();
+
+    std::printf("\n%u frames in %.1f s : %u resizes, %u thread changes, %u worker restarts, %u saves\n", submittedFrames, ofGetElapsedTimef(), numResizes, numThreadChanges, numRestarts, numSaves);
+    if(issues.empty()) std::printf("PASSED : no drift detected\n");
+    for(const std::string& issue : issues) std::printf("FAILED : %s\n", issue.c_str());
+
+    bool bSaved = ofSavePrettyJson(settings.outputFile, report);
+    if(bSaved) ofLogNotice("example-soak") << "Report written to " << ofToDataPath(settings.outputFile, true);
+    else ofLogError("example-soak") << "Couldn't write the report to " << settings.outputFile;
+    ofExit(issues.empty() && bSaved ? 0 : 1);
+}
+
+//--------------------------------------------------------------
+bool ofApp::parseArguments(std::string& error){
+    for(std::size_t i=0; i<args.size(); ++i){
+        const std::string& arg = args[i];
+        if(arg=="--help" || arg=="-h"){
+            printUsage();
+            return false;
+        }
+        // Options with a value
+        if(i+1>=args.size()){
+            error = "Missing value for " + arg;
+            return false;
+        }
+        const std::string& value = args[++i];
+        if(arg=="--frames") settings.numFrames = std::max(1, ofToInt(value));
+        else if(arg=="--duration") settings.durationSeconds = std::max(0.f, ofToFloat(value));
+        else if(arg=="--seed") settings.seed = (unsigned int)ofToInt(value);
+        else if(arg=="--sample-interval") settings.sampleInterval = std::max(1, ofToInt(value));
+        else if(arg=="--max-size"){
+            const std::vector<std::string> dimensions = ofSplitString(ofToLower(value), "x");
+            settings.maxWidth = dimensions.size()==2 ? ofToInt(dimensions[0]) : 0;
+            settings.maxHeight = dimensions.size()==2 ? ofToInt(dimensions[1]) : 0;
+            if(settings.maxWidth<16 || settings.maxHeight<16){
+                error = "Invalid size \"" + value + "\", use WIDTHxHEIGHT (at least 16x16)";
+                return false;
+            }
+        }
+        else if(arg=="--shapes") settings.maxShapes = std::max(0, ofToInt(value));
+        else if(arg=="--fps") settings.fps = std::max(0.f, ofToFloat(value));
+        else if(arg=="--max-rss-growth") settings.maxRssGrowthMb = ofToFloat(value);
+        else if(arg=="--max-latency-drift") settings.maxLatencyDrift = ofToFloat(value);
+        else if(arg=="--out") settings.outputFile = value;
+        else {
+            error = "Unknown option " + arg;
+            return false;
+        }
+    }
+    // Each sample reads its frames back from the profiler
+    const unsigned int maxSampleInterval = 500;
+    if(settings.sampleInterval>maxSampleInterval){
+        ofLogWarning("example-soak") << "The sample interval is limited to " << maxSampleInterval << " frames";
+        settings.sampleInterval = maxSampleInterval;
+    }
+    return true;
+}
+
+void ofApp::printUsage(){
+    std::printf(
+        "Usage: example-soak [options]\n"
+        "  --frames N               Submitted frames (default: 20000)\n"
+        "  --duration SECONDS       Runs for that long instead\n"
+        "  --seed N                 Random events and load seed (default: 1)\n"
+        "  --sample-interval N      Frames per sample, at most 500 (default: 250)\n"
+        "  --max-size WxH           Largest random canvas size (default: 1920x1080)\n"
+        "  --shapes N               Average shapes per frame, spikes go 3x higher (default: 1500)\n"
+        "  --fps N                  App frame rate, 0 = as fast as possible (default: 0)\n"
+        "  --max-rss-growth MB      Fails above that memory growth after warmup (default: 64)\n"
+        "  --max-latency-drift R    Fails when the latency p95 grows more than R times (default: 1.5)\n"
+        "  --out FILE               JSON report, relative to the data folder (default: soak.json)\n");
+}
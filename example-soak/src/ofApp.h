@@ -0,0 +1,85 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxBlend2D.h"
+
+#include <random>
+
+// Headless soak test of the threaded pipeline : submits thousands of frames of variable load through ofxBlend2DThreadedRenderer
+// (without texture uploads) while randomly resizing, changing the pixel format and thread count, restarting the worker and saving frames.
+// Samples latency percentiles, resident memory, canvas allocations and context errors over time, then reports drift.
+// Exits with 1 when a leak, a slow degradation or a stall is detected, so it can run unattended before a deployment.
+class ofApp : public ofBaseApp{
+
+	public:
+        explicit ofApp(const std::vector<std::string>& _args) : args(_args) {};
+		void setup();
+		void update();
+
+        struct Settings {
+            unsigned int numFrames = 20000; // Submitted frames
+            float durationSeconds = 0.f; // Overrides numFrames when set
+            unsigned int seed = 1;
+            unsigned int sampleInterval = 250; // Frames per sample, below the profiler capacity
+            int maxWidth = 1920;
+            int maxHeight = 1080;
+            unsigned int maxShapes = 1500; // Average load, spikes go 3 times higher
+            // Per frame chances
+            float resizeChance = .005f;
+            float formatChance = .001f;
+            float threadsChance = .005f;
+            float restartChance = .001f;
+            float saveChance = .002f;
+            // Drift limits
+            float maxRssGrowthMb = 64.f;
+            float maxLatencyDrift = 1.5f; // Latency p95 ratio, end vs start
+            float stallSeconds = 5.f; // No frame received for that long
+            float fps = 0.f; // App frame rate, 0 = as fast as possible
+            std::string outputFile = "soak.json";
+        };
+
+        // State of the pipeline over one sample interval
+        struct Sample {
+            unsigned int frame = 0; // Submitted frames so far
+            float elapsedSeconds = 0.f;
+            uint64_t numUploaded = 0;
+            uint64_t numDropped = 0;
+            ofxBlend2DFrameProfiler::Summary latency; // end() to received
+            ofxBlend2DFrameProfiler::Summary flush;
+            uint64_t residentBytes = 0;
+            std::size_t numCanvases = 0; // Allocated by the pool so far
+            uint32_t contextErrorFlags = 0; // Of the interval's frames
+            unsigned int numResizes = 0; // Size or format changes so far
+            unsigned int numThreadChanges = 0;
+            unsigned int numRestarts = 0;
+            unsigned int numSaves = 0;
+        };
+
+        bool parseArguments(std::string& error);
+        static void printUsage();
+
+        void applyRandomEvents();
+        void drawLoad(BLContext& ctx, unsigned int frameNum);
+        void takeSample();
+        // Compares the end of the run to its start, returns the detected issues
+        std::vector<std::string> analyze(ofJson& summary) const;
+        void finish();
+
+        std::vector<std::string> args;
+        Settings settings;
+
+        std::unique_ptr<ofxBlend2DThreadedRenderer> renderer;
+        std::mt19937 random;
+        int width = 0;
+        int height = 0;
+        unsigned int submittedFrames = 0;
+        unsigned int numResizes = 0;
+        unsigned int numThreadChanges = 0;
+        unsigned int numRestarts = 0;
+        unsigned int numSaves = 0;
+        uint64_t lastNumRecorded = 0;
+        uint64_t lastProgressTime = 0; // Last submitted or received frame
+        bool bStalled = false;
+        bool bFinished = false;
+        std::vector<Sample> samples;
+};
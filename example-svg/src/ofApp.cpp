@@ -7,6 +7,7 @@ void ofApp::setup(){
     loadSvg("of-logo.svg");
 
     blend2d.allocate(ofGetWidth(), ofGetHeight(), GL_RGBA);
+    setupLayers();
 }
 
 //--------------------------------------------------------------
@@ -33,26 +34,26 @@ void ofApp::draw(){
         // - - - - - -
         // Get the context
         BLContext ctx = blend2d.getBlContext();
-        ctx.translate(20, 40); // Leave place for menu and padding
-
-        for(auto& shapeInfo : paths){
-            BLPath& blPath = shapeInfo.first;
-            ofPathStyle& style = shapeInfo.second;
-
-            if(!style.isVisible) return;
+        unsigned int frameNum = ofGetFrameNum();
 
-            if(!blPath.is_empty()){
-                if(style.isFilled){
-                    ctx.fill_path(blPath, toBLColor(style.fillColor));
-                }
+        if(bProgressive){
+            // Draws a slice of the scene, the output stays interactive while it converges
+            if(bSceneChanged) setupProgressive();
+            progressive.setFocus(BLPoint(ofGetMouseX(), ofGetMouseY()));
+            if(!progressive.isConverged()) layers.markDirty(sceneLayer);
+            progressive.renderSlice();
+        }
 
-                if(style.isStroked()){
-                    ctx.set_stroke_width(style.strokeWidth);
-                    ctx.stroke_path(blPath, toBLColor(style.strokeColor));
-                }
-            }
+        if(bUseLayers){
+            // Only the cursor layer is repainted every frame, the others are blitted from their canvas
+            cursorPos = glm::vec2(ofGetMouseX(), ofGetMouseY());
+            if(bSceneChanged) layers.markDirty(sceneLayer);
+            layers.render(frameNum);
+            layers.composite(ctx);
+        }
+        else {
+            drawScene(ctx);
         }
-        unsigned int frameNum = ofGetFrameNum();
         blend2d.end(frameNum);
     }
 
@@ -62,18 +63,10 @@ void ofApp::draw(){
         ofPushStyle();
         ofNoFill();
         ofSetColor(ofColor::red);
-        for(auto& shapeInfo : paths){
-            BLPath& blPath = shapeInfo.first;
-            ofPathStyle& style = shapeInfo.second;
-            if(!blPath.is_empty()){
-                BLBox bbox;
-                BLResult result = blPath.get_bounding_box(&bbox);
-                if(result!=BL_SUCCESS){
-                    // ignore
-                }
-                else {
-                    ofDrawRectangle(bbox.x0, bbox.y0, bbox.x1-bbox.x0, bbox.y1-bbox.y0);
-                }
+        for(auto& pathInfo : paths){
+            if(!pathStore.getInstanceShape(pathInfo.instance).is_empty()){
+                BLBox bbox = pathStore.getInstanceBounds(pathInfo.instance);
+                ofDrawRectangle(bbox.x0, bbox.y0, bbox.x1-bbox.x0, bbox.y1-bbox.y0);
             }
         }
         ofPopStyle();
@@ -102,22 +95,35 @@ void ofApp::draw(){
                     loadSvg(fileQuery.getPath());
                 }
             }
-            ImGui::Text("Loaded paths: %lu", paths.size());
+            if(ImGui::MenuItem("Save scene as path cache...", nullptr, false, !paths.empty())){
+                ofFileDialogResult fileQuery = ofSystemSaveDialog("scene.blpaths", "Save the converted scene ?");
+                if(fileQuery.bSuccess){
+                    savePathCache(fileQuery.getPath());
+                }
+            }
+            if(ImGui::Checkbox("Use native SVG parser", &bUseNativeSvgParser)){
+                if(!loadedSvgPath.empty()) loadSvg(loadedSvgPath);
+            }
+            ImGui::Text("Loaded paths: %lu (in %.1f ms)", paths.size(), svgLoadTimeMs);
+            ImGui::Text("Unique shapes: %lu (%lu kB saved)", pathStore.getNumShapes(), pathStore.getMemorySaved()/1024);
             ImGui::Dummy({20,20});
 
             ImGui::Separator();
 
-            for(auto& shapeInfo : paths){
-                BLPath& blPath = shapeInfo.first;
-                ofPathStyle& style = shapeInfo.second;
-
-                ImGui::PushID(&blPath);
-                if(ImGui::CollapsingHeader( style.name.c_str() )){
-                    ImGui::Text("blPath size: %lu", blPath.size());
-                    ImGui::InputFloat("Stroke Width", &style.strokeWidth, 0.1, 1.0, "%.3f" );
-                    ImGui::ColorEdit4("Stroke color", &style.strokeColor[0]);
-                    ImGui::Checkbox("Filled", &style.isFilled);
-                    ImGui::ColorEdit4("Fill Color", &style.fillColor[0]);
+            for(auto& pathInfo : paths){
+                const BLPath& blPath = pathStore.getInstanceShape(pathInfo.instance);
+                ofxBlend2DPathStyle& style = pathInfo.style;
+
+                ImGui::PushID(&pathInfo);
+                if(ImGui::CollapsingHeader( pathInfo.name.c_str() )){
+                    ImGui::Text("blPath size: %lu (shared by %lu)", blPath.size(), pathStore.getShapeUseCount(pathStore.getInstance(pathInfo.instance).shapeIndex));
+                    bSceneChanged |= ImGui::Checkbox("Visible", &style.isVisible);
+                    bSceneChanged |= ImGui::Checkbox("Stroked", &style.hasStroke);
+                    bSceneChanged |= ImGui::InputFloat("Stroke Width", &style.strokeWidth, 0.1, 1.0, "%.3f" );
+                    bSceneChanged |= ImGui::ColorEdit4("Stroke color", &style.strokeColor[0]);
+                    bSceneChanged |= ImGui::Checkbox("Filled", &style.isFilled);
+                    bSceneChanged |= ImGui::ColorEdit4("Fill Color", &style.fillColor[0]);
+                    bSceneChanged |= ImGui::SliderFloat("Opacity", &style.opacity, 0.f, 1.f);
 
 //                    if(ImGui::TreeNodeEx((void*)&blPath->points, _recurseChildren?ImGuiTreeNodeFlags_DefaultOpen:ImGuiTreeNodeFlags_None, "Points: %lu", _shape->points.size())){
 //                        for(auto& point : _shape->points){
@@ -143,6 +149,44 @@ void ofApp::draw(){
 
         if(ImGui::BeginMenu("Rendering")){
             ImGui::Checkbox("Render Bounding Boxes", &bRenderBoundingboxes);
+            bSceneChanged |= ImGui::Checkbox("Style-sorted submission", &bBatchSubmit);
+            if(bBatchSubmit){
+                const ofxBlend2DBatchSubmitter::Stats& stats = batchSubmitter.getStats();
+                ImGui::Text("Draw calls: %lu in %lu runs", stats.numOps, stats.numRuns);
+                ImGui::Text("State changes: %lu (unsorted: %lu)", stats.stateChanges, stats.stateChangesUnsorted);
+            }
+            ImGui::SeparatorText("Progressive");
+            if(ImGui::Checkbox("Progressive rendering", &bProgressive)){
+                bSceneChanged = true;
+            }
+            if(bProgressive){
+                ImGui::SliderFloat("Budget", &progressive.timeBudgetMs, 0.5f, 30.f, "%.1f ms");
+                static const char* orders[] = { "Document order", "Priority", "Closest to the mouse first" };
+                int order = progressive.getOrder();
+                if(ImGui::Combo("Order", &order, orders, IM_ARRAYSIZE(orders))){
+                    progressive.setOrder((ofxBlend2DProgressiveRenderer::Order)order);
+                    bSceneChanged = true;
+                }
+                const ofxBlend2DProgressiveRenderer::Stats& progressiveStats = progressive.getStats();
+                ImGui::ProgressBar(progressiveStats.getProgress());
+                ImGui::Text("%lu / %lu paths, %u frames (%.2f ms)", progressiveStats.numDrawn, progressiveStats.numItems, progressiveStats.numSlices, progressiveStats.sliceTimeMs);
+            }
+            ImGui::SeparatorText("Layers");
+            if(ImGui::Checkbox("Use layer stack", &bUseLayers)){
+                layers.markAllDirty(); // The scene may have changed meanwhile
+            }
+            if(bUseLayers){
+                const ofxBlend2DLayerStack::Stats& layerStats = layers.getStats();
+                ImGui::Text("Repainted: %lu, reused: %lu, failed: %lu (%.2f ms)", layerStats.numRendered, layerStats.numSkipped, layerStats.numFailed, layerStats.renderTimeMs);
+                for(ofxBlend2DLayerStack::Layer& layer : layers.getLayers()){
+                    ImGui::PushID(&layer);
+                    ImGui::Checkbox(layer.name.c_str(), &layer.isVisible);
+                    ImGui::SameLine();
+                    ImGui::TextDisabled("(frame %u, %.2f ms)", layer.lastRenderedFrame, layer.renderTimeMs);
+                    ImGui::SliderFloat("Opacity", &layer.opacity, 0.f, 1.f);
+                    ImGui::PopID();
+                }
+            }
             ImGui::EndMenu();
         }
     }
@@ -193,6 +237,8 @@ void ofApp::mouseExited(int x, int y){
 //--------------------------------------------------------------
 void ofApp::windowResized(int w, int h){
     blend2d.allocate(w, h);
+    layers.allocate(w, h);
+    if(bProgressive) progressive.allocate(w, h);
 }
 
 //--------------------------------------------------------------
@@ -206,12 +252,12 @@ void ofApp::dragEvent(ofDragInfo dragInfo){
 }
 
 //--------------------------------------------------------------
-void loadFromSvgBaseRecursive(std::vector<std::pair<BLPath, ofPathStyle> >& paths, ofxSvgBase& svg){
+void loadFromSvgBaseRecursive(std::vector<ofPathInfo>& paths, ofxBlend2DPathStore& pathStore, ofxSvgBase& svg){
     if(svg.isGroup()){
         ofxSvgGroup* g = dynamic_cast<ofxSvgGroup*>(&svg);
         if(g != nullptr){
             for(std::shared_ptr<ofxSvgBase>& e : g->getElements()){
-                loadFromSvgBaseRecursive(paths, *e.get());
+                loadFromSvgBaseRecursive(paths, pathStore, *e.get());
             }
         }
     }
@@ -223,21 +269,169 @@ void loadFromSvgBaseRecursive(std::vector<std::pair<BLPath, ofPathStyle> >& path
             std::string pathName = svg.getName();
             if(strcmp(pathName.c_str(), "No Name")==0) pathName = svg.getTypeAsString();
 
-            // Here we use the toBLPath() helper to convert an ofPath to a BLPath
-            paths.push_back( {toBLPath(e->path), ofPathStyle::fromOfPath(e->path, pathName.c_str(), svg.isVisible())} );
+            // Here we use the toBLPath() helper to convert an ofPath to a BLPath, identical shapes are stored once
+            ofPathInfo pathInfo;
+            pathInfo.instance = pathStore.add(toBLPath(e->path));
+            pathInfo.name = pathName;
+            pathInfo.style = ofxBlend2DPathStyle::fromOfPath(e->path, svg.isVisible());
+            paths.push_back(pathInfo);
         }
         else ofLogWarning("loadFromSvgBaseRecursive") << "Unsupported shape type : " << svg.getTypeAsString() <<" !";
     }
 }
 
-
 //--------------------------------------------------------------
 void ofApp::loadSvg(std::string path){
+    loadedSvgPath = path;
+    bSceneChanged = true;
+    paths.clear();
+    pathStore.clear();
+
+    uint64_t startTime = ofGetElapsedTimeMicros();
+    if(ofFilePath::getFileExt(path)=="blpaths") loadPathCache(path);
+    else if(bUseNativeSvgParser) loadSvgNative(path);
+    else loadSvgWithOfxSvgLoader(path);
+    svgLoadTimeMs = (ofGetElapsedTimeMicros()-startTime)/1000.f;
+}
+
+//--------------------------------------------------------------
+void ofApp::loadSvgWithOfxSvgLoader(std::string path){
     ofxSvgLoader svg;
     svg.load(path);
 
-    paths.clear();
     for(std::shared_ptr<ofxSvgBase>& e : svg.getElements()){
-        loadFromSvgBaseRecursive(paths, *e.get());
+        loadFromSvgBaseRecursive(paths, pathStore, *e.get());
+    }
+}
+
+//--------------------------------------------------------------
+void ofApp::loadSvgNative(std::string path){
+    // Shapes are streamed in document order, straight into the path store
+    ofxBlend2DSvgLoader svg;
+    svg.load(path, [this](ofxBlend2DSvgShape&& shape){
+        ofPathInfo pathInfo;
+        pathInfo.instance = pathStore.add(shape.path);
+        pathInfo.name = shape.id.empty() ? shape.type : shape.id;
+        pathInfo.style = shape.style;
+        paths.push_back(pathInfo);
+    });
+}
+
+//--------------------------------------------------------------
+void ofApp::loadPathCache(std::string path){
+    // Memory-mapped, no parsing : each path is a memcpy from the mapping (BLPath can't reference it).
+    // The cached scene is already converted, so paths skip the path store's hashing and deduplication.
+    ofxBlend2DPathCache cache;
+    if(!cache.open(path)) return;
+
+    pathStore.reserve(cache.size());
+    paths.reserve(cache.size());
+    for(std::size_t i=0; i<cache.size(); ++i){
+        ofPathInfo pathInfo;
+        pathInfo.instance = pathStore.addUnique(cache.getPath(i));
+        pathInfo.name = "Cached path " + ofToString(i);
+        pathInfo.style = cache.getStyle(i);
+        paths.push_back(pathInfo);
+    }
+}
+
+//--------------------------------------------------------------
+void ofApp::savePathCache(std::string path){
+    ofxBlend2DPathCacheWriter writer;
+    writer.reserve(paths.size(), 0);
+    for(auto& pathInfo : paths){
+        // Bake the instance transform, the cache stores scene coordinates
+        BLPath blPath = pathStore.getInstanceShape(pathInfo.instance);
+        blPath.transform(pathStore.getInstance(pathInfo.instance).transform);
+        writer.add(blPath, pathInfo.style);
+    }
+    writer.save(path);
+}
+
+//--------------------------------------------------------------
+void ofApp::setupLayers(){
+    layers.clear();
+    layers.allocate(ofGetWidth(), ofGetHeight());
+
+    // Static : painted once (and after a resize)
+    layers.addLayer("Background", ofxBlend2DLayerStack::OnDemand, [](BLContext& ctx, unsigned int frameNum){
+        // Stays transparent (the layer is cleared), like the frame without layers
+        const BLSize size = ctx.target_size();
+        BLPath grid;
+        for(int x=20; x<(int)size.w; x+=40){
+            grid.move_to(x+.5, 0);
+            grid.line_to(x+.5, size.h);
+        }
+        for(int y=40; y<(int)size.h; y+=40){
+            grid.move_to(0, y+.5);
+            grid.line_to(size.w, y+.5);
+        }
+        ctx.set_stroke_width(1);
+        ctx.stroke_path(grid, BLRgba32(0xFFDDDDDD));
+    });
+
+    // Repainted when the scene is edited
+    sceneLayer = layers.addLayer("SVG scene", ofxBlend2DLayerStack::OnDemand, [this](BLContext& ctx, unsigned int frameNum){
+        drawScene(ctx);
+    });
+
+    // Follows the mouse
+    layers.addLayer("Cursor", ofxBlend2DLayerStack::EveryFrame, [this](BLContext& ctx, unsigned int frameNum){
+        ctx.set_stroke_width(1.5);
+        ctx.stroke_circle(cursorPos.x, cursorPos.y, 12, BLRgba32(0xFFFF3030));
+        ctx.stroke_line(cursorPos.x-20, cursorPos.y, cursorPos.x+20, cursorPos.y, BLRgba32(0xFFFF3030));
+        ctx.stroke_line(cursorPos.x, cursorPos.y-20, cursorPos.x, cursorPos.y+20, BLRgba32(0xFFFF3030));
+    });
+}
+
+//--------------------------------------------------------------
+void ofApp::setupProgressive(){
+    // Paths are drawn straight from the path store, in scene coordinates
+    progressive.clear();
+    progressive.allocate(ofGetWidth(), ofGetHeight());
+    progressive.setTransform(BLMatrix2D::make_translation(20, 40)); // Leave place for menu and padding
+    for(auto& pathInfo : paths){
+        const std::size_t instance = pathInfo.instance;
+        if(pathStore.getInstanceShape(instance).is_empty()) continue;
+        const ofxBlend2DPathStyle style = pathInfo.style;
+        progressive.addItem([this, instance, style](BLContext& ctx){
+            pathStore.drawInstance(ctx, instance, style);
+        }, pathStore.getInstanceBounds(instance));
+    }
+}
+
+//--------------------------------------------------------------
+void ofApp::drawScene(BLContext& ctx){
+    if(bProgressive){
+        // Accumulated so far
+        ctx.blit_image(BLPoint(0, 0), progressive.getCanvas());
+        bSceneChanged = false;
+        return;
+    }
+
+    ctx.save();
+    ctx.translate(20, 40); // Leave place for menu and padding
+
+    if(bBatchSubmit){
+        // Style-sorted : same visual result with less state changes
+        if(bSceneChanged){
+            batchSubmitter.clear();
+            batchSubmitter.reserve(paths.size());
+            for(auto& pathInfo : paths){
+                const BLBox bounds = pathStore.getInstanceBounds(pathInfo.instance);
+                batchSubmitter.add(pathStore.getInstanceShape(pathInfo.instance), pathInfo.style, pathStore.getInstance(pathInfo.instance).transform, &bounds);
+            }
+        }
+        batchSubmitter.submit(ctx);
+    }
+    else {
+        // Document order
+        for(auto& pathInfo : paths){
+            if(!pathStore.getInstanceShape(pathInfo.instance).is_empty()){
+                pathStore.drawInstance(ctx, pathInfo.instance, pathInfo.style);
+            }
+        }
     }
+    ctx.restore();
+    bSceneChanged = false;
 }
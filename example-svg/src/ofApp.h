@@ -2,37 +2,18 @@
 
 #include "ofMain.h"
 #include "ofxBlend2D.h"
+#include "ofxBlend2DPathStore.h"
+#include "ofxBlend2DSvg.h"
+#include "ofxBlend2DPathCache.h"
+#include "ofxBlend2DBatchSubmitter.h"
+#include "ofxBlend2DLayerStack.h"
+#include "ofxBlend2DProgressiveRenderer.h"
 #include "ofxImGui.h"
 
-struct ofPathStyle {
+struct ofPathInfo {
+		std::size_t instance = 0; // Instance index in pathStore
 		std::string name = "No Name";
-
-		float strokeWidth = 0.f;
-		ofFloatColor strokeColor;
-
-		bool isFilled = false;
-		ofFloatColor fillColor;
-
-		bool isVisible = false;
-
-		bool isStroked(){
-			return strokeWidth>0.f;
-		};
-
-		ofPathStyle(std::string _name, float _pathWidth, ofColor _pathColor, bool _isFilled, ofColor _fillColor, bool _isVisible) :
-			name(_name), strokeWidth(_pathWidth), strokeColor(_pathColor), isFilled(_isFilled), fillColor(_fillColor), isVisible(_isVisible)
-		{}
-
-		static ofPathStyle fromOfPath(ofPath const& _path, std::string _name="No Name", bool _isVisible=false){
-			return {
-				_name,
-				_path.getStrokeWidth(),
-				_path.getStrokeColor(),
-				_path.isFilled(),
-				_path.getFillColor(),
-				_isVisible
-			};
-		}
+		ofxBlend2DPathStyle style;
 };
 
 class ofApp : public ofBaseApp{
@@ -56,8 +37,29 @@ class ofApp : public ofBaseApp{
 
 		void loadSvg(std::string path);
 		
-		std::vector<std::pair<BLPath, ofPathStyle> > paths;
+		void loadSvgWithOfxSvgLoader(std::string path);
+		void loadSvgNative(std::string path);
+		void loadPathCache(std::string path);
+		void savePathCache(std::string path);
+		void setupLayers();
+		void setupProgressive();
+		void drawScene(BLContext& ctx);
+
+		std::vector<ofPathInfo> paths;
+		ofxBlend2DPathStore pathStore; // Shares identical geometry
+		ofxBlend2DBatchSubmitter batchSubmitter; // Reorders draw calls by style
+		bool bBatchSubmit = true;
+		bool bSceneChanged = true; // Rebuilds the batch and repaints the scene layer
+		ofxBlend2DLayerStack layers; // Background, scene and cursor, each repainted at its own rate
+		bool bUseLayers = true;
+		std::size_t sceneLayer = 0;
+		ofxBlend2DProgressiveRenderer progressive; // Draws the scene over several frames
+		bool bProgressive = false;
+		glm::vec2 cursorPos;
 		ofxBlend2DThreadedRenderer blend2d;
 		ofxImGui::Gui gui;
 		bool bRenderBoundingboxes = true;
+		bool bUseNativeSvgParser = false; // ofxBlend2DSvgLoader instead of ofxSvgLoader
+		std::string loadedSvgPath;
+		float svgLoadTimeMs = 0.f;
 };
@@ -4,6 +4,9 @@
 #include "ofLog.h"
 #include <iostream>
 #include <cassert>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
 #include "ofImage.h"
 #include "ofPixels.h"
 
@@ -49,10 +52,9 @@ namespace ofxBlend2D {
 }
 #endif
 
-ofxBlend2DThreadedRenderer::ofxBlend2DThreadedRenderer(){
+ofxBlend2DThreadedRenderer::ofxBlend2DThreadedRenderer(bool uploadTextures) : bUploadTextures(uploadTextures) {
 
-    createInfo.thread_count = 4; // Number of threads
-    //createInfo.flags =
+    createInfo = ofxBlend2DContextConfig().toCreateInfo(); // 4 threads
 
     //codec.find_by_name("BMP"); // Sets codec to BMP
 
@@ -62,6 +64,7 @@ ofxBlend2DThreadedRenderer::ofxBlend2DThreadedRenderer(){
 }
 
 ofxBlend2DThreadedRenderer::~ofxBlend2DThreadedRenderer() {
+	stopProducer();
 	stopBlThread();
 	pixelDataFromThread.close();
 	flushFrameSignal.close();
@@ -69,11 +72,13 @@ ofxBlend2DThreadedRenderer::~ofxBlend2DThreadedRenderer() {
 }
 
 void ofxBlend2DThreadedRenderer::startBlThread(){
+	// A stopped worker notices within one pop timeout
+	if(!isThreadRunning()) waitForThread(false);
 	startThread();
 }
 
 void ofxBlend2DThreadedRenderer::stopBlThread(){
-	std::unique_lock<std::mutex> lck(mutex);
+	// The worker exits after its current frame
 	stopThread();
 }
 
@@ -81,6 +86,8 @@ void ofxBlend2DThreadedRenderer::stopBlThread(){
 
 void ofxBlend2DThreadedRenderer::allocate(int _width, int _height, int glPixelType){
     // todo: wait for thread first ?
+    // Waits for the producer to leave begin()
+    std::unique_lock<std::mutex> producerLock(producerMutex);
 
     // If default pixeltype, set it to the previous one.
     // If no previous, set to default.
@@ -89,9 +96,14 @@ void ofxBlend2DThreadedRenderer::allocate(int _width, int _height, int glPixelTy
         glPixelType = glInternalFormatTexture==0?GL_RGB:glInternalFormatTexture;
     }
 
+    // The best thread count depends on the canvas
+    if(width!=(unsigned int)_width || height!=(unsigned int)_height || glPixelType!=glInternalFormatTexture){
+        threadTuner.invalidate();
+    }
+
     width = _width;
     height = _height;
-    tex.allocate(_width, _height, glPixelType);
+    if(bUploadTextures) tex.allocate(_width, _height, glPixelType);
 
     // Texture always allocates to the requested format
     glInternalFormatTexture = glPixelType;
@@ -128,14 +140,32 @@ bool ofxBlend2DThreadedRenderer::begin(){
         return false;
     }
 
-    // Init output image canvas
-    img = BLImage(width, height, blInternalFormat);
+    // Quality governor : lower quality settings (and resolution) while the render times (submit + flush) exceed its budget
+    const ofxBlend2DQualityGovernor::State quality = qualityGovernor.getState();
+    const int canvasWidth = quality.renderScale<1.f ? std::max(1, (int)std::lround(width*quality.renderScale)) : (int)width;
+    const int canvasHeight = quality.renderScale<1.f ? std::max(1, (int)std::lround(height*quality.renderScale)) : (int)height;
+    BLContextCreateInfo frameCreateInfo = createInfo;
+    if(threadTuner.bEnabled) frameCreateInfo.thread_count = threadTuner.getThreadCount();
+    else if(quality.threadCount>=0) frameCreateInfo.thread_count = quality.threadCount;
+    frameThreadCount = frameCreateInfo.thread_count;
+
+    // Init output image canvas : a shared memory slot when exporting, recycled from a previous frame when possible
+    frameShmExporter = shmExporter;
+    img = frameShmExporter ? frameShmExporter->acquireCanvas(canvasWidth, canvasHeight, blInternalFormat) : BLImage();
+    bImgFromPool = img.empty();
+    if(bImgFromPool) img = canvasPool->acquire(canvasWidth, canvasHeight, blInternalFormat);
+    frameBeginTime = ofGetElapsedTimeMicros();
+    frameBeginAppFrame = ofGetFrameNum(); // The app state this frame is drawn from
 
     // Create context for this image
-    BLResult result = ctx.begin(img, createInfo);
+    BLResult result = ctx.begin(img, frameCreateInfo);
 
     // Success ?
     if (result != BL_SUCCESS){
+        // Give the canvas back : to the pool, or its shared memory slot is freed with the image
+        if(bImgFromPool) canvasPool->release(std::move(img));
+        img = BLImage();
+        frameShmExporter.reset();
         ofLogError("ofxBlend2D::begin()") << "Error creating context !";
         return false;
     }
@@ -151,11 +181,12 @@ bool ofxBlend2DThreadedRenderer::begin(){
     // Todo: make this optional ?
     ctx.clear_all();
     ctx.fill_all(BLRgba32(255,255,255,0));
+    ofxBlend2DQualityGovernor::apply(ctx, quality);
 
     return true;
 }
 
-bool ofxBlend2DThreadedRenderer::end(unsigned int frameNum, std::string frameFileToSave){
+ofxBlend2DFrameTicket ofxBlend2DThreadedRenderer::end(unsigned int frameNum, std::string frameFileToSave){
     assert(isSubmittingDrawCmds); // begin() / end() call order mismatch !
     isSubmittingDrawCmds = false;
     bIsDirty = true;
@@ -164,21 +195,36 @@ bool ofxBlend2DThreadedRenderer::end(unsigned int frameNum, std::string frameFil
     std::cout << ofGetFrameNum() << "f__ "  << "GLThread generated new frame data !" << " dirty=" << bIsDirty << std::endl;
 #endif
 
-    flushFrameSignal.send(ofxBlend2DThreadedRendererData{std::move(ctx), frameNum, frameFileToSave});
+    // The worker becomes the only owner of the canvas (needed for recycling it)
+    ofxBlend2DFrameTicket ticket = ofxBlend2DFrameTicket::create(frameNum);
+    ofxBlend2DFrameTimings timings;
+    timings.frameNum = frameNum;
+    timings.set(ofxBlend2DFrameTimings::SubmitBegin, frameBeginTime);
+    timings.set(ofxBlend2DFrameTimings::SubmitEnd, ofGetElapsedTimeMicros());
+    timings.submitAppFrame = frameBeginAppFrame;
+    timings.threadCount = frameThreadCount;
+    if(!flushFrameSignal.tryPush(ofxBlend2DThreadedRendererData{std::move(ctx), std::move(img), frameNum, frameFileToSave, timings, ticket, std::move(frameShmExporter), bImgFromPool})){
+        // Only one frame is in flight at once (begin() waits for the upload), so this means the worker is gone
+        ofLogError("ofxBlend2DThreadedRenderer::end()") << "Couldn't send the frame to the worker thread ! Frame=" << frameNum;
+        bIsDirty = false;
+        return ofxBlend2DFrameTicket();
+    }
 
-    return true;
+    return ticket;
 }
 
 // Returns true if frame was received
 bool ofxBlend2DThreadedRenderer::update(const bool waitForThread, const bool noFrameSkipping){
-    assert(!isSubmittingDrawCmds);
+    assert(bProducerRunning || !isSubmittingDrawCmds);
 
     if(bIsDirty){
-        static BLImageData bufFromThread;
+        ofxBlend2DFrame frameFromThread;
         // Wait long for once ?
-        bool newFrame = pixelDataFromThread.tryReceive(bufFromThread, waitForThread?999999:0);
+        bool newFrame = waitForThread ? pixelDataFromThread.pop(frameFromThread, std::chrono::milliseconds(999999)) : pixelDataFromThread.tryPop(frameFromThread);
         // Empty queue until most recent image to grab (should never happen)
-        if(!noFrameSkipping) while(pixelDataFromThread.tryReceive(bufFromThread, 0)){
+        uint32_t numDropped = 0;
+        if(!noFrameSkipping) while(pixelDataFromThread.tryPop(frameFromThread)){
+            if(newFrame) numDropped++; // The previous one is discarded
             newFrame = true;
         }
         if(newFrame){
@@ -187,22 +233,34 @@ bool ofxBlend2DThreadedRenderer::update(const bool waitForThread, const bool noF
             fpsCounter.begin();
 #endif
 
-            // Blocks ! Wait for render queue to finish
-            // Note: should be flushed already; just calling in case the user illegally submitted render data
-            // Todo: can we access ctx here ???
-            //ctx.flush(BLContextFlushFlags::BL_CONTEXT_FLUSH_SYNC);
+            // Note: the worker flushed the frame's context already. ctx is not touched here : while producing, the producer thread owns it.
 
-            // Grab the result
-            if(!loadImageDataIntoTexture(&bufFromThread)){
+            // Grab the result (the previous frame returns to the pool, unless somebody still holds it)
+            const bool bReceived = frameFromThread.isValid();
+            if(bReceived) currentFrame = std::move(frameFromThread);
+            ofxBlend2DFrameTimings timings = currentFrame.getTimings();
+            timings.uploadAppFrame = ofGetFrameNum();
+            timings.numDropped = numDropped + numDroppedByWorker.exchange(0);
+            timings.set(ofxBlend2DFrameTimings::UploadBegin, ofGetElapsedTimeMicros());
+            if(!currentFrame.isValid() || (bUploadTextures && !loadImageDataIntoTexture(&currentFrame.getImageData()))){
                 ofLogWarning("ofxBlend2D") << "Could not load data from pixels !" << std::endl;
             }
-
-            // Close & release context
-            //ctx.end();
+            else if(bReceived){
+                timings.set(ofxBlend2DFrameTimings::UploadEnd, ofGetElapsedTimeMicros());
+                profiler.record(timings);
+                qualityGovernor.addFrame(timings);
+                threadTuner.addFrame(timings);
+            }
 
             bIsDirty = false;
             renderedFrames++;
 
+            // Wake up the producer (the empty lock prevents a lost wakeup)
+            if(bProducerRunning){
+                { std::unique_lock<std::mutex> lock(producerWaitMutex); }
+                producerCondition.notify_one();
+            }
+
 #ifdef ofxBlend2D_ENABLE_OFXFPS
             // Update timer. Todo: update also when no new frames & gui not visible ?
             fpsCounter.end();
@@ -240,7 +298,13 @@ BLContext& ofxBlend2DThreadedRenderer::getBlContext(){
 }
 
 std::string ofxBlend2DThreadedRenderer::getContextErrors(){
-    BLContextErrorFlags errorFlags = ctx.accumulated_error_flags();
+    // The context is handed to the worker by end() : outside begin() / end(), report the last flushed frame.
+    // While producing, ctx belongs to the producer thread : other threads also get the last flushed frame.
+    const bool bOwnsContext = isSubmittingDrawCmds && (!bProducerRunning || std::this_thread::get_id()==producerThread.get_id());
+    return getContextErrors(bOwnsContext ? ctx.accumulated_error_flags() : lastContextErrorFlags.load());
+}
+
+std::string ofxBlend2DThreadedRenderer::getContextErrors(uint32_t errorFlags){
     std::ostringstream ret;
     ret << "Context_Error_Flags=" << errorFlags << " (";
 
@@ -295,13 +359,43 @@ unsigned int ofxBlend2DThreadedRenderer::getRenderedFrames() const {
 }
 #endif
 
+ofxBlend2DJitPrewarmer::Report ofxBlend2DThreadedRenderer::prewarm(ofxBlend2DJitPrewarmer::Settings settings, bool background){
+    if(settings.formats.empty()){
+        if(blInternalFormat==BL_FORMAT_NONE){
+            ofLogWarning("ofxBlend2DThreadedRenderer::prewarm") << "Not allocated yet, prewarming the default format.";
+        }
+        else settings.formats.push_back(blInternalFormat);
+    }
+    settings.contextFlags |= createInfo.flags;
+    if(settings.contextFlags & BL_CONTEXT_CREATE_FLAG_DISABLE_JIT){
+        ofLogWarning("ofxBlend2DThreadedRenderer::prewarm") << "The JIT is disabled, nothing to prewarm.";
+        return ofxBlend2DJitPrewarmer::Report();
+    }
+    if(settings.contextFlags & BL_CONTEXT_CREATE_FLAG_ISOLATED_JIT_RUNTIME){
+        // Each context compiles its own pipelines : the frame contexts won't find ours
+        ofLogWarning("ofxBlend2DThreadedRenderer::prewarm") << "Isolated JIT runtimes don't share compiled pipelines, prewarming has no effect.";
+    }
+
+    if(background){
+        if(!prewarmer.start(settings)){
+            ofLogWarning("ofxBlend2DThreadedRenderer::prewarm") << "Already prewarming.";
+        }
+        return ofxBlend2DJitPrewarmer::Report();
+    }
+    return prewarmer.runBlocking(settings);
+}
+
 void ofxBlend2DThreadedRenderer::threadedFunction(){
 
-    bool newFrame = false;
     ofxBlend2DThreadedRendererData frameData;
     //BLArray<uint8_t> pixelDataInThread;
 
-    while(flushFrameSignal.receive(frameData)){
+    while(isThreadRunning()){
+        // Wakes up regularly to notice stopBlThread()
+        if(!flushFrameSignal.pop(frameData, std::chrono::milliseconds(100))){
+            if(flushFrameSignal.isClosed()) break;
+            continue;
+        }
 #ifdef ofxBlend2D_DEBUG
         std::cout << "Thread : encoding new frame !" << std::endl;
 #endif
@@ -309,49 +403,138 @@ void ofxBlend2DThreadedRenderer::threadedFunction(){
         // Simulate renderer lag !
         //std::this_thread::sleep_for(std::chrono::milliseconds(100));
 
-        // Lock mutex : from here, we can use the protected vars (expecting that the gl thread doesn't use them anymore)
-        // Protected vars : ctx, , all linked BLPaths
-        std::unique_lock<std::mutex> lock(mutex);
-
+        // No lock : from here, frameData is owned by this thread (the gl thread waits for the result before the next begin())
 
         // Flush the blend2d pipeline !
         // Blocks ! Waits for threaded render queue to finish
         // Todo: Call end() rather ?
+        ofxBlend2DFrameTimings& timings = frameData.timings;
+        timings.set(ofxBlend2DFrameTimings::FlushBegin, ofGetElapsedTimeMicros());
+        frameData.ctx.flush(BL_CONTEXT_FLUSH_SYNC);
+        // Read before end(), which resets them (includes errors raised while rasterizing)
+        timings.contextErrorFlags = frameData.ctx.accumulated_error_flags();
+        lastContextErrorFlags = timings.contextErrorFlags;
         frameData.ctx.end();
+        timings.set(ofxBlend2DFrameTimings::FlushEnd, ofGetElapsedTimeMicros());
 
-        // Grab the result
-        BLArray<uint8_t> resultData;
-        BLImageData imgData;
-        BLResult resultDataGet = img.get_data(&imgData);
-        if(resultDataGet != BL_SUCCESS){
-            ofLogWarning("ofxBlend2DThreadedRenderer") << "Couldn't load texture! Error=" << resultDataGet << "(" << blResultToString(resultDataGet) << ") and ContextError=" << getContextErrors();
-            return;
+        // Gotta save the file ? (before wrapping the frame, so its timings include the encoding)
+        const unsigned int frameNum = frameData.frameNum;
+        if(frameData.fileToSave.length()>0){
+            timings.set(ofxBlend2DFrameTimings::EncodeBegin, ofGetElapsedTimeMicros());
+            // Build pixels object
+            BLImageData imageData;
+            ofPixels pixels;
+            if(frameData.img.get_data(&imageData)!=BL_SUCCESS || !toOfPixels(imageData, pixels)
+                // Save the data !
+                || !ofSaveImage(pixels, ofToDataPath(frameData.fileToSave), OF_IMAGE_QUALITY_BEST)){
+                ofLogError("ofxBlend2DThreadedRenderer::threadedFunction()") << "Couldn't write frame to file. Frame=" << frameNum;
+            }
+            timings.set(ofxBlend2DFrameTimings::EncodeEnd, ofGetElapsedTimeMicros());
         }
 
-        std::size_t resultSize = imgData.size.h * imgData.stride;
+        // Wrap the result in a frame handle, it takes the canvas (which returns to the pool when the last handle drops)
+        // Shared memory slots are released to the exporter instead
+        ofxBlend2DFrame frame = ofxBlend2DFrame::create(std::move(frameData.img), timings, frameData.isPooledCanvas ? canvasPool : nullptr);
+        const ofxBlend2DFrameTicket ticket = std::move(frameData.ticket);
+        const std::shared_ptr<ofxBlend2DShmExporter> exporter = std::move(frameData.exporter);
+        frameData = ofxBlend2DThreadedRendererData(); // Release the context
+        // Invalid frames are still forwarded, so the gl thread doesn't wait for them forever
+        if(!frame.isValid()){
+            ofLogWarning("ofxBlend2DThreadedRenderer") << "Couldn't read the frame pixels ! Frame=" << frameNum;
+        }
 
-        // Gotta save the file ?
-        if(frameData.fileToSave.length()>0){
-            // Decode the data
-            GLint glFormat = blFormatToGlFormat(imgData.format);
-            auto numChannels = ofGetNumChannelsFromGLFormat(glFormat);
+        // Publish to other processes
+        if(exporter && frame.isValid()){
+            exporter->publish(frame);
+        }
 
-            // Build pixels object
-            ofPixels pixels;
-            pixels.setFromAlignedPixels((const unsigned char*)imgData.pixel_data, imgData.size.w, imgData.size.h, ofxBlend2DGetOfPixelFormatFromGLFormat(glFormat), imgData.stride);
+        // Forward data to thread !
+        const ofxBlend2DFrame readyFrame = frame; // Shared with the listeners
+        if(!pixelDataFromThread.tryPush(std::move(frame))){
+            ofLogWarning("ofxBlend2DThreadedRenderer::threadedFunction()") << "The frame queue is full, dropping frame " << frameNum;
+            numDroppedByWorker++;
+        }
+
+        // Notify once update() can receive it
+        if(readyFrame.isValid()){
+            ofNotifyEvent(frameReadyEvent, readyFrame, this);
+        }
+        ticket.complete(readyFrame);
+    }
+}
+
+bool ofxBlend2DThreadedRenderer::startProducer(DrawFunction drawFunction, float targetFps){
+    if(!drawFunction){
+        ofLogError("ofxBlend2DThreadedRenderer::startProducer") << "No draw function !";
+        return false;
+    }
+    if(isSubmittingDrawCmds){
+        ofLogError("ofxBlend2DThreadedRenderer::startProducer") << "Can't start producing between begin() and end() !";
+        return false;
+    }
+    stopProducer();
+
+    producerDraw = std::move(drawFunction);
+    producerFps = targetFps;
+    bProducerRunning = true;
+    producerThread = std::thread(&ofxBlend2DThreadedRenderer::producerFunction, this);
 
-            // Save the data !
-            if(!ofSaveImage(pixels, ofToDataPath(frameData.fileToSave), OF_IMAGE_QUALITY_BEST)){
-                ofLogError("ofxBlend2DThreadedRenderer::threadedFunction()") << "Couldn't write frame to file. Frame=" << frameData.frameNum;
+    // Frames are uploaded automatically
+    ofAddListener(ofEvents().update, this, &ofxBlend2DThreadedRenderer::onAppUpdate);
+    return true;
+}
+
+void ofxBlend2DThreadedRenderer::stopProducer(){
+    if(!producerThread.joinable()) return;
+
+    ofRemoveListener(ofEvents().update, this, &ofxBlend2DThreadedRenderer::onAppUpdate);
+    {
+        std::unique_lock<std::mutex> lock(producerWaitMutex);
+        bProducerRunning = false;
+    }
+    producerCondition.notify_one();
+    producerThread.join();
+    producerDraw = nullptr;
+}
+
+void ofxBlend2DThreadedRenderer::onAppUpdate(ofEventArgs& args){
+    update();
+}
+
+void ofxBlend2DThreadedRenderer::producerFunction(){
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point nextFrameTime = Clock::now();
+
+    while(bProducerRunning){
+        // Wait for the pipeline : the previous frame has to be uploaded, then for the next frame time
+        {
+            std::unique_lock<std::mutex> lock(producerWaitMutex);
+            producerCondition.wait(lock, [this](){ return !bIsDirty || !bProducerRunning; });
+            if(producerFps > 0.f){
+                producerCondition.wait_until(lock, nextFrameTime, [this](){ return !bProducerRunning; });
             }
         }
+        if(!bProducerRunning) break;
 
-        // Forward data to thread !
-#if __cplusplus>=201103
-        pixelDataFromThread.send(std::move(imgData));
-#else
-        pixelDataFromThread.send(imgData);
-#endif
+        // Schedule the next frame, without trying to catch up on missed ones
+        if(producerFps > 0.f){
+            const Clock::time_point now = Clock::now();
+            nextFrameTime += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0/producerFps));
+            if(nextFrameTime < now) nextFrameTime = now;
+        }
+
+        // Settings are only read by begin() : the draw function may change them (setNumThreads(), allocate()...) for the next frames
+        std::unique_lock<std::mutex> lock(producerMutex);
+        const bool bBegun = begin();
+        lock.unlock();
+        if(!bBegun){
+            std::this_thread::sleep_for(std::chrono::milliseconds(10)); // Don't spin on context errors
+            continue;
+        }
+        const unsigned int frameNum = producedFrames;
+        producerDraw(ctx, frameNum);
+        end(frameNum);
+        producedFrames++;
     }
 }
 
@@ -370,10 +553,12 @@ bool ofxBlend2DThreadedRenderer::loadImageDataIntoTexture(const BLImageData* dat
         (tex.getTextureData().width != data->size.w) || // different width ?
         (tex.getTextureData().height != data->size.h) // different width ?
     ){
+        // The quality governor may render at a lower resolution
+        const bool bScaled = qualityGovernor.getState().renderScale<1.f;
         if(
                 (glFormat != glInternalFormatTexture) ||
-                (data->size.w != width) || // different width ?
-                (data->size.h != height) // different width ?
+                (!bScaled && data->size.w != width) || // different width ?
+                (!bScaled && data->size.h != height) // different width ?
         ){
            ofLogWarning("ofxBlend2DThreadedRenderer::loadImageDataIntoTexture") << "The returned BMP header is not the same resolution as the configured size ! Resizing texture to match BMP data !";
         }
@@ -418,11 +603,14 @@ void ofxBlend2DThreadedRenderer::drawImGuiSettings(){
 
     bool reAllocate = false;
 
+    // Local copies : allocate() compares them to the current size (and locks the producer before changing it)
+    unsigned int newWidth = width;
+    unsigned int newHeight = height;
     static unsigned int pixelSteps[2] = {1, 10}; // Slow + Fast steps
-    if(ImGui::InputScalar("Width", ImGuiDataType_U32, &width, (void*)&pixelSteps[0], (void*)&pixelSteps[1], "%u px", ImGuiInputTextFlags_EnterReturnsTrue)){
+    if(ImGui::InputScalar("Width", ImGuiDataType_U32, &newWidth, (void*)&pixelSteps[0], (void*)&pixelSteps[1], "%u px", ImGuiInputTextFlags_EnterReturnsTrue)){
         reAllocate=true;
     }
-    if(ImGui::InputScalar("Height", ImGuiDataType_U32, &height, (void*)&pixelSteps[0], (void*)&pixelSteps[1], "%u px", ImGuiInputTextFlags_EnterReturnsTrue)){
+    if(ImGui::InputScalar("Height", ImGuiDataType_U32, &newHeight, (void*)&pixelSteps[0], (void*)&pixelSteps[1], "%u px", ImGuiInputTextFlags_EnterReturnsTrue)){
         reAllocate=true;
     }
     static const std::pair<GLint, const char*> options[] = {{GL_RGBA, "GL_RGBA"}, {GL_RGB, "GL_RGB"}, { GL_LUMINANCE, "GL_LUMINANCE" }, { 0, "Unknown" } };
@@ -446,16 +634,81 @@ void ofxBlend2DThreadedRenderer::drawImGuiSettings(){
         ImGui::EndCombo();
     }
     if(reAllocate){
-        allocate(width, height);
+        allocate(newWidth, newHeight);
     }
 
     static unsigned int numThreads[4] = { 0, 1, 0, 12 }; // cur, speed, min, max
-    numThreads[0] = createInfo.thread_count;
+    numThreads[0] = getNumThreads();
+    // Read once : BeginDisabled() / EndDisabled() must match even if another thread toggles it
+    bool bAutoThreads = threadTuner.bEnabled;
+    if(bAutoThreads) ImGui::BeginDisabled();
     if(ImGui::DragScalar("Num threads", ImGuiDataType_U32, (void*)&numThreads[0], numThreads[1], &numThreads[2], &numThreads[3], "%u" )){
-        createInfo.thread_count = numThreads[0];
+        setNumThreads(numThreads[0]);
+    }
+    if(bAutoThreads) ImGui::EndDisabled();
+    ImGui::SameLine();
+    if(ImGui::Checkbox("Auto##threads", &bAutoThreads)) setAutoThreads(bAutoThreads);
+    if(bAutoThreads){
+        const std::vector<ofxBlend2DThreadTuner::Candidate> candidates = threadTuner.getCandidates();
+        const bool bProbing = threadTuner.isProbing();
+        ImGui::TextDisabled("%s", bProbing ? "Probing :" : "Render medians :");
+        for(const ofxBlend2DThreadTuner::Candidate& candidate : candidates){
+            ImGui::SameLine();
+            if(bProbing) ImGui::TextDisabled("%ut (%u)", candidate.threadCount, (unsigned int)candidate.numSamples);
+            else if(candidate.threadCount==threadTuner.getBestThreadCount()) ImGui::Text("%ut %.2fms", candidate.threadCount, candidate.medianMs);
+            else ImGui::TextDisabled("%ut %.2fms", candidate.threadCount, candidate.medianMs);
+        }
+        ImGui::SameLine();
+        if(ImGui::SmallButton("Probe")) threadTuner.invalidate();
+    }
+    {
+        ofxBlend2DContextConfig contextConfig = getContextConfig();
+        const ofxBlend2DContextConfig::Preset curPreset = contextConfig.getPreset();
+        bool bChanged = false;
+        if(ImGui::BeginCombo("Context preset", ofxBlend2DContextConfig::getPresetName(curPreset))){
+            for(uint8_t i=0; i<ofxBlend2DContextConfig::NumPresets; ++i){
+                const ofxBlend2DContextConfig::Preset preset = (ofxBlend2DContextConfig::Preset)i;
+                if(ImGui::Selectable(ofxBlend2DContextConfig::getPresetName(preset), preset==curPreset)){
+                    contextConfig = ofxBlend2DContextConfig::fromPreset(preset);
+                    bChanged = true;
+                }
+            }
+            ImGui::EndCombo();
+        }
+        if(ImGui::TreeNode("Context options")){
+            bChanged |= ImGui::Checkbox("Isolated thread pool", &contextConfig.bIsolatedThreadPool);
+            bChanged |= ImGui::Checkbox("Fallback to sync", &contextConfig.bFallbackToSync);
+            if(ImGui::IsItemHovered()) ImGui::SetTooltip("Renders synchronously instead of failing when no threads are left in the pool.");
+            bChanged |= ImGui::Checkbox("Disable JIT", &contextConfig.bDisableJit);
+            bChanged |= ImGui::Checkbox("Isolated JIT runtime", &contextConfig.bIsolatedJitRuntime);
+            static const uint32_t limitMin = 0, queueLimitMax = 65536, stateLimitMax = 256;
+            bChanged |= ImGui::DragScalar("Command queue limit", ImGuiDataType_U32, &contextConfig.commandQueueLimit, 64.f, &limitMin, &queueLimitMax, contextConfig.commandQueueLimit==0 ? "default" : "%u");
+            bChanged |= ImGui::DragScalar("Saved state limit", ImGuiDataType_U32, &contextConfig.savedStateLimit, 1.f, &limitMin, &stateLimitMax, contextConfig.savedStateLimit==0 ? "unlimited" : "%u");
+            ImGui::TreePop();
+        }
+        if(bChanged) setContextConfig(contextConfig);
     }
     ImGui::Checkbox("High quality rendering", &bRenderHD);
 
+    if(prewarmer.isRunning()) ImGui::BeginDisabled();
+    if(ImGui::Button("Prewarm JIT")) prewarm(ofxBlend2DJitPrewarmer::Settings(), true);
+    if(prewarmer.isRunning()) ImGui::EndDisabled();
+    ImGui::SameLine();
+    if(prewarmer.isRunning()) ImGui::TextDisabled("Compiling...");
+    else {
+        const ofxBlend2DJitPrewarmer::Report report = prewarmer.getReport();
+        if(report.bCompleted){
+            ImGui::TextDisabled("%u combinations in %.1f ms", (unsigned int)report.entries.size(), report.totalMs);
+            if(ImGui::IsItemHovered() && ImGui::BeginTooltip()){
+                ImGui::Text("Slowest :");
+                for(const ofxBlend2DJitPrewarmer::Entry& entry : report.getSlowest(5)){
+                    ImGui::Text("comp op %u, %s : %.2f ms", (unsigned int)entry.compOp, ofxBlend2DJitPrewarmer::getStyleName(entry.style), entry.ms);
+                }
+                ImGui::EndTooltip();
+            }
+        }
+    }
+
     if(getTexture().isAllocated()){
         ImGui::Text("Texture Resolution: %.0f x %.0f (%s)", getTexture().getWidth(), getTexture().getHeight(), curOpt->second);
         if(getTexture().getTextureData().glInternalFormat!=glInternalFormatTexture){
@@ -511,6 +764,179 @@ void ofxBlend2DThreadedRenderer::drawImGuiSettings(){
     ImGui::Text("(cur:%3.0f min:%5.1f max:%5.1f) %6u frames", getFps(), minFps, maxFps, getRenderedFrames() );
 #endif // end ofxBlend2D_ENABLE_OFXFPS
 
+    // Quality governor
+    ImGui::Dummy({10,20});
+    ImGui::SeparatorText("Quality governor");
+    bool bGovernorEnabled = qualityGovernor.bEnabled;
+    if(ImGui::Checkbox("Enabled##governor", &bGovernorEnabled)) qualityGovernor.bEnabled = bGovernorEnabled;
+    ImGui::SameLine();
+    if(ImGui::Button("Reset##governor")) qualityGovernor.reset();
+    {
+        ofxBlend2DQualityGovernor::Settings governorSettings = qualityGovernor.getSettings();
+        bool bChanged = false;
+        bChanged |= ImGui::DragFloat("Render budget", &governorSettings.targetMs, .1f, 1.f, 200.f, "%.1f ms");
+        bChanged |= ImGui::SliderFloat("Restore below", &governorSettings.restoreRatio, .1f, 1.f, "%.2f x budget");
+        static const unsigned int windowSizeMin = 1, windowSizeMax = 240, threadsMin = 0, threadsMax = 32;
+        bChanged |= ImGui::SliderScalar("Window", ImGuiDataType_U32, &governorSettings.windowSize, &windowSizeMin, &windowSizeMax, "%u frames");
+        bChanged |= ImGui::SliderScalar("Max threads", ImGuiDataType_U32, &governorSettings.maxThreads, &threadsMin, &threadsMax, governorSettings.maxThreads==0 ? "unchanged" : "%u");
+        bChanged |= ImGui::Checkbox("Allow nearest gradients & patterns", &governorSettings.bAllowNearestStyles);
+        bChanged |= ImGuiEx::Blend2DFlattenTolerance(governorSettings.maxFlattenTolerance, "Max flatten tolerance");
+        bChanged |= ImGuiEx::Blend2DSimplifyTolerance(governorSettings.maxSimplifyTolerance, "Max simplify tolerance");
+        bChanged |= ImGui::SliderFloat("Min render scale", &governorSettings.minRenderScale, .25f, 1.f, "%.2f");
+        if(bChanged) qualityGovernor.setSettings(governorSettings);
+    }
+    const ofxBlend2DQualityGovernor::State quality = qualityGovernor.getState();
+    ImGui::Text("Level %u / %u : %s", quality.level, qualityGovernor.getNumLevels()-1, ofxBlend2DQualityGovernor::getDescription(quality).c_str());
+    ImGui::Text("Last window p95 %.2f ms, %u degrades, %u restores", qualityGovernor.getLastWindowMs(), qualityGovernor.getNumDegrades(), qualityGovernor.getNumRestores());
+
+    // Built-in stage timings
+    ImGui::Dummy({10,20});
+    ImGui::SeparatorText("Frame timings");
+    bool bProfilerEnabled = profiler.bEnabled;
+    if(ImGui::Checkbox("Record", &bProfilerEnabled)) profiler.bEnabled = bProfilerEnabled;
+    ImGui::SameLine();
+    if(ImGui::Button("Clear")) profiler.clear();
+    ImGui::SameLine();
+    if(ImGui::Button("Save CSV")) profiler.saveCsv("ofxBlend2D_timings.csv");
+    ImGui::SameLine();
+    if(ImGui::Button("Save trace")) profiler.saveChromeTrace("ofxBlend2D_trace.json");
+    if(ImGui::IsItemHovered()) ImGui::SetTooltip("Chrome trace JSON (chrome://tracing or ui.perfetto.dev), in the data folder.");
+
+    static const int numFrames = ofxBlend2D_FPS_HISTORY_SIZE;
+    const std::vector<ofxBlend2DFrameProfiler::Summary> summaries = profiler.getSummaries(numFrames);
+    ImGui::Text("Last %u frames (ms) :", (unsigned int)summaries[ofxBlend2DFrameProfiler::TotalSpan].count);
+    if(ImGui::BeginTable("##blend2d_timings", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp)){
+        ImGui::TableSetupColumn("Stage");
+        ImGui::TableSetupColumn("p50");
+        ImGui::TableSetupColumn("p95");
+        ImGui::TableSetupColumn("p99");
+        ImGui::TableSetupColumn("max");
+        ImGui::TableHeadersRow();
+        for(int span=0; span<ofxBlend2DFrameProfiler::NumSpans; ++span){
+            const ofxBlend2DFrameProfiler::Summary& summary = summaries[span];
+            if(summary.count==0) continue; // Ex: nothing encoded
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(ofxBlend2DFrameProfiler::getSpanName((ofxBlend2DFrameProfiler::Span)span));
+            ImGui::TableNextColumn(); ImGui::Text("%6.2f", summary.p50Ms);
+            ImGui::TableNextColumn(); ImGui::Text("%6.2f", summary.p95Ms);
+            ImGui::TableNextColumn(); ImGui::Text("%6.2f", summary.p99Ms);
+            ImGui::TableNextColumn(); ImGui::Text("%6.2f", summary.maxMs);
+        }
+        ImGui::EndTable();
+    }
+
+    // Latency
+    const ofxBlend2DFrameProfiler::LatencyStats latency = profiler.getLatencyStats(numFrames);
+    ImGui::Text("Showing frame %u, latency p50 %.2f ms, p95 %.2f ms", currentFrame.getFrameNum(), latency.latency.p50Ms, latency.latency.p95Ms);
+    ImGui::Text("Frames behind : p50 %.0f, max %.0f", latency.framesBehind.p50Ms, latency.framesBehind.maxMs);
+    ImGui::Text("Dropped : %llu / %llu (%.1f%%)", (unsigned long long)latency.numDropped, (unsigned long long)(latency.numUploaded+latency.numDropped), latency.getDropRate()*100.f);
+    static const float maxLatencyMs = 50.f;
+    const std::vector<float> latencyHistogram = profiler.getHistogram(ofxBlend2DFrameProfiler::LatencySpan, 25, maxLatencyMs, numFrames);
+    ImGui::PlotHistogram("Latency##blend2d_latency", latencyHistogram.data(), (int)latencyHistogram.size(), 0, "0 - 50 ms", 0.f, FLT_MAX, ImVec2(0,30));
+    const std::vector<float> behindHistogram = profiler.getFramesBehindHistogram(6, numFrames);
+    ImGui::PlotHistogram("Frames behind##blend2d_behind", behindHistogram.data(), (int)behindHistogram.size(), 0, "0 - 5+", 0.f, FLT_MAX, ImVec2(0,30));
+
+    // Timeline
+    if(ImGui::TreeNode("Timeline")){
+        ImGui::SliderFloat("Time window", &timelineWindowMs, 10.f, 1000.f, "%.0f ms", ImGuiSliderFlags_Logarithmic);
+        drawImGuiTimeline(timelineWindowMs);
+        ImGui::TreePop();
+    }
+
+    ImGui::PopID();
+}
+
+void ofxBlend2DThreadedRenderer::drawImGuiTimeline(float timeWindowMs, float laneHeight){
+    ImGui::PushID("Blend2DTimeline");
+
+    // Snapshot of the frames in the window, frozen while shift is held over the timeline
+    std::vector<ofxBlend2DFrameTimings>& frames = timelineFrames;
+    uint64_t& windowEnd = timelineWindowEnd;
+    const uint64_t windowMicros = (uint64_t)(glm::max(timeWindowMs, 1.f)*1000.f);
+    if(!bTimelineFrozen){
+        frames = profiler.getHistory();
+        windowEnd = frames.empty() ? ofGetElapsedTimeMicros() : std::max(ofGetElapsedTimeMicros(), frames.back().get(ofxBlend2DFrameTimings::UploadEnd));
+    }
+    const uint64_t windowStart = windowEnd>windowMicros ? windowEnd-windowMicros : 0;
+    if(!bTimelineFrozen){
+        // Frames which ended before the window are left out
+        frames.erase(frames.begin(), std::find_if(frames.begin(), frames.end(), [windowStart](const ofxBlend2DFrameTimings& t){ return t.get(ofxBlend2DFrameTimings::UploadEnd)>=windowStart; }));
+    }
+
+    // Settings overlay
+    const uint32_t lastErrors = lastContextErrorFlags;
+    // The thread count the shown frames were rendered with (tuner, governor or settings)
+    if(!frames.empty()) ImGui::Text("Threads: %u", frames.back().threadCount);
+    else ImGui::TextDisabled("Threads: -");
+    ImGui::SameLine();
+    if(lastErrors!=0) ImGui::TextColored(ImVec4(1.f, .4f, .3f, 1.f), "%s", getContextErrors(lastErrors).c_str());
+    else ImGui::TextDisabled("No context errors");
+
+    // Lanes
+    struct Lane { const char* name; ofxBlend2DFrameTimings::Stamp from; ofxBlend2DFrameTimings::Stamp to; };
+    static const Lane lanes[] = {
+        { "Submit", ofxBlend2DFrameTimings::SubmitBegin, ofxBlend2DFrameTimings::SubmitEnd },
+        { "Flush", ofxBlend2DFrameTimings::FlushBegin, ofxBlend2DFrameTimings::FlushEnd },
+        { "Encode", ofxBlend2DFrameTimings::EncodeBegin, ofxBlend2DFrameTimings::EncodeEnd },
+        { "Upload", ofxBlend2DFrameTimings::UploadBegin, ofxBlend2DFrameTimings::UploadEnd },
+    };
+    static const int numLanes = IM_ARRAYSIZE(lanes);
+    const float labelWidth = ImGui::CalcTextSize("Encode ").x;
+    const float width = glm::max(ImGui::GetContentRegionAvail().x, labelWidth+50.f);
+    const float height = laneHeight*numLanes;
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImGui::InvisibleButton("##timeline", ImVec2(width, height));
+    const bool bHovered = ImGui::IsItemHovered();
+    bTimelineFrozen = bHovered && ImGui::IsKeyDown(ImGuiMod_Shift);
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    const float x0 = origin.x+labelWidth;
+    const float plotWidth = width-labelWidth;
+    drawList->AddRectFilled(ImVec2(x0, origin.y), ImVec2(origin.x+width, origin.y+height), ImGui::GetColorU32(ImGuiCol_FrameBg));
+    for(int lane=0; lane<numLanes; ++lane){
+        drawList->AddText(ImVec2(origin.x, origin.y+lane*laneHeight), ImGui::GetColorU32(ImGuiCol_TextDisabled), lanes[lane].name);
+    }
+    // 10 ms grid
+    for(uint64_t t=windowStart-(windowStart%10000)+10000; t<windowEnd; t+=10000){
+        const float x = x0+plotWidth*float(t-windowStart)/windowMicros;
+        drawList->AddLine(ImVec2(x, origin.y), ImVec2(x, origin.y+height), ImGui::GetColorU32(ImGuiCol_Separator));
+    }
+
+    const ofxBlend2DFrameTimings* hoveredFrame = nullptr;
+    const ImVec2 mouse = ImGui::GetMousePos();
+    for(const ofxBlend2DFrameTimings& frame : frames){
+        // Alternating colors to tell frames apart, errors in red
+        const ImU32 color = frame.contextErrorFlags!=0 ? IM_COL32(230, 80, 60, 255) : ((frame.frameNum%2)==0 ? IM_COL32(80, 160, 230, 255) : IM_COL32(110, 200, 130, 255));
+        for(int lane=0; lane<numLanes; ++lane){
+            const uint64_t from = frame.get(lanes[lane].from);
+            const uint64_t to = frame.get(lanes[lane].to);
+            if(from==0 || to<from || to<windowStart) continue;
+            const float xFrom = x0+plotWidth*float((double)(std::max(from, windowStart)-windowStart)/windowMicros);
+            const float xTo = glm::max(xFrom+1.f, x0+plotWidth*float((double)(to-windowStart)/windowMicros)); // At least a pixel
+            const ImVec2 min(xFrom, origin.y+lane*laneHeight+1.f);
+            const ImVec2 max(glm::min(xTo, origin.x+width), origin.y+(lane+1)*laneHeight-1.f);
+            drawList->AddRectFilled(min, max, color);
+            if(bHovered && mouse.x>=min.x && mouse.x<=max.x && mouse.y>=min.y && mouse.y<=max.y) hoveredFrame = &frame;
+        }
+    }
+
+    // Details
+    if(hoveredFrame!=nullptr && ImGui::BeginTooltip()){
+        const ofxBlend2DFrameTimings& t = *hoveredFrame;
+        ImGui::Text("Frame %u (app frame %llu, shown at %llu)", t.frameNum, (unsigned long long)t.submitAppFrame, (unsigned long long)t.uploadAppFrame);
+        ImGui::Text("Submit %.2f ms, flush %.2f ms, encode %.2f ms, upload %.2f ms",
+            t.getDuration(ofxBlend2DFrameTimings::SubmitBegin, ofxBlend2DFrameTimings::SubmitEnd)/1000.f,
+            t.getDuration(ofxBlend2DFrameTimings::FlushBegin, ofxBlend2DFrameTimings::FlushEnd)/1000.f,
+            t.getDuration(ofxBlend2DFrameTimings::EncodeBegin, ofxBlend2DFrameTimings::EncodeEnd)/1000.f,
+            t.getDuration(ofxBlend2DFrameTimings::UploadBegin, ofxBlend2DFrameTimings::UploadEnd)/1000.f);
+        ImGui::Text("Latency %.2f ms, %u dropped before", t.getDuration(ofxBlend2DFrameTimings::SubmitEnd, ofxBlend2DFrameTimings::UploadEnd)/1000.f, t.numDropped);
+        if(t.contextErrorFlags!=0) ImGui::Text("%s", getContextErrors(t.contextErrorFlags).c_str());
+        ImGui::EndTooltip();
+    }
+    else if(bHovered){
+        ImGui::SetTooltip("Hold shift to freeze.");
+    }
+
     ImGui::PopID();
 }
 #endif // end ofxBlend2D_ENABLE_IMGUI
@@ -9,16 +9,29 @@
 
 // Threads & locks
 #include "ofThread.h"
-#include "ofThreadChannel.h"
-//#include <atomic>
+#include "ofxBlend2DSpscQueue.h"
+#include "ofxBlend2DFrame.h"
+#include "ofxBlend2DFrameProfiler.h"
+#include "ofxBlend2DQualityGovernor.h"
+#include "ofxBlend2DThreadTuner.h"
+#include "ofxBlend2DJitPrewarmer.h"
+#include "ofxBlend2DContextConfig.h"
+#include "ofxBlend2DShmExporter.h"
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+
+#include "ofEvents.h"
 
 // Tips:
 // Blend2D debugging help : Set breakpoint @blTraceError in blend2d/src/api.h
 
 // Mutex logics in this class :
-// BLContext and BLxxx vars are protected by a channel mutex.
+// BLContext and BLxxx vars are handed over through lock-free queues : whoever holds the frame data owns it.
 // The GL thread sends a message to the threaded worker, which handles the data and sends back the result
 // BLTypes are only accessible between begin() and end() for thread safety.
+// In producer mode (startProducer()), begin() and end() are called by a renderer-owned thread instead of the GL thread.
 
 #define ofxBlend2D_FPS_HISTORY_SIZE 120
 
@@ -58,7 +71,8 @@ namespace ofxBlend2D {
 class ofxBlend2DThreadedRenderer : protected ofThread {
 
     public:
-        ofxBlend2DThreadedRenderer();
+        // Without texture uploads (headless apps, no GL context), update() still receives the frames : use getFrame(), tickets or the profiler
+        explicit ofxBlend2DThreadedRenderer(bool uploadTextures=true);
         ~ofxBlend2DThreadedRenderer();
 
         // Sets the size
@@ -66,14 +80,56 @@ class ofxBlend2DThreadedRenderer : protected ofThread {
 
         // Start submitting draw commands to context
         bool begin();
-        bool end(unsigned int frameNum, std::string frameFileToSave="");
+        // The returned ticket completes when the frame's pixels are ready (invalid if the frame couldn't be submitted)
+        ofxBlend2DFrameTicket end(unsigned int frameNum, std::string frameFileToSave="");
         bool update(const bool waitForThread=false, const bool noFrameSkipping=false);
         bool hasNewFrame();
 
         BLContext& getBlContext();
+        // Error flags of the current context between begin() and end(), of the last rendered frame otherwise
         std::string getContextErrors();
+        static std::string getContextErrors(uint32_t errorFlags);
 
         ofTexture& getTexture();
+
+        // The most recent frame received by update() (pixels shared with the texture upload, no copy).
+        // Keep the handle as long as you need the pixels, from any thread.
+        ofxBlend2DFrame getFrame() const {
+            return currentFrame;
+        }
+        // Notified from the worker thread as soon as a frame is ready, before update() receives it.
+        // Listeners must be thread safe and quick (they delay the next frame), ex: keep the frame for a recorder or wake up another thread.
+        // The texture can only be updated from the GL thread : call update() there.
+        ofEvent<const ofxBlend2DFrame> frameReadyEvent;
+
+        // Per stage timings of the uploaded frames (submit, flush, encode, upload), without ofxFps.
+        // Readable from any thread, ex: getProfiler().getSummary(ofxBlend2DFrameProfiler::TotalSpan).p95Ms
+        // Also tracks latency : submit to upload time, app frames behind and dropped frames, see getProfiler().getLatencyStats()
+        const ofxBlend2DFrameProfiler& getProfiler() const {
+            return profiler;
+        }
+        ofxBlend2DFrameProfiler& getProfiler() {
+            return profiler;
+        }
+
+        // Lowers the rendering quality when the render times (submit + flush) exceed a budget, disabled by default.
+        // Ex: getQualityGovernor().bEnabled = true; (bounds in getQualityGovernor().setSettings())
+        const ofxBlend2DQualityGovernor& getQualityGovernor() const {
+            return qualityGovernor;
+        }
+        ofxBlend2DQualityGovernor& getQualityGovernor() {
+            return qualityGovernor;
+        }
+
+        bool isUploadingTextures() const {
+            return bUploadTextures;
+        }
+
+        // Canvases recycled between frames, ex: getCanvasPool()->getNumAllocated() to watch allocations
+        std::shared_ptr<ofxBlend2DCanvasPool> getCanvasPool() const {
+            return canvasPool;
+        }
+
         GLint getTexturePixelFormat() const {
             return glInternalFormatTexture;
         }
@@ -83,9 +139,79 @@ class ofxBlend2DThreadedRenderer : protected ofThread {
             tex.clear();
         }
 
+        // Publishes every finished frame to other processes. Frames are drawn directly in the shared slots when the size and format match.
+        // Pass nullptr to stop exporting.
+        void setShmExporter(std::shared_ptr<ofxBlend2DShmExporter> exporter){
+            std::unique_lock<std::mutex> lock(producerMutex);
+            shmExporter = std::move(exporter);
+        }
+        std::shared_ptr<ofxBlend2DShmExporter> getShmExporter() const {
+            return shmExporter;
+        }
+
+        // Context creation options of the next frames (thread count, create flags, limits), see ofxBlend2DContextConfig
+        void setContextConfig(const ofxBlend2DContextConfig& config){
+            std::unique_lock<std::mutex> lock(producerMutex);
+            createInfo = config.toCreateInfo();
+            threadTuner.invalidate(); // Its render times were measured with the previous options
+        }
+        ofxBlend2DContextConfig getContextConfig() const {
+            return ofxBlend2DContextConfig::fromCreateInfo(createInfo);
+        }
+
+        // Ignored while auto tuning
         void setNumThreads(const int numThreads){
+            std::unique_lock<std::mutex> lock(producerMutex);
             createInfo.thread_count = numThreads;
         }
+        // The thread count of the next frames : the tuned one when auto tuning (also see getThreadTuner().isProbing())
+        uint32_t getNumThreads() const {
+            return threadTuner.bEnabled ? threadTuner.getBestThreadCount() : createInfo.thread_count;
+        }
+
+        // Probes thread counts on the rendered frames and keeps the fastest, see ofxBlend2DThreadTuner.
+        // Overrides setNumThreads() and the quality governor's maxThreads.
+        void setAutoThreads(bool autoThreads){
+            threadTuner.invalidate(); // Before enabling : the producer may add a frame meanwhile
+            threadTuner.bEnabled = autoThreads;
+        }
+        bool isAutoThreads() const {
+            return threadTuner.bEnabled;
+        }
+        const ofxBlend2DThreadTuner& getThreadTuner() const {
+            return threadTuner;
+        }
+        ofxBlend2DThreadTuner& getThreadTuner() {
+            return threadTuner;
+        }
+
+        // Compiles the fill pipelines before the first frames, see ofxBlend2DJitPrewarmer. Call after allocate().
+        // Empty settings.formats = the canvas format, the renderer's context flags are added to settings.contextFlags.
+        // Blocking (returns the report) or on a background thread (returns an empty report). Both keep it in getPrewarmer().getReport().
+        ofxBlend2DJitPrewarmer::Report prewarm(ofxBlend2DJitPrewarmer::Settings settings = ofxBlend2DJitPrewarmer::Settings(), bool background=false);
+        const ofxBlend2DJitPrewarmer& getPrewarmer() const {
+            return prewarmer;
+        }
+
+        // Producer mode : a thread owned by the renderer calls drawFunction between begin() and end(),
+        // at targetFps or as fast as the pipeline allows (targetFps=0), independently of the app's frame rate.
+        // New frames are uploaded on the app's update event, begin(), end() and update() must not be called meanwhile.
+        // Settings changed from drawFunction (ex: setNumThreads()) apply from the next frame.
+        typedef std::function<void(BLContext& ctx, unsigned int frameNum)> DrawFunction;
+        bool startProducer(DrawFunction drawFunction, float targetFps=0.f);
+        void stopProducer();
+        bool isProducing() const {
+            return bProducerRunning;
+        }
+        void setProducerFps(float targetFps){
+            producerFps = targetFps;
+        }
+        float getProducerFps() const {
+            return producerFps;
+        }
+        unsigned int getProducedFrames() const {
+            return producedFrames;
+        }
 
 #ifdef ofxBlend2D_ENABLE_OFXFPS
         float getFps();
@@ -103,40 +229,67 @@ class ofxBlend2DThreadedRenderer : protected ofThread {
         }
 
         // Threads
+        // The worker exits after its current frame, frames submitted meanwhile wait for startBlThread()
         void stopBlThread();
+        // Waits for a stopping worker to exit first
         void startBlThread();
 
 #ifdef ofxBlend2D_ENABLE_IMGUI
         void drawImGuiSettings();
+        // Pipeline lanes (submit, worker flush, encode, GL upload) of the last timeWindowMs, from the profiler.
+        // Hover a frame for details, hold shift to freeze it.
+        void drawImGuiTimeline(float timeWindowMs=100.f, float laneHeight=14.f);
 #endif
 
         // A struct send to the thread with additional parameters
         // /!\ Takes ownership of ctx
         struct ofxBlend2DThreadedRendererData {
             BLContext ctx;
+            BLImage img; // The context's target, so the worker doesn't touch the renderer's members
             unsigned int frameNum;
             std::string fileToSave; // saves frame to location if not empty (threaded)
+            ofxBlend2DFrameTimings timings; // Submission stamps, completed by the worker
+            ofxBlend2DFrameTicket ticket; // Completed by the worker
+            std::shared_ptr<ofxBlend2DShmExporter> exporter; // Publishes the frame when set
+            bool isPooledCanvas; // False when img is a shared memory slot
             bool isValid;
             //ofxBlend2DThreadedRendererData() = delete;
             ofxBlend2DThreadedRendererData() :
                 ctx(),
+                img(),
                 frameNum(0u),
                 fileToSave(""),
+                timings(),
+                ticket(),
+                exporter(),
+                isPooledCanvas(true),
                 isValid(false)
             {
 
             }
-            ofxBlend2DThreadedRendererData(BLContext&& _ctx, unsigned int _frameNum, std::string _fileToSave="") :
+            ofxBlend2DThreadedRendererData(BLContext&& _ctx, BLImage&& _img, unsigned int _frameNum, std::string _fileToSave="", const ofxBlend2DFrameTimings& _timings=ofxBlend2DFrameTimings(), ofxBlend2DFrameTicket _ticket=ofxBlend2DFrameTicket(), std::shared_ptr<ofxBlend2DShmExporter> _exporter=nullptr, bool _isPooledCanvas=true) :
                 ctx(std::move(_ctx)),
+                img(std::move(_img)),
                 frameNum(_frameNum),
                 fileToSave(_fileToSave),
+                timings(_timings),
+                ticket(std::move(_ticket)),
+                exporter(std::move(_exporter)),
+                isPooledCanvas(_isPooledCanvas),
                 isValid(true)
             {
 
             }
+            // Move only (queue slots)
+            ofxBlend2DThreadedRendererData(const ofxBlend2DThreadedRendererData&) = delete;
+            ofxBlend2DThreadedRendererData& operator=(const ofxBlend2DThreadedRendererData&) = delete;
+            ofxBlend2DThreadedRendererData(ofxBlend2DThreadedRendererData&&) = default;
+            ofxBlend2DThreadedRendererData& operator=(ofxBlend2DThreadedRendererData&&) = default;
             ~ofxBlend2DThreadedRendererData(){
                 // Releases ctx when done
                 ctx.end();
+                // Frames dropped without being rendered don't keep waiters blocked
+                ticket.complete(ofxBlend2DFrame());
                 isValid = false;
             };
         };
@@ -150,15 +303,30 @@ class ofxBlend2DThreadedRenderer : protected ofThread {
         BLFormat blInternalFormat = BLFormat::BL_FORMAT_NONE;
 
 
-        bool bIsDirty = false; // Note: also protects some threaded variables
-        bool isSubmittingDrawCmds = false;
+        std::atomic<bool> bIsDirty{false}; // Note: also protects some threaded variables
+        std::atomic<bool> isSubmittingDrawCmds{false}; // Set by the submitting thread (the producer when running), read by the others
         unsigned int renderedFrames = 0;
         bool bRenderHD = true;
+        const bool bUploadTextures;
 
         // Blend2D objects
         // Protected as channels
         BLContext ctx; // Canvas context
-        BLImage img; // Canvas
+        BLImage img; // Canvas (from canvasPool or shmExporter, handed to the worker by end())
+        bool bImgFromPool = true;
+        std::shared_ptr<ofxBlend2DCanvasPool> canvasPool = std::make_shared<ofxBlend2DCanvasPool>();
+        std::shared_ptr<ofxBlend2DShmExporter> shmExporter;
+        std::shared_ptr<ofxBlend2DShmExporter> frameShmExporter; // shmExporter at begin(), the one img may come from
+        ofxBlend2DFrame currentFrame; // Latest frame received by update()
+        uint64_t frameBeginTime = 0;
+        uint64_t frameBeginAppFrame = 0;
+        std::atomic<uint32_t> numDroppedByWorker{0}; // Reported with the next upload
+        std::atomic<uint32_t> lastContextErrorFlags{0}; // Set by the worker
+        ofxBlend2DFrameProfiler profiler; // Written by update()
+        ofxBlend2DQualityGovernor qualityGovernor; // Fed by update(), applied by begin()
+        ofxBlend2DThreadTuner threadTuner; // Fed by update(), read by begin()
+        uint32_t frameThreadCount = 0; // Of the context between begin() and end()
+        ofxBlend2DJitPrewarmer prewarmer;
         //BLImageCodec codec;
 
         // OF Objects
@@ -172,10 +340,30 @@ class ofxBlend2DThreadedRenderer : protected ofThread {
 
         // Threads
         void threadedFunction() override;
-        ofThreadChannel<BLImageData> pixelDataFromThread;
-        ofThreadChannel<ofxBlend2DThreadedRendererData> flushFrameSignal;
+        ofxBlend2DSpscQueue<ofxBlend2DFrame, 4> pixelDataFromThread; // Worker -> GL thread
+        ofxBlend2DSpscQueue<ofxBlend2DThreadedRendererData, 4> flushFrameSignal; // Submitting thread -> worker
 
         bool loadImageDataIntoTexture(const BLImageData* data);
+
+        // Producer mode
+        void producerFunction();
+        void onAppUpdate(ofEventArgs& args);
+        std::thread producerThread;
+        DrawFunction producerDraw;
+        std::atomic<bool> bProducerRunning{false};
+        std::atomic<float> producerFps{0.f};
+        std::atomic<unsigned int> producedFrames{0};
+        std::mutex producerMutex; // Held by the producer during begin() (not while drawing), protects the size and settings
+        std::mutex producerWaitMutex; // Only for waiting on producerCondition
+        std::condition_variable producerCondition; // Notified when the pipeline becomes available
+
+#ifdef ofxBlend2D_ENABLE_IMGUI
+        // Timeline snapshot (see drawImGuiTimeline()), frozen while shift is held over it
+        std::vector<ofxBlend2DFrameTimings> timelineFrames;
+        uint64_t timelineWindowEnd = 0;
+        bool bTimelineFrozen = false;
+        float timelineWindowMs = 100.f;
+#endif
 };
 
 // ImGui Helpers
@@ -0,0 +1,265 @@
+#include "ofxBlend2DBatchSubmitter.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+bool ofxBlend2DBatchSubmitter::StateKey::operator==(const StateKey& other) const {
+    if(kind!=other.kind || compOp!=other.compOp || color!=other.color) return false;
+    if(kind==Fill) return fillRule==other.fillRule;
+    return hasSameStrokeParams(other);
+}
+
+bool ofxBlend2DBatchSubmitter::StateKey::hasSameStrokeParams(const StateKey& other) const {
+    return strokeWidth==other.strokeWidth && miterLimit==other.miterLimit && strokeJoin==other.strokeJoin && strokeCap==other.strokeCap;
+}
+
+void ofxBlend2DBatchSubmitter::add(const BLPath& path, const ofxBlend2DPathStyle& style, const BLBox* bounds){
+    addOps(path, style, BLMatrix2D::make_identity(), false, bounds);
+}
+
+void ofxBlend2DBatchSubmitter::add(const BLPath& path, const ofxBlend2DPathStyle& style, const BLMatrix2D& transform, const BLBox* bounds){
+    addOps(path, style, transform, true, bounds);
+}
+
+void ofxBlend2DBatchSubmitter::addOps(const BLPath& path, const ofxBlend2DPathStyle& style, const BLMatrix2D& transform, bool hasTransform, const BLBox* bounds){
+    if(!style.isVisible || path.is_empty()) return;
+    if(!style.isFilled && !style.isStroked()) return;
+    isSorted = false;
+
+    // Bounds in pre-context space
+    BLBox box;
+    if(bounds!=nullptr){
+        box = *bounds;
+    }
+    else {
+        BLBox local;
+        if(path.get_bounding_box(&local)!=BL_SUCCESS) return;
+        const BLPoint corners[4] = {
+            transform.map_point(local.x0, local.y0),
+            transform.map_point(local.x1, local.y0),
+            transform.map_point(local.x1, local.y1),
+            transform.map_point(local.x0, local.y1),
+        };
+        box = BLBox(corners[0].x, corners[0].y, corners[0].x, corners[0].y);
+        for(const BLPoint& p : corners){
+            box.x0 = std::min(box.x0, p.x); box.y0 = std::min(box.y0, p.y);
+            box.x1 = std::max(box.x1, p.x); box.y1 = std::max(box.y1, p.y);
+        }
+    }
+
+    Op op;
+    op.path = path;
+    op.transform = transform;
+    op.hasTransform = hasTransform;
+    op.key.compOp = style.compOp;
+
+    if(style.isFilled){
+        op.key.kind = Fill;
+        op.key.color = style.getBLFillColor().value;
+        op.key.fillRule = style.fillRule;
+        op.bounds = BLBox(box.x0-boundsPadding, box.y0-boundsPadding, box.x1+boundsPadding, box.y1+boundsPadding);
+        ops.push_back(op);
+    }
+
+    if(style.isStroked()){
+        op.key.kind = Stroke;
+        op.key.color = style.getBLStrokeColor().value;
+        op.key.fillRule = BL_FILL_RULE_NON_ZERO;
+        op.key.strokeWidth = style.strokeWidth;
+        op.key.miterLimit = style.miterLimit;
+        op.key.strokeJoin = style.strokeJoin;
+        op.key.strokeCap = style.strokeCap;
+
+        // Stroke outset : miters can reach miterLimit*width/2, square caps sqrt(2)*width/2
+        double outset = style.strokeWidth*0.5*1.41421356237;
+        if(style.strokeJoin==BL_STROKE_JOIN_MITER_CLIP || style.strokeJoin==BL_STROKE_JOIN_MITER_BEVEL || style.strokeJoin==BL_STROKE_JOIN_MITER_ROUND){
+            outset = std::max(outset, style.strokeWidth*0.5*style.miterLimit);
+        }
+        // The stroke width is in path space, scale it like the transform does (upper bound)
+        const double scale = std::max(std::hypot(transform.m00, transform.m01), std::hypot(transform.m10, transform.m11));
+        outset = outset*scale + boundsPadding;
+        op.bounds = BLBox(box.x0-outset, box.y0-outset, box.x1+outset, box.y1+outset);
+        ops.push_back(op);
+    }
+}
+
+void ofxBlend2DBatchSubmitter::clear(){
+    ops.clear();
+    runs.clear();
+    isSorted = false;
+    stats = Stats();
+}
+
+void ofxBlend2DBatchSubmitter::reserve(std::size_t numPaths){
+    ops.reserve(numPaths*2);
+}
+
+bool ofxBlend2DBatchSubmitter::isBarrier(BLCompOp compOp){
+    switch(compOp){
+        case BL_COMP_OP_SRC_COPY:
+        case BL_COMP_OP_SRC_IN:
+        case BL_COMP_OP_SRC_OUT:
+        case BL_COMP_OP_DST_IN:
+        case BL_COMP_OP_DST_ATOP:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool ofxBlend2DBatchSubmitter::overlaps(const BLBox& a, const BLBox& b){
+    // Touching counts as overlapping (conservative)
+    return a.x0<=b.x1 && b.x0<=a.x1 && a.y0<=b.y1 && b.y0<=a.y1;
+}
+
+bool ofxBlend2DBatchSubmitter::overlapsRun(const Run& run, const BLBox& bounds) const {
+    if(!overlaps(run.bounds, bounds)) return false;
+    // Only the ops of overlapping groups and blocks (nearby ops in document order are usually nearby on the canvas)
+    for(std::size_t group=0; group<run.groupBounds.size(); ++group){
+        if(!overlaps(run.groupBounds[group], bounds)) continue;
+        const std::size_t lastBlock = std::min(run.blockBounds.size(), (group+1)*blocksPerGroup);
+        for(std::size_t block=group*blocksPerGroup; block<lastBlock; ++block){
+            if(!overlaps(run.blockBounds[block], bounds)) continue;
+            const std::size_t last = std::min(run.ops.size(), (block+1)*opsPerBlock);
+            for(std::size_t i=block*opsPerBlock; i<last; ++i){
+                if(overlaps(ops[run.ops[i]].bounds, bounds)) return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ofxBlend2DBatchSubmitter::addToRun(Run& run, std::size_t opIndex, const BLBox& bounds){
+    auto grow = [](BLBox& box, const BLBox& other){
+        box.x0 = std::min(box.x0, other.x0); box.y0 = std::min(box.y0, other.y0);
+        box.x1 = std::max(box.x1, other.x1); box.y1 = std::max(box.y1, other.y1);
+    };
+    if(run.ops.empty()) run.bounds = bounds;
+    else grow(run.bounds, bounds);
+    if(run.ops.size()%opsPerBlock==0) run.blockBounds.push_back(bounds);
+    else grow(run.blockBounds.back(), bounds);
+    if(run.ops.size()%(opsPerBlock*blocksPerGroup)==0) run.groupBounds.push_back(bounds);
+    else grow(run.groupBounds.back(), bounds);
+    run.ops.push_back(opIndex);
+}
+
+void ofxBlend2DBatchSubmitter::sortOps(){
+    runs.clear();
+    for(std::size_t i=0; i<ops.size(); ++i){
+        const Op& op = ops[i];
+        const bool barrier = isBarrier(op.key.compOp);
+
+        // Search back for the earliest run with the same state that can be reached without crossing an overlapping op.
+        // Keys are compared first (cheap) : without a matching run before the last one, no overlap test is needed.
+        std::size_t target = runs.size();
+        if(!barrier){
+            const std::size_t lookbackEnd = runs.size()>maxLookback ? runs.size()-maxLookback : 0;
+            std::size_t earliestMatch = runs.size();
+            for(std::size_t r=runs.size(); r-->lookbackEnd;){
+                if(runs[r].isBarrier) break;
+                if(runs[r].key==op.key) earliestMatch = r;
+            }
+            if(earliestMatch+1==runs.size()){
+                target = earliestMatch; // The last run : joining it never crosses anything
+            }
+            else if(earliestMatch<runs.size()){
+                for(std::size_t r=runs.size(); r-->earliestMatch;){
+                    const Run& run = runs[r];
+                    if(run.key==op.key) target = r;
+                    if(r==earliestMatch || overlapsRun(run, op.bounds)) break; // Can't move before this run (but may join it, done above)
+                }
+            }
+        }
+
+        if(target==runs.size()){
+            runs.emplace_back();
+            runs.back().key = op.key;
+            runs.back().isBarrier = barrier;
+        }
+        addToRun(runs[target], i, op.bounds);
+    }
+
+    // Stats
+    std::vector<std::size_t> order;
+    order.reserve(ops.size());
+    for(const Run& run : runs){
+        order.insert(order.end(), run.ops.begin(), run.ops.end());
+    }
+    std::vector<std::size_t> documentOrder(ops.size());
+    for(std::size_t i=0; i<ops.size(); ++i) documentOrder[i] = i;
+
+    stats.numOps = ops.size();
+    stats.numRuns = runs.size();
+    stats.stateChanges = countStateChanges(order);
+    stats.stateChangesUnsorted = countStateChanges(documentOrder);
+    isSorted = true;
+}
+
+std::size_t ofxBlend2DBatchSubmitter::countStateChanges(const std::vector<std::size_t>& order) const {
+    std::size_t changes = 0;
+    const StateKey* previous = nullptr;
+    for(std::size_t opIndex : order){
+        const StateKey& key = ops[opIndex].key;
+        if(previous==nullptr || *previous!=key) changes++;
+        previous = &key;
+    }
+    return changes;
+}
+
+const ofxBlend2DBatchSubmitter::Stats& ofxBlend2DBatchSubmitter::getStats(){
+    if(!isSorted) sortOps();
+    return stats;
+}
+
+void ofxBlend2DBatchSubmitter::submit(BLContext& ctx){
+    if(!isSorted) sortOps();
+    if(runs.empty()) return;
+
+    ctx.save();
+    const BLMatrix2D baseTransform = ctx.user_transform();
+    const BLMatrix2D* currentTransform = nullptr;
+
+    const StateKey* previous = nullptr;
+    for(const Run& run : runs){
+        const StateKey& key = run.key;
+
+        // Only set what differs from the previous run
+        if(previous==nullptr || previous->compOp!=key.compOp) ctx.set_comp_op(key.compOp);
+        if(key.kind==Fill){
+            if(previous==nullptr || previous->kind!=Fill || previous->fillRule!=key.fillRule) ctx.set_fill_rule(key.fillRule);
+            ctx.set_fill_style(BLRgba32(key.color));
+        }
+        else {
+            if(previous==nullptr || previous->kind!=Stroke || !previous->hasSameStrokeParams(key)){
+                ctx.set_stroke_width(key.strokeWidth);
+                ctx.set_stroke_miter_limit(key.miterLimit);
+                ctx.set_stroke_join(key.strokeJoin);
+                ctx.set_stroke_caps(key.strokeCap);
+            }
+            ctx.set_stroke_style(BLRgba32(key.color));
+        }
+        previous = &key;
+
+        for(std::size_t opIndex : run.ops){
+            const Op& op = ops[opIndex];
+            // Transforms are only set when they change between consecutive ops
+            if(op.hasTransform){
+                if(currentTransform==nullptr || std::memcmp(currentTransform, &op.transform, sizeof(BLMatrix2D))!=0){
+                    BLMatrix2D m = op.transform;
+                    m.post_transform(baseTransform);
+                    ctx.set_transform(m);
+                    currentTransform = &op.transform;
+                }
+            }
+            else if(currentTransform!=nullptr){
+                ctx.set_transform(baseTransform);
+                currentTransform = nullptr;
+            }
+
+            if(op.key.kind==Fill) ctx.fill_path(op.path);
+            else ctx.stroke_path(op.path);
+        }
+    }
+    ctx.restore();
+}
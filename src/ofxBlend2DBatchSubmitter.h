@@ -0,0 +1,100 @@
+#pragma once
+
+#include "blend2d/blend2d.h"
+#include "ofxBlend2DPathStyle.h"
+
+#include <vector>
+#include <cstdint>
+
+// Style-sorted batch submission
+// - - - -
+// Drawing a scene in document order alternates fills and strokes of different styles, changing the context state for every element.
+// The submitter collects the draw operations (a fill and/or a stroke per path), then groups them into runs sharing the same state
+// (comp op, fill rule / stroke parameters and color) so the context state changes once per run instead of once per element.
+// An operation only moves to an earlier run when it doesn't overlap (by cached bounds) anything drawn in between,
+// so the visual result is identical to document order.
+// Comp ops which can affect pixels outside of the shape (SRC_COPY, SRC_IN, SRC_OUT, DST_IN, DST_ATOP) are never reordered : they act as barriers.
+// The order is computed once and reused by submit() until the content changes.
+
+class ofxBlend2DBatchSubmitter {
+    public:
+        struct Stats {
+            std::size_t numOps = 0;
+            std::size_t numRuns = 0;
+            std::size_t stateChanges = 0; // With the sorted order
+            std::size_t stateChangesUnsorted = 0; // What document order would have needed
+        };
+
+        // Paths are stored by reference (BLPath is reference counted), bounds are computed here unless provided.
+        // The transform is applied on top of the context transform at submit time, bounds must be in that same (pre-context) space.
+        void add(const BLPath& path, const ofxBlend2DPathStyle& style, const BLBox* bounds=nullptr);
+        void add(const BLPath& path, const ofxBlend2DPathStyle& style, const BLMatrix2D& transform, const BLBox* bounds=nullptr);
+        void clear();
+        void reserve(std::size_t numPaths);
+
+        // Draws all operations, restoring the context state afterwards.
+        void submit(BLContext& ctx);
+
+        const Stats& getStats();
+
+        // Added around bounds before overlap tests, covers antialiasing (in pre-context units)
+        double boundsPadding = 1.0;
+        // How many runs are searched back for a matching style (bounds the sorting cost)
+        std::size_t maxLookback = 64;
+
+    protected:
+        enum OpKind : uint8_t {
+            Fill = 0,
+            Stroke = 1,
+        };
+
+        // Everything a run shares, ie. the state set once per run
+        struct StateKey {
+            OpKind kind = Fill;
+            BLCompOp compOp = BL_COMP_OP_SRC_OVER;
+            uint32_t color = 0;
+            BLFillRule fillRule = BL_FILL_RULE_NON_ZERO;
+            float strokeWidth = 0.f;
+            float miterLimit = 0.f;
+            BLStrokeJoin strokeJoin = BL_STROKE_JOIN_MITER_CLIP;
+            BLStrokeCap strokeCap = BL_STROKE_CAP_BUTT;
+
+            bool operator==(const StateKey& other) const;
+            // Width, miter limit, join and cap (not the color)
+            bool hasSameStrokeParams(const StateKey& other) const;
+            bool operator!=(const StateKey& other) const { return !(*this==other); }
+        };
+
+        struct Op {
+            BLPath path;
+            BLMatrix2D transform;
+            bool hasTransform = false;
+            BLBox bounds;
+            StateKey key;
+        };
+
+        struct Run {
+            StateKey key;
+            BLBox bounds; // Union of its ops
+            std::vector<std::size_t> ops;
+            // Unions of each opsPerBlock consecutive ops and of each blocksPerGroup blocks : overlap tests skip most of a large run
+            std::vector<BLBox> blockBounds;
+            std::vector<BLBox> groupBounds;
+            bool isBarrier = false;
+        };
+        static constexpr std::size_t opsPerBlock = 32;
+        static constexpr std::size_t blocksPerGroup = 32;
+
+        void addOps(const BLPath& path, const ofxBlend2DPathStyle& style, const BLMatrix2D& transform, bool hasTransform, const BLBox* bounds);
+        static bool isBarrier(BLCompOp compOp);
+        static bool overlaps(const BLBox& a, const BLBox& b);
+        bool overlapsRun(const Run& run, const BLBox& bounds) const;
+        static void addToRun(Run& run, std::size_t opIndex, const BLBox& bounds);
+        void sortOps();
+        std::size_t countStateChanges(const std::vector<std::size_t>& order) const;
+
+        std::vector<Op> ops;
+        std::vector<Run> runs;
+        bool isSorted = false;
+        Stats stats;
+};
@@ -0,0 +1,234 @@
+#include "ofxBlend2DCommandBuffer.h"
+
+ofxBlend2DCommandBuffer::Command& ofxBlend2DCommandBuffer::push(CommandType type){
+    commands.emplace_back();
+    Command& cmd = commands.back();
+    cmd.type = type;
+    cmd.hasColor = false;
+    cmd.value = 0;
+    cmd.color = 0;
+    return cmd;
+}
+
+ofxBlend2DCommandBuffer::Command& ofxBlend2DCommandBuffer::pushDraw(CommandType type, const BLRgba32* color){
+    Command& cmd = push(type);
+    if(color!=nullptr){
+        cmd.hasColor = true;
+        cmd.color = color->value;
+    }
+    return cmd;
+}
+
+static void setMatrix(double* v, const BLMatrix2D& m){
+    v[0] = m.m00; v[1] = m.m01;
+    v[2] = m.m10; v[3] = m.m11;
+    v[4] = m.m20; v[5] = m.m21;
+}
+
+static BLMatrix2D getMatrix(const double* v){
+    return BLMatrix2D(v[0], v[1], v[2], v[3], v[4], v[5]);
+}
+
+// - - - - State
+
+void ofxBlend2DCommandBuffer::save(){
+    push(Save);
+}
+
+void ofxBlend2DCommandBuffer::restore(){
+    push(Restore);
+}
+
+void ofxBlend2DCommandBuffer::set_transform(const BLMatrix2D& m){
+    setMatrix(push(SetTransform).v, m);
+}
+
+void ofxBlend2DCommandBuffer::reset_transform(){
+    push(ResetTransform);
+}
+
+void ofxBlend2DCommandBuffer::apply_transform(const BLMatrix2D& m){
+    setMatrix(push(ApplyTransform).v, m);
+}
+
+void ofxBlend2DCommandBuffer::translate(double x, double y){
+    Command& cmd = push(Translate);
+    cmd.v[0] = x;
+    cmd.v[1] = y;
+}
+
+void ofxBlend2DCommandBuffer::scale(double x, double y){
+    Command& cmd = push(Scale);
+    cmd.v[0] = x;
+    cmd.v[1] = y;
+}
+
+void ofxBlend2DCommandBuffer::rotate(double angle){
+    push(Rotate).v[0] = angle;
+}
+
+void ofxBlend2DCommandBuffer::set_comp_op(BLCompOp compOp){
+    push(SetCompOp).value = compOp;
+}
+
+void ofxBlend2DCommandBuffer::set_global_alpha(double alpha){
+    push(SetGlobalAlpha).v[0] = alpha;
+}
+
+void ofxBlend2DCommandBuffer::set_fill_rule(BLFillRule fillRule){
+    push(SetFillRule).value = fillRule;
+}
+
+void ofxBlend2DCommandBuffer::set_fill_style(const BLRgba32& color){
+    push(SetFillStyle).value = color.value;
+}
+
+void ofxBlend2DCommandBuffer::set_stroke_style(const BLRgba32& color){
+    push(SetStrokeStyle).value = color.value;
+}
+
+void ofxBlend2DCommandBuffer::set_stroke_width(double width){
+    push(SetStrokeWidth).v[0] = width;
+}
+
+void ofxBlend2DCommandBuffer::set_stroke_join(BLStrokeJoin join){
+    push(SetStrokeJoin).value = join;
+}
+
+void ofxBlend2DCommandBuffer::set_stroke_caps(BLStrokeCap cap){
+    push(SetStrokeCaps).value = cap;
+}
+
+void ofxBlend2DCommandBuffer::set_stroke_miter_limit(double miterLimit){
+    push(SetStrokeMiterLimit).v[0] = miterLimit;
+}
+
+// - - - - Drawing
+
+void ofxBlend2DCommandBuffer::fill_all(){
+    pushDraw(FillAll, nullptr);
+}
+
+void ofxBlend2DCommandBuffer::fill_all(const BLRgba32& color){
+    pushDraw(FillAll, &color);
+}
+
+void ofxBlend2DCommandBuffer::fill_path(const BLPath& path){
+    pushDraw(FillPath, nullptr).value = (uint32_t)paths.size();
+    paths.push_back(path);
+}
+
+void ofxBlend2DCommandBuffer::fill_path(const BLPath& path, const BLRgba32& color){
+    pushDraw(FillPath, &color).value = (uint32_t)paths.size();
+    paths.push_back(path);
+}
+
+void ofxBlend2DCommandBuffer::stroke_path(const BLPath& path){
+    pushDraw(StrokePath, nullptr).value = (uint32_t)paths.size();
+    paths.push_back(path);
+}
+
+void ofxBlend2DCommandBuffer::stroke_path(const BLPath& path, const BLRgba32& color){
+    pushDraw(StrokePath, &color).value = (uint32_t)paths.size();
+    paths.push_back(path);
+}
+
+void ofxBlend2DCommandBuffer::fill_rect(double x, double y, double w, double h){
+    Command& cmd = pushDraw(FillRect, nullptr);
+    cmd.v[0] = x; cmd.v[1] = y; cmd.v[2] = w; cmd.v[3] = h;
+}
+
+void ofxBlend2DCommandBuffer::fill_rect(double x, double y, double w, double h, const BLRgba32& color){
+    Command& cmd = pushDraw(FillRect, &color);
+    cmd.v[0] = x; cmd.v[1] = y; cmd.v[2] = w; cmd.v[3] = h;
+}
+
+void ofxBlend2DCommandBuffer::fill_circle(double cx, double cy, double r){
+    Command& cmd = pushDraw(FillCircle, nullptr);
+    cmd.v[0] = cx; cmd.v[1] = cy; cmd.v[2] = r;
+}
+
+void ofxBlend2DCommandBuffer::fill_circle(double cx, double cy, double r, const BLRgba32& color){
+    Command& cmd = pushDraw(FillCircle, &color);
+    cmd.v[0] = cx; cmd.v[1] = cy; cmd.v[2] = r;
+}
+
+void ofxBlend2DCommandBuffer::stroke_line(double x0, double y0, double x1, double y1){
+    Command& cmd = pushDraw(StrokeLine, nullptr);
+    cmd.v[0] = x0; cmd.v[1] = y0; cmd.v[2] = x1; cmd.v[3] = y1;
+}
+
+void ofxBlend2DCommandBuffer::stroke_line(double x0, double y0, double x1, double y1, const BLRgba32& color){
+    Command& cmd = pushDraw(StrokeLine, &color);
+    cmd.v[0] = x0; cmd.v[1] = y0; cmd.v[2] = x1; cmd.v[3] = y1;
+}
+
+// - - - -
+
+void ofxBlend2DCommandBuffer::clear(){
+    commands.clear();
+    paths.clear();
+}
+
+void ofxBlend2DCommandBuffer::reserve(std::size_t numCommands){
+    commands.reserve(numCommands);
+}
+
+BLResult ofxBlend2DCommandBuffer::replay(BLContext& ctx) const {
+    BLResult ret = BL_SUCCESS;
+    std::size_t saveDepth = 0; // States saved by this buffer, only those can be restored
+    for(const Command& cmd : commands){
+        BLResult result = BL_SUCCESS;
+        switch(cmd.type){
+            case Save:
+                result = ctx.save();
+                if(result==BL_SUCCESS) ++saveDepth;
+                break;
+            case Restore:
+                if(saveDepth==0) result = BL_ERROR_NO_STATES_TO_RESTORE;
+                else {
+                    result = ctx.restore();
+                    --saveDepth;
+                }
+                break;
+            case SetTransform:          result = ctx.set_transform(getMatrix(cmd.v)); break;
+            case ResetTransform:        result = ctx.reset_transform(); break;
+            case ApplyTransform:        result = ctx.apply_transform(getMatrix(cmd.v)); break;
+            case Translate:             result = ctx.translate(cmd.v[0], cmd.v[1]); break;
+            case Scale:                 result = ctx.scale(cmd.v[0], cmd.v[1]); break;
+            case Rotate:                result = ctx.rotate(cmd.v[0]); break;
+            case SetCompOp:             result = ctx.set_comp_op((BLCompOp)cmd.value); break;
+            case SetGlobalAlpha:        result = ctx.set_global_alpha(cmd.v[0]); break;
+            case SetFillRule:           result = ctx.set_fill_rule((BLFillRule)cmd.value); break;
+            case SetFillStyle:          result = ctx.set_fill_style(BLRgba32(cmd.value)); break;
+            case SetStrokeStyle:        result = ctx.set_stroke_style(BLRgba32(cmd.value)); break;
+            case SetStrokeWidth:        result = ctx.set_stroke_width(cmd.v[0]); break;
+            case SetStrokeJoin:         result = ctx.set_stroke_join((BLStrokeJoin)cmd.value); break;
+            case SetStrokeCaps:         result = ctx.set_stroke_caps((BLStrokeCap)cmd.value); break;
+            case SetStrokeMiterLimit:   result = ctx.set_stroke_miter_limit(cmd.v[0]); break;
+            case FillAll:
+                result = cmd.hasColor ? ctx.fill_all(BLRgba32(cmd.color)) : ctx.fill_all();
+                break;
+            case FillPath:
+                result = cmd.hasColor ? ctx.fill_path(paths[cmd.value], BLRgba32(cmd.color)) : ctx.fill_path(paths[cmd.value]);
+                break;
+            case StrokePath:
+                result = cmd.hasColor ? ctx.stroke_path(paths[cmd.value], BLRgba32(cmd.color)) : ctx.stroke_path(paths[cmd.value]);
+                break;
+            case FillRect:
+                result = cmd.hasColor ? ctx.fill_rect(cmd.v[0], cmd.v[1], cmd.v[2], cmd.v[3], BLRgba32(cmd.color)) : ctx.fill_rect(cmd.v[0], cmd.v[1], cmd.v[2], cmd.v[3]);
+                break;
+            case FillCircle:
+                result = cmd.hasColor ? ctx.fill_circle(cmd.v[0], cmd.v[1], cmd.v[2], BLRgba32(cmd.color)) : ctx.fill_circle(cmd.v[0], cmd.v[1], cmd.v[2]);
+                break;
+            case StrokeLine:
+                result = cmd.hasColor ? ctx.stroke_line(cmd.v[0], cmd.v[1], cmd.v[2], cmd.v[3], BLRgba32(cmd.color)) : ctx.stroke_line(cmd.v[0], cmd.v[1], cmd.v[2], cmd.v[3]);
+                break;
+        }
+        if(result!=BL_SUCCESS && ret==BL_SUCCESS) ret = result;
+    }
+    for(; saveDepth>0; --saveDepth){
+        ctx.restore();
+    }
+    return ret;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "blend2d/blend2d.h"
+
+#include <vector>
+#include <cstdint>
+
+// Recorded draw commands
+// - - - -
+// Records a subset of the BLContext API (same method names, so templated draw code works with both), to be replayed later into a real context.
+// Recording doesn't touch any context : several threads can each fill their own buffer, then replay them one after the other.
+// Paths are kept by reference (BLPath is reference counted), so recording a shared path is cheap and thread safe.
+// Styles are solid colors only (BLRgba32), gradients and patterns are not recorded.
+
+class ofxBlend2DCommandBuffer {
+    public:
+        // State
+        void save();
+        void restore();
+        void set_transform(const BLMatrix2D& m);
+        void reset_transform();
+        void apply_transform(const BLMatrix2D& m);
+        void translate(double x, double y);
+        void scale(double x, double y);
+        void scale(double xy) { scale(xy, xy); }
+        void rotate(double angle);
+        void set_comp_op(BLCompOp compOp);
+        void set_global_alpha(double alpha);
+        void set_fill_rule(BLFillRule fillRule);
+        void set_fill_style(const BLRgba32& color);
+        void set_stroke_style(const BLRgba32& color);
+        void set_stroke_width(double width);
+        void set_stroke_join(BLStrokeJoin join);
+        void set_stroke_caps(BLStrokeCap cap);
+        void set_stroke_miter_limit(double miterLimit);
+
+        // Drawing (without color = current fill / stroke style)
+        void fill_all();
+        void fill_all(const BLRgba32& color);
+        void fill_path(const BLPath& path);
+        void fill_path(const BLPath& path, const BLRgba32& color);
+        void stroke_path(const BLPath& path);
+        void stroke_path(const BLPath& path, const BLRgba32& color);
+        void fill_rect(double x, double y, double w, double h);
+        void fill_rect(double x, double y, double w, double h, const BLRgba32& color);
+        void fill_rect(const BLRect& rect) { fill_rect(rect.x, rect.y, rect.w, rect.h); }
+        void fill_rect(const BLRect& rect, const BLRgba32& color) { fill_rect(rect.x, rect.y, rect.w, rect.h, color); }
+        void fill_circle(double cx, double cy, double r);
+        void fill_circle(double cx, double cy, double r, const BLRgba32& color);
+        void stroke_line(double x0, double y0, double x1, double y1);
+        void stroke_line(double x0, double y0, double x1, double y1, const BLRgba32& color);
+
+        // Plays all commands into ctx, in recording order. Returns the first error (the remaining commands are still played).
+        // Balanced : a restore() without a recorded save() is skipped (BL_ERROR_NO_STATES_TO_RESTORE), saves left open are restored at the end.
+        BLResult replay(BLContext& ctx) const;
+
+        // Removes the commands, keeps the allocated memory for the next recording
+        void clear();
+        void reserve(std::size_t numCommands);
+        std::size_t size() const { return commands.size(); }
+        bool empty() const { return commands.empty(); }
+
+    protected:
+        enum CommandType : uint8_t {
+            Save = 0,
+            Restore,
+            SetTransform,
+            ResetTransform,
+            ApplyTransform,
+            Translate,
+            Scale,
+            Rotate,
+            SetCompOp,
+            SetGlobalAlpha,
+            SetFillRule,
+            SetFillStyle,
+            SetStrokeStyle,
+            SetStrokeWidth,
+            SetStrokeJoin,
+            SetStrokeCaps,
+            SetStrokeMiterLimit,
+            FillAll,
+            FillPath,
+            StrokePath,
+            FillRect,
+            FillCircle,
+            StrokeLine,
+        };
+
+        struct Command {
+            CommandType type;
+            bool hasColor; // Draw commands : uses `color` instead of the current style
+            uint32_t value; // Enum value, color or path index
+            uint32_t color;
+            double v[6];
+        };
+
+        Command& push(CommandType type);
+        Command& pushDraw(CommandType type, const BLRgba32* color);
+
+        std::vector<Command> commands;
+        std::vector<BLPath> paths;
+};
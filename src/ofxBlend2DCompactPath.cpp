@@ -0,0 +1,281 @@
+#include "ofxBlend2DCompactPath.h"
+#include "ofxBlend2DGlue.h"
+#include "ofLog.h"
+
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+// Larger coordinates don't fit float32 (and overflow the int16 block ranges)
+static const double maxQuantizedCoordinate = std::numeric_limits<float>::max();
+
+// Out of range doubles can't be converted to float, non-finite ones (CLOSE vertices are NaN) convert as is
+static float toFloat(double value){
+    return std::isfinite(value) ? float(std::min(maxQuantizedCoordinate, std::max(-maxQuantizedCoordinate, value))) : float(value);
+}
+
+ofxBlend2DCompactPath::ofxBlend2DCompactPath(const BLPath& path, Encoding _encoding){
+    assign(path, _encoding);
+}
+
+void ofxBlend2DCompactPath::clear(){
+    numVertices = 0;
+    bounds = BLBox(0, 0, 0, 0);
+    packedCommands.clear();
+    verticesF32.clear();
+    verticesI16.clear();
+    blocks.clear();
+    weights.clear();
+}
+
+bool ofxBlend2DCompactPath::assign(const ofPath& path, Encoding _encoding){
+    return assign(::toBLPath(path), _encoding);
+}
+
+bool ofxBlend2DCompactPath::assign(const BLPath& path, Encoding _encoding){
+    clear();
+    encoding = _encoding;
+
+    const BLPathView view = path.view();
+    numVertices = view.size;
+    if(numVertices==0) return true;
+
+    if(path.get_bounding_box(&bounds) != BL_SUCCESS){
+        bounds = BLBox(0, 0, 0, 0);
+    }
+
+    // Pack commands, 2 per byte
+    packedCommands.assign((numVertices+1)/2, 0u);
+    for(std::size_t i=0; i<numVertices; ++i){
+        if(view.command_data[i] > 0x0Fu){
+            ofLogError("ofxBlend2DCompactPath::assign") << "Unknown path command " << (int)view.command_data[i] << ", can't pack the path !";
+            clear();
+            return false;
+        }
+        packedCommands[i>>1] |= uint8_t(view.command_data[i] << ((i&1u)*4u));
+    }
+    packedCommands.shrink_to_fit();
+
+    // Int16 needs finite points with a finite block range, keep anything else lossless
+    if(encoding == Encoding::Int16Relative){
+        for(std::size_t i=0; i<numVertices; ++i){
+            const uint8_t cmd = view.command_data[i];
+            if(cmd==BL_PATH_CMD_CLOSE || cmd==BL_PATH_CMD_WEIGHT) continue;
+            const BLPoint& p = view.vertex_data[i];
+            if(!std::isfinite(p.x) || !std::isfinite(p.y) || std::abs(p.x)>maxQuantizedCoordinate || std::abs(p.y)>maxQuantizedCoordinate){
+                ofLogWarning("ofxBlend2DCompactPath::assign") << "Non-finite or out of range vertex (" << p.x << ", " << p.y << "), storing the path as float32 instead.";
+                encoding = Encoding::Float32;
+                break;
+            }
+        }
+    }
+
+    // Float32 : straight copy
+    if(encoding == Encoding::Float32){
+        verticesF32.resize(numVertices*2);
+        for(std::size_t i=0; i<numVertices; ++i){
+            verticesF32[i*2+0] = toFloat(view.vertex_data[i].x);
+            verticesF32[i*2+1] = toFloat(view.vertex_data[i].y);
+        }
+        return true;
+    }
+
+    // Int16Relative : quantize each block relative to its own bounding box
+    verticesI16.resize(numVertices*2);
+    blocks.resize((numVertices+blockSize-1)/blockSize);
+    for(std::size_t b=0; b<blocks.size(); ++b){
+        const std::size_t first = b*blockSize;
+        const std::size_t last = std::min(numVertices, first+blockSize);
+
+        // Block bounds, ignoring CLOSE (NaN) and WEIGHT (not a point) vertices
+        double minX = std::numeric_limits<double>::max(), minY = minX;
+        double maxX = std::numeric_limits<double>::lowest(), maxY = maxX;
+        for(std::size_t i=first; i<last; ++i){
+            const uint8_t cmd = view.command_data[i];
+            if(cmd==BL_PATH_CMD_CLOSE || cmd==BL_PATH_CMD_WEIGHT) continue;
+            const BLPoint& p = view.vertex_data[i];
+            minX = std::min(minX, p.x); maxX = std::max(maxX, p.x);
+            minY = std::min(minY, p.y); maxY = std::max(maxY, p.y);
+        }
+        if(minX > maxX){ // No points in block
+            minX = maxX = minY = maxY = 0;
+        }
+
+        QuantizationBlock& block = blocks[b];
+        block.originX = minX;
+        block.originY = minY;
+        block.scaleX = (maxX > minX) ? (maxX-minX)/65535.0 : 1.0;
+        block.scaleY = (maxY > minY) ? (maxY-minY)/65535.0 : 1.0;
+
+        for(std::size_t i=first; i<last; ++i){
+            const uint8_t cmd = view.command_data[i];
+            const BLPoint& p = view.vertex_data[i];
+            if(cmd==BL_PATH_CMD_CLOSE){
+                verticesI16[i*2+0] = verticesI16[i*2+1] = 0;
+                continue;
+            }
+            if(cmd==BL_PATH_CMD_WEIGHT){
+                weights.push_back(toFloat(p.x));
+                verticesI16[i*2+0] = verticesI16[i*2+1] = 0;
+                continue;
+            }
+            // Finite and within the block (checked above) : clamping only absorbs rounding
+            const double qx = std::round((p.x-block.originX)/block.scaleX) - 32768.0;
+            const double qy = std::round((p.y-block.originY)/block.scaleY) - 32768.0;
+            verticesI16[i*2+0] = int16_t(std::min(32767.0, std::max(-32768.0, qx)));
+            verticesI16[i*2+1] = int16_t(std::min(32767.0, std::max(-32768.0, qy)));
+        }
+    }
+    weights.shrink_to_fit();
+
+    return true;
+}
+
+BLResult ofxBlend2DCompactPath::decodeRange(BLPath& out, std::size_t first, std::size_t count, std::size_t& weightIndex) const {
+    if(count==0) return BL_SUCCESS;
+
+    uint8_t* cmdOut = nullptr;
+    BLPoint* vtxOut = nullptr;
+    BLResult result = out.modify_op(BL_MODIFY_OP_APPEND_GROW, count, &cmdOut, &vtxOut);
+    if(result != BL_SUCCESS) return result;
+
+    // Write straight into the BLPath storage, sequentially (no intermediate buffers)
+    if(encoding == Encoding::Float32){
+        const float* src = verticesF32.data() + first*2;
+        for(std::size_t i=0; i<count; ++i){
+            cmdOut[i] = getCommand(first+i);
+            vtxOut[i].x = src[i*2+0];
+            vtxOut[i].y = src[i*2+1];
+        }
+        return BL_SUCCESS;
+    }
+
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const int16_t* src = verticesI16.data() + first*2;
+    for(std::size_t i=0; i<count; ++i){
+        const std::size_t v = first+i;
+        const uint8_t cmd = getCommand(v);
+        cmdOut[i] = cmd;
+        if(cmd==BL_PATH_CMD_CLOSE){
+            vtxOut[i] = BLPoint(nan, nan);
+        }
+        else if(cmd==BL_PATH_CMD_WEIGHT){
+            vtxOut[i] = BLPoint(weightIndex<weights.size() ? weights[weightIndex] : 1.0, nan);
+            weightIndex++;
+        }
+        else {
+            const QuantizationBlock& block = blocks[v/blockSize];
+            vtxOut[i].x = block.originX + (double(src[i*2+0])+32768.0)*block.scaleX;
+            vtxOut[i].y = block.originY + (double(src[i*2+1])+32768.0)*block.scaleY;
+        }
+    }
+    return BL_SUCCESS;
+}
+
+BLResult ofxBlend2DCompactPath::toBLPath(BLPath& out) const {
+    out.clear();
+    return appendTo(out);
+}
+
+BLResult ofxBlend2DCompactPath::appendTo(BLPath& out) const {
+    std::size_t weightIndex = 0;
+    return decodeRange(out, 0, numVertices, weightIndex);
+}
+
+BLPath ofxBlend2DCompactPath::toBLPath() const {
+    BLPath ret;
+    BLResult result = toBLPath(ret);
+    if(result != BL_SUCCESS){
+        ofLogError("ofxBlend2DCompactPath::toBLPath") << "Couldn't decode path : " << blResultToString(result);
+        ret.clear();
+    }
+    return ret;
+}
+
+std::future<BLPath> ofxBlend2DCompactPath::toBLPathAsync() const {
+    return std::async(std::launch::async, [this](){
+        return toBLPath();
+    });
+}
+
+std::vector<BLPath> ofxBlend2DCompactPath::toBLPaths(const std::vector<ofxBlend2DCompactPath>& paths, unsigned int numThreads){
+    std::vector<BLPath> ret(paths.size());
+    if(numThreads==0) numThreads = std::max(1u, std::thread::hardware_concurrency());
+    numThreads = std::min<std::size_t>(numThreads, paths.size());
+
+    // Each worker grabs the next path : keeps cores busy with uneven path sizes
+    std::atomic<std::size_t> next(0);
+    auto worker = [&](){
+        for(std::size_t i=next++; i<paths.size(); i=next++){
+            paths[i].toBLPath(ret[i]);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads);
+    for(unsigned int t=1; t<numThreads; ++t){
+        threads.emplace_back(worker);
+    }
+    worker(); // Calling thread helps too
+    for(std::thread& t : threads){
+        t.join();
+    }
+    return ret;
+}
+
+template<typename DrawFunc>
+void ofxBlend2DCompactPath::drawChunked(std::size_t maxVertices, DrawFunc&& draw) const {
+    if(maxVertices==0) maxVertices = numVertices;
+
+    std::size_t weightIndex = 0;
+    std::size_t chunkStart = 0;
+    BLPath chunk;
+    for(std::size_t i=1; i<=numVertices; ++i){
+        const bool isLast = (i==numVertices);
+        // Only cut before a MOVE so figures stay intact
+        if(isLast || ((i-chunkStart)>=maxVertices && getCommand(i)==BL_PATH_CMD_MOVE)){
+            chunk = BLPath(); // The context may still reference the previous chunk, don't reuse its storage
+            chunk.reserve(i-chunkStart);
+            if(decodeRange(chunk, chunkStart, i-chunkStart, weightIndex) == BL_SUCCESS){
+                draw(chunk);
+            }
+            chunkStart = i;
+        }
+    }
+}
+
+void ofxBlend2DCompactPath::fillChunked(BLContext& ctx, std::size_t maxVertices) const {
+    drawChunked(maxVertices, [&ctx](const BLPath& chunk){
+        ctx.fill_path(chunk);
+    });
+}
+
+void ofxBlend2DCompactPath::strokeChunked(BLContext& ctx, std::size_t maxVertices) const {
+    drawChunked(maxVertices, [&ctx](const BLPath& chunk){
+        ctx.stroke_path(chunk);
+    });
+}
+
+double ofxBlend2DCompactPath::getQuantizationError() const {
+    if(encoding == Encoding::Float32) return 0.0;
+    double ret = 0.0;
+    for(const QuantizationBlock& block : blocks){
+        ret = std::max(ret, std::max(block.scaleX, block.scaleY)*0.5);
+    }
+    return ret;
+}
+
+std::size_t ofxBlend2DCompactPath::getMemoryUsage() const {
+    return sizeof(*this)
+        + packedCommands.capacity()*sizeof(uint8_t)
+        + verticesF32.capacity()*sizeof(float)
+        + verticesI16.capacity()*sizeof(int16_t)
+        + blocks.capacity()*sizeof(QuantizationBlock)
+        + weights.capacity()*sizeof(float);
+}
+
+std::size_t ofxBlend2DCompactPath::getMemoryUsage(const BLPath& path){
+    return sizeof(BLPath) + path.size()*(sizeof(BLPoint)+sizeof(uint8_t));
+}
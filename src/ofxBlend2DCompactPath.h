@@ -0,0 +1,91 @@
+#pragma once
+
+#include "blend2d/blend2d.h"
+#include "ofPath.h"
+
+#include <vector>
+#include <future>
+#include <cstdint>
+
+// Compact geometry storage
+// - - - -
+// BLPath stores vertices as doubles (16 bytes/vertex + 1 command byte).
+// ofxBlend2DCompactPath keeps the same geometry resident with :
+// - Float32 encoding : 8 bytes/vertex (lossless for most imported data, which is float anyways)
+// - Int16 encoding   : 4 bytes/vertex, quantized relative to a per-block origin (lossy, see getQuantizationError()).
+//   Paths with non-finite or huge (beyond float) points fall back to Float32, see getEncoding()
+// Commands are packed 2 per byte (BL_PATH_CMD_xxx fits in a nibble).
+// The data is immutable once assigned, so decoding is thread safe : call toBLPath() from any number of worker threads.
+
+class ofxBlend2DCompactPath {
+    public:
+        enum class Encoding : uint8_t {
+            Float32 = 0,
+            Int16Relative = 1,
+        };
+
+        // Number of vertices sharing a quantization origin & scale (Int16Relative only)
+        static constexpr std::size_t blockSize = 1024;
+
+        ofxBlend2DCompactPath() = default;
+        explicit ofxBlend2DCompactPath(const BLPath& path, Encoding encoding=Encoding::Float32);
+
+        // Encode geometry, replacing any previous content
+        bool assign(const BLPath& path, Encoding encoding=Encoding::Float32);
+        bool assign(const ofPath& path, Encoding encoding=Encoding::Float32);
+        void clear();
+
+        // Decode : replaces or appends to out. Thread safe.
+        BLResult toBLPath(BLPath& out) const;
+        BLResult appendTo(BLPath& out) const;
+        BLPath toBLPath() const;
+
+        // Decode on a worker thread. /!\ The compact path must outlive the future.
+        std::future<BLPath> toBLPathAsync() const;
+
+        // Decodes many paths using numThreads workers (0 = hardware concurrency)
+        static std::vector<BLPath> toBLPaths(const std::vector<ofxBlend2DCompactPath>& paths, unsigned int numThreads=0);
+
+        // Streams the geometry to the context in chunks of about maxVertices, split on figure boundaries (MOVE commands).
+        // Only the chunk being submitted is held as a BLPath, so a full-size double-precision copy never exists at once.
+        // Note: figures end up in separate fill calls, so overlapping figures within one path don't combine their winding
+        // (holes are lost). Use this for datasets made of independent figures, or for strokes.
+        void fillChunked(BLContext& ctx, std::size_t maxVertices=4096) const;
+        void strokeChunked(BLContext& ctx, std::size_t maxVertices=4096) const;
+
+        // Info
+        std::size_t size() const { return numVertices; }
+        bool empty() const { return numVertices==0; }
+        Encoding getEncoding() const { return encoding; }
+        const BLBox& getBoundingBox() const { return bounds; }
+        // Biggest absolute error introduced by the encoding (0 for float32, ignoring float rounding)
+        double getQuantizationError() const;
+
+        // Resident bytes used by the compact data
+        std::size_t getMemoryUsage() const;
+        // Resident bytes used by the same geometry stored as a BLPath (ignoring over-allocation)
+        static std::size_t getMemoryUsage(const BLPath& path);
+
+    protected:
+        uint8_t getCommand(std::size_t i) const {
+            return (packedCommands[i>>1] >> ((i&1u)*4u)) & 0x0Fu;
+        }
+        BLResult decodeRange(BLPath& out, std::size_t first, std::size_t count, std::size_t& weightIndex) const;
+        template<typename DrawFunc>
+        void drawChunked(std::size_t maxVertices, DrawFunc&& draw) const;
+
+        struct QuantizationBlock {
+            double originX, originY;
+            double scaleX, scaleY;
+        };
+
+        Encoding encoding = Encoding::Float32;
+        std::size_t numVertices = 0;
+        BLBox bounds = BLBox(0, 0, 0, 0);
+
+        std::vector<uint8_t> packedCommands; // 2 commands per byte, low nibble first
+        std::vector<float> verticesF32; // x,y interleaved (Float32)
+        std::vector<int16_t> verticesI16; // x,y interleaved (Int16Relative)
+        std::vector<QuantizationBlock> blocks; // One per blockSize vertices (Int16Relative)
+        std::vector<float> weights; // Conic weights, in order of appearance (Int16Relative)
+};
@@ -0,0 +1,106 @@
+#include "ofxBlend2DContextConfig.h"
+
+#include <thread>
+#include <sstream>
+#include <algorithm>
+
+// Flags with their own member
+static const uint32_t typedFlags = BL_CONTEXT_CREATE_FLAG_DISABLE_JIT | BL_CONTEXT_CREATE_FLAG_FALLBACK_TO_SYNC | BL_CONTEXT_CREATE_FLAG_ISOLATED_THREAD_POOL | BL_CONTEXT_CREATE_FLAG_ISOLATED_JIT_RUNTIME;
+
+BLContextCreateInfo ofxBlend2DContextConfig::toCreateInfo() const {
+    BLContextCreateInfo createInfo = {};
+    createInfo.thread_count = threadCount;
+    createInfo.flags = otherFlags & ~typedFlags;
+    if(bDisableJit) createInfo.flags |= BL_CONTEXT_CREATE_FLAG_DISABLE_JIT;
+    if(bFallbackToSync) createInfo.flags |= BL_CONTEXT_CREATE_FLAG_FALLBACK_TO_SYNC;
+    if(bIsolatedThreadPool) createInfo.flags |= BL_CONTEXT_CREATE_FLAG_ISOLATED_THREAD_POOL;
+    if(bIsolatedJitRuntime) createInfo.flags |= BL_CONTEXT_CREATE_FLAG_ISOLATED_JIT_RUNTIME;
+    createInfo.command_queue_limit = commandQueueLimit;
+    createInfo.saved_state_limit = savedStateLimit;
+    return createInfo;
+}
+
+ofxBlend2DContextConfig ofxBlend2DContextConfig::fromCreateInfo(const BLContextCreateInfo& createInfo){
+    ofxBlend2DContextConfig config;
+    config.threadCount = createInfo.thread_count;
+    config.bDisableJit = createInfo.flags & BL_CONTEXT_CREATE_FLAG_DISABLE_JIT;
+    config.bFallbackToSync = createInfo.flags & BL_CONTEXT_CREATE_FLAG_FALLBACK_TO_SYNC;
+    config.bIsolatedThreadPool = createInfo.flags & BL_CONTEXT_CREATE_FLAG_ISOLATED_THREAD_POOL;
+    config.bIsolatedJitRuntime = createInfo.flags & BL_CONTEXT_CREATE_FLAG_ISOLATED_JIT_RUNTIME;
+    config.commandQueueLimit = createInfo.command_queue_limit;
+    config.savedStateLimit = createInfo.saved_state_limit;
+    config.otherFlags = createInfo.flags & ~typedFlags;
+    return config;
+}
+
+ofxBlend2DContextConfig ofxBlend2DContextConfig::fromPreset(Preset preset){
+    const uint32_t numCores = std::max(1u, std::thread::hardware_concurrency());
+    ofxBlend2DContextConfig config;
+    switch(preset){
+        case LatencyPreset:
+            // One core left for the submitting and GL threads
+            config.threadCount = std::max(1u, numCores-1);
+            // Not an isolated pool : the renderer creates a context per frame, it would spawn its threads every frame
+            config.bFallbackToSync = true;
+            config.commandQueueLimit = 1024;
+            break;
+        case ThroughputPreset:
+            config.threadCount = numCores;
+            config.bFallbackToSync = true;
+            config.commandQueueLimit = 16384;
+            break;
+        case MemoryPreset:
+            config.threadCount = 0;
+            config.savedStateLimit = 16;
+            break;
+        default:
+            break;
+    }
+    return config;
+}
+
+const char* ofxBlend2DContextConfig::getPresetName(Preset preset){
+    static const char* names[NumPresets+1] = { "default", "latency", "throughput", "memory", "custom" };
+    return preset<=NumPresets ? names[preset] : "custom";
+}
+
+bool ofxBlend2DContextConfig::getPresetFromName(const std::string& name, Preset& preset){
+    for(uint8_t i=0; i<NumPresets; ++i){
+        if(name==getPresetName((Preset)i)){
+            preset = (Preset)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+ofxBlend2DContextConfig::Preset ofxBlend2DContextConfig::getPreset() const {
+    for(uint8_t i=0; i<NumPresets; ++i){
+        if(*this==fromPreset((Preset)i)) return (Preset)i;
+    }
+    return CustomPreset;
+}
+
+std::string ofxBlend2DContextConfig::getDescription() const {
+    std::ostringstream description;
+    description << "threads=" << threadCount;
+    if(bIsolatedThreadPool) description << " isolated-pool";
+    if(bFallbackToSync) description << " fallback-to-sync";
+    if(bDisableJit) description << " no-jit";
+    if(bIsolatedJitRuntime) description << " isolated-jit";
+    if(commandQueueLimit>0) description << " queue=" << commandQueueLimit;
+    if(savedStateLimit>0) description << " states=" << savedStateLimit;
+    if((otherFlags & ~typedFlags)!=0) description << " flags=0x" << std::hex << (otherFlags & ~typedFlags);
+    return description.str();
+}
+
+bool ofxBlend2DContextConfig::operator==(const ofxBlend2DContextConfig& other) const {
+    return threadCount==other.threadCount &&
+        bIsolatedThreadPool==other.bIsolatedThreadPool &&
+        bFallbackToSync==other.bFallbackToSync &&
+        bDisableJit==other.bDisableJit &&
+        bIsolatedJitRuntime==other.bIsolatedJitRuntime &&
+        commandQueueLimit==other.commandQueueLimit &&
+        savedStateLimit==other.savedStateLimit &&
+        (otherFlags & ~typedFlags)==(other.otherFlags & ~typedFlags);
+}
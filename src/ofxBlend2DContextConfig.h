@@ -0,0 +1,56 @@
+#pragma once
+
+#include "blend2d/blend2d.h"
+
+#include <string>
+#include <cstdint>
+
+// Context creation options
+// - - - -
+// Typed view of BLContextCreateInfo : the thread count, the create flags and the queue / state limits of the renderer's frame contexts.
+// Presets :
+// - Latency : all cores but one and a short command queue, so the workers start rasterizing while the frame is still being submitted.
+// - Throughput : all cores on Blend2D's shared pool and a long command queue (fewer batch synchronizations).
+// - Memory : synchronous rendering (no worker buffers nor command queue) and a saved state limit.
+// The thread tuner and the quality governor still override the thread count when enabled.
+//
+// Usage :
+//     blend2d.setContextConfig(ofxBlend2DContextConfig::fromPreset(ofxBlend2DContextConfig::LatencyPreset));
+
+struct ofxBlend2DContextConfig {
+    enum Preset : uint8_t {
+        DefaultPreset = 0,
+        LatencyPreset,
+        ThroughputPreset,
+        MemoryPreset,
+        NumPresets,
+        CustomPreset = NumPresets // Matches no preset
+    };
+
+    uint32_t threadCount = 4; // 0 = synchronous
+    bool bIsolatedThreadPool = false; // Own threads instead of Blend2D's shared pool (created with each context, ie. every frame)
+    bool bFallbackToSync = false; // Renders synchronously instead of failing when the pool has no threads left
+    bool bDisableJit = false; // Reference pipelines only (slower, for debugging)
+    bool bIsolatedJitRuntime = false; // Compiles its own pipelines, not shared with other contexts
+    uint32_t commandQueueLimit = 0; // Commands per batch handed to the workers, 0 = Blend2D's default
+    uint32_t savedStateLimit = 0; // Max save() depth, 0 = unlimited. Deeper save() calls fail
+    uint32_t otherFlags = 0; // Other BLContextCreateFlags, passed as is
+
+    BLContextCreateInfo toCreateInfo() const;
+    static ofxBlend2DContextConfig fromCreateInfo(const BLContextCreateInfo& createInfo);
+
+    // Resolved for this machine's cores
+    static ofxBlend2DContextConfig fromPreset(Preset preset);
+    static const char* getPresetName(Preset preset);
+    // Lowercase names, ex: "latency"
+    static bool getPresetFromName(const std::string& name, Preset& preset);
+    // The preset this config equals, or CustomPreset
+    Preset getPreset() const;
+
+    std::string getDescription() const;
+
+    bool operator==(const ofxBlend2DContextConfig& other) const;
+    bool operator!=(const ofxBlend2DContextConfig& other) const {
+        return !(*this==other);
+    }
+};
@@ -0,0 +1,126 @@
+#include "ofxBlend2DFrame.h"
+#include "ofxBlend2DGlue.h"
+
+#include <cstring>
+
+// - - - - ofxBlend2DFrame
+
+const BLImage& ofxBlend2DFrame::getImage() const {
+    static const BLImage emptyImage;
+    return data ? data->image : emptyImage;
+}
+
+const ofxBlend2DFrameTimings& ofxBlend2DFrame::getTimings() const {
+    static const ofxBlend2DFrameTimings emptyTimings;
+    return data ? data->timings : emptyTimings;
+}
+
+const BLImageData& ofxBlend2DFrame::getImageData() const {
+    static const BLImageData emptyData = {};
+    return data ? data->imageData : emptyData;
+}
+
+bool ofxBlend2DFrame::toPixels(ofPixels& pixels) const {
+    if(!data || data->imageData.pixel_data==nullptr) return false;
+    return toOfPixels(data->imageData, pixels);
+}
+
+ofxBlend2DFrame ofxBlend2DFrame::create(BLImage&& image, const ofxBlend2DFrameTimings& timings, const std::shared_ptr<ofxBlend2DCanvasPool>& pool){
+    std::shared_ptr<Data> newData = std::make_shared<Data>();
+    newData->image = std::move(image);
+    if(newData->image.get_data(&newData->imageData) != BL_SUCCESS){
+        return ofxBlend2DFrame();
+    }
+    newData->timings = timings;
+    newData->pool = pool;
+
+    ofxBlend2DFrame frame;
+    frame.data = std::move(newData);
+    return frame;
+}
+
+ofxBlend2DFrame::Data::~Data(){
+    std::shared_ptr<ofxBlend2DCanvasPool> canvasPool = pool.lock();
+    if(canvasPool) canvasPool->release(std::move(image));
+}
+
+// - - - - ofxBlend2DFrameTicket
+
+bool ofxBlend2DFrameTicket::isReady() const {
+    if(!state) return false;
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->bReady;
+}
+
+bool ofxBlend2DFrameTicket::wait() const {
+    if(!state) return false;
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->condition.wait(lock, [this](){ return state->bReady; });
+    return true;
+}
+
+bool ofxBlend2DFrameTicket::wait(std::chrono::milliseconds timeout) const {
+    if(!state) return false;
+    std::unique_lock<std::mutex> lock(state->mutex);
+    return state->condition.wait_for(lock, timeout, [this](){ return state->bReady; });
+}
+
+ofxBlend2DFrame ofxBlend2DFrameTicket::getFrame() const {
+    if(!state) return ofxBlend2DFrame();
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->frame;
+}
+
+ofxBlend2DFrameTicket ofxBlend2DFrameTicket::create(unsigned int frameNum){
+    ofxBlend2DFrameTicket ticket;
+    ticket.state = std::make_shared<State>();
+    ticket.state->frameNum = frameNum;
+    return ticket;
+}
+
+void ofxBlend2DFrameTicket::complete(const ofxBlend2DFrame& frame) const {
+    if(!state) return;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if(state->bReady) return;
+        state->frame = frame;
+        state->bReady = true;
+    }
+    state->condition.notify_all();
+}
+
+// - - - - ofxBlend2DCanvasPool
+
+BLImage ofxBlend2DCanvasPool::acquire(int width, int height, BLFormat format){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        while(!freeImages.empty()){
+            BLImage image = std::move(freeImages.back());
+            freeImages.pop_back();
+            if(image.width()==width && image.height()==height && image.format()==format){
+                return image;
+            }
+            // Outdated size or format : dropped
+        }
+        numAllocated++;
+    }
+    return BLImage(width, height, format);
+}
+
+void ofxBlend2DCanvasPool::release(BLImage&& image){
+    if(image.empty()) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    if(freeImages.size()<maxFree){
+        freeImages.push_back(std::move(image));
+    }
+}
+
+void ofxBlend2DCanvasPool::clear(){
+    std::lock_guard<std::mutex> lock(mutex);
+    freeImages.clear();
+}
+
+std::size_t ofxBlend2DCanvasPool::getNumFree(){
+    std::lock_guard<std::mutex> lock(mutex);
+    return freeImages.size();
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "blend2d/blend2d.h"
+#include "ofPixels.h"
+#include "ofxBlend2DFrameProfiler.h" // ofxBlend2DFrameTimings
+
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+
+// Frame handles
+// - - - -
+// An ofxBlend2DFrame is a reference counted, read-only view of a finished canvas (pixels, frame number, timestamps).
+// Copies are cheap and can be kept or sent to other threads (recorders, analysis, network senders) to read the pixels without copying,
+// while the renderer uploads the same pixels to its texture. The canvas goes back to the renderer's pool when the last handle drops.
+// Note: Blend2D stores pixels as premultiplied BGRA (little endian : B,G,R,A bytes) for PRGB32, XRGB32 has an undefined alpha byte.
+
+class ofxBlend2DCanvasPool;
+
+class ofxBlend2DFrame {
+    public:
+        ofxBlend2DFrame() = default;
+
+        bool isValid() const { return data!=nullptr; }
+        explicit operator bool() const { return isValid(); }
+
+        unsigned int getFrameNum() const { return data ? data->timings.frameNum : 0; }
+        // ofGetElapsedTimeMicros() when the frame was started (begin()), submitted (end()) and rasterized (pixels ready)
+        uint64_t getBeginTimeMicros() const { return data ? data->timings.get(ofxBlend2DFrameTimings::SubmitBegin) : 0; }
+        uint64_t getSubmitTimeMicros() const { return data ? data->timings.get(ofxBlend2DFrameTimings::SubmitEnd) : 0; }
+        uint64_t getReadyTimeMicros() const { return data ? data->timings.get(ofxBlend2DFrameTimings::FlushEnd) : 0; }
+        // All pipeline stamps up to the worker (the upload happens later, see ofxBlend2DThreadedRenderer::getProfiler())
+        const ofxBlend2DFrameTimings& getTimings() const;
+
+        // Pixels, valid as long as this handle (or a copy) lives
+        const BLImage& getImage() const;
+        const BLImageData& getImageData() const;
+        const uint8_t* getPixels() const { return data ? static_cast<const uint8_t*>(data->imageData.pixel_data) : nullptr; }
+        intptr_t getStride() const { return data ? data->imageData.stride : 0; }
+        int getWidth() const { return data ? data->imageData.size.w : 0; }
+        int getHeight() const { return data ? data->imageData.size.h : 0; }
+        BLFormat getFormat() const { return data ? (BLFormat)data->imageData.format : BL_FORMAT_NONE; }
+
+        // Copies the pixels (removing the row padding) as straight RGBA, RGB or gray (see toOfPixels()), returns false on invalid frames
+        bool toPixels(ofPixels& pixels) const;
+
+        // Number of handles sharing this frame
+        long getUseCount() const { return data.use_count(); }
+
+        // Used by the renderer
+        static ofxBlend2DFrame create(BLImage&& image, const ofxBlend2DFrameTimings& timings, const std::shared_ptr<ofxBlend2DCanvasPool>& pool);
+
+    protected:
+        struct Data {
+            BLImage image;
+            BLImageData imageData;
+            ofxBlend2DFrameTimings timings;
+            std::weak_ptr<ofxBlend2DCanvasPool> pool;
+            ~Data(); // Returns the image to the pool
+        };
+        std::shared_ptr<const Data> data;
+};
+
+// Waitable handle to a submitted frame, returned by ofxBlend2DThreadedRenderer::end()
+// Completes on the worker thread as soon as the frame's pixels are ready (or when the frame is dropped, getFrame() is then invalid).
+// Copies share the same state, any thread can wait on it. A completed ticket keeps its frame (and canvas) alive, don't hoard them.
+class ofxBlend2DFrameTicket {
+    public:
+        ofxBlend2DFrameTicket() = default;
+
+        // False if the frame wasn't submitted
+        bool isValid() const { return state!=nullptr; }
+        explicit operator bool() const { return isValid(); }
+
+        unsigned int getFrameNum() const { return state ? state->frameNum : 0; }
+        bool isReady() const;
+
+        // Blocks until the frame is ready, returns false on timeout or invalid tickets
+        bool wait() const;
+        bool wait(std::chrono::milliseconds timeout) const;
+
+        // The finished frame once ready, an invalid frame otherwise
+        ofxBlend2DFrame getFrame() const;
+
+        // Used by the renderer
+        static ofxBlend2DFrameTicket create(unsigned int frameNum);
+        // Only the first call has an effect
+        void complete(const ofxBlend2DFrame& frame) const;
+
+    protected:
+        struct State {
+            std::mutex mutex;
+            std::condition_variable condition;
+            bool bReady = false;
+            unsigned int frameNum = 0;
+            ofxBlend2DFrame frame;
+        };
+        std::shared_ptr<State> state;
+};
+
+// Recycles canvases between frames, which avoids allocating (and page faulting) a full canvas every frame.
+// Thread safe : frames are released from whichever thread drops the last handle.
+class ofxBlend2DCanvasPool {
+    public:
+        // Returns a pooled canvas of that size and format, or a new one. Content is undefined.
+        BLImage acquire(int width, int height, BLFormat format);
+        // The image must not be referenced anymore (by a context or another BLImage)
+        void release(BLImage&& image);
+        void clear();
+
+        std::size_t getNumFree();
+        std::size_t getNumAllocated() const { return numAllocated.load(); }
+
+        // Free canvases kept at most, the others are deallocated
+        std::size_t maxFree = 3;
+
+    protected:
+        std::mutex mutex;
+        std::vector<BLImage> freeImages;
+        std::atomic<std::size_t> numAllocated{0}; // Total canvases created
+};
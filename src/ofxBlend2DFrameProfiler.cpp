@@ -0,0 +1,286 @@
+#include "ofxBlend2DFrameProfiler.h"
+#include "ofFileUtils.h" // ofToDataPath
+#include "ofLog.h"
+
+#include <fstream>
+#include <algorithm>
+
+typedef ofxBlend2DFrameTimings Timings;
+
+const char* ofxBlend2DFrameProfiler::getSpanName(Span span){
+    static const char* names[NumSpans] = { "submit", "queue", "flush", "encode", "wait", "upload", "total", "latency", "interval" };
+    return span<NumSpans ? names[span] : "unknown";
+}
+
+ofxBlend2DFrameProfiler::ofxBlend2DFrameProfiler(std::size_t _capacity) :
+    capacity(std::max<std::size_t>(2, _capacity)),
+    entries(new Entry[std::max<std::size_t>(2, _capacity)])
+{
+
+}
+
+void ofxBlend2DFrameProfiler::record(const Timings& timings){
+    if(!bEnabled) return;
+    const uint64_t index = head.load(std::memory_order_relaxed);
+    Entry& entry = entries[index%capacity];
+
+    const uint32_t sequence = entry.sequence.load(std::memory_order_relaxed);
+    entry.sequence.store(sequence+1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    entry.frameNum.store(timings.frameNum, std::memory_order_relaxed);
+    for(int i=0; i<Timings::NumStamps; ++i){
+        entry.stamps[i].store(timings.stamps[i], std::memory_order_relaxed);
+    }
+    entry.submitAppFrame.store(timings.submitAppFrame, std::memory_order_relaxed);
+    entry.uploadAppFrame.store(timings.uploadAppFrame, std::memory_order_relaxed);
+    entry.numDropped.store(timings.numDropped, std::memory_order_relaxed);
+    entry.contextErrorFlags.store(timings.contextErrorFlags, std::memory_order_relaxed);
+    entry.threadCount.store(timings.threadCount, std::memory_order_relaxed);
+    entry.sequence.store(sequence+2, std::memory_order_release);
+    numDropped.fetch_add(timings.numDropped, std::memory_order_relaxed);
+    head.store(index+1, std::memory_order_release);
+}
+
+void ofxBlend2DFrameProfiler::clear(){
+    // Readers only look at entries below head
+    head.store(0, std::memory_order_release);
+    numDropped.store(0, std::memory_order_release);
+}
+
+bool ofxBlend2DFrameProfiler::readEntry(uint64_t index, Timings& timings) const {
+    const Entry& entry = entries[index%capacity];
+    for(int attempt=0; attempt<4; ++attempt){
+        const uint32_t sequence = entry.sequence.load(std::memory_order_acquire);
+        if(sequence&1u) continue;
+        timings.frameNum = entry.frameNum.load(std::memory_order_relaxed);
+        for(int i=0; i<Timings::NumStamps; ++i){
+            timings.stamps[i] = entry.stamps[i].load(std::memory_order_relaxed);
+        }
+        timings.submitAppFrame = entry.submitAppFrame.load(std::memory_order_relaxed);
+        timings.uploadAppFrame = entry.uploadAppFrame.load(std::memory_order_relaxed);
+        timings.numDropped = entry.numDropped.load(std::memory_order_relaxed);
+        timings.contextErrorFlags = entry.contextErrorFlags.load(std::memory_order_relaxed);
+        timings.threadCount = entry.threadCount.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(entry.sequence.load(std::memory_order_relaxed)==sequence) return true;
+    }
+    return false; // Overwritten while reading
+}
+
+std::vector<Timings> ofxBlend2DFrameProfiler::getHistory(std::size_t numFrames) const {
+    const uint64_t end = head.load(std::memory_order_acquire);
+    // Keep one entry of margin : the writer may be reusing the oldest one
+    const uint64_t available = std::min<uint64_t>(end, capacity-1);
+    const uint64_t count = (numFrames>0) ? std::min<uint64_t>(numFrames, available) : available;
+
+    std::vector<Timings> history;
+    history.reserve(count);
+    for(uint64_t index=end-count; index<end; ++index){
+        Timings timings;
+        if(readEntry(index, timings)) history.push_back(timings);
+    }
+    return history;
+}
+
+bool ofxBlend2DFrameProfiler::getLatest(Timings& timings) const {
+    const uint64_t end = head.load(std::memory_order_acquire);
+    return end>0 && readEntry(end-1, timings);
+}
+
+uint64_t ofxBlend2DFrameProfiler::getSpanMicros(const std::vector<Timings>& history, std::size_t index, Span span){
+    const Timings& t = history[index];
+    switch(span){
+        case SubmitSpan:
+            return t.getDuration(Timings::SubmitBegin, Timings::SubmitEnd);
+        case QueueSpan:
+            return t.getDuration(Timings::SubmitEnd, Timings::FlushBegin);
+        case FlushSpan:
+            return t.getDuration(Timings::FlushBegin, Timings::FlushEnd);
+        case EncodeSpan:
+            return t.getDuration(Timings::EncodeBegin, Timings::EncodeEnd);
+        case WaitSpan:
+            return t.getDuration(t.get(Timings::EncodeEnd)>0 ? Timings::EncodeEnd : Timings::FlushEnd, Timings::UploadBegin);
+        case UploadSpan:
+            return t.getDuration(Timings::UploadBegin, Timings::UploadEnd);
+        case TotalSpan:
+            return t.getDuration(Timings::SubmitBegin, Timings::UploadEnd);
+        case LatencySpan:
+            return t.getDuration(Timings::SubmitEnd, Timings::UploadEnd);
+        case IntervalSpan:
+            if(index==0) return 0;
+            return history[index-1].get(Timings::UploadEnd)>0 && t.get(Timings::UploadEnd)>history[index-1].get(Timings::UploadEnd) ?
+                t.get(Timings::UploadEnd)-history[index-1].get(Timings::UploadEnd) : 0;
+        default:
+            return 0;
+    }
+}
+
+// Frames missing a stage (ex: not encoded) are left out of its summary, while 0us durations are still counted
+static bool hasSpan(const std::vector<Timings>& history, std::size_t index, ofxBlend2DFrameProfiler::Span span){
+    const Timings& t = history[index];
+    switch(span){
+        case ofxBlend2DFrameProfiler::SubmitSpan: return t.get(Timings::SubmitBegin)>0 && t.get(Timings::SubmitEnd)>0;
+        case ofxBlend2DFrameProfiler::QueueSpan: return t.get(Timings::SubmitEnd)>0 && t.get(Timings::FlushBegin)>0;
+        case ofxBlend2DFrameProfiler::FlushSpan: return t.get(Timings::FlushBegin)>0 && t.get(Timings::FlushEnd)>0;
+        case ofxBlend2DFrameProfiler::EncodeSpan: return t.get(Timings::EncodeBegin)>0 && t.get(Timings::EncodeEnd)>0;
+        case ofxBlend2DFrameProfiler::WaitSpan: return (t.get(Timings::EncodeEnd)>0 || t.get(Timings::FlushEnd)>0) && t.get(Timings::UploadBegin)>0;
+        case ofxBlend2DFrameProfiler::UploadSpan: return t.get(Timings::UploadBegin)>0 && t.get(Timings::UploadEnd)>0;
+        case ofxBlend2DFrameProfiler::TotalSpan: return t.get(Timings::SubmitBegin)>0 && t.get(Timings::UploadEnd)>0;
+        case ofxBlend2DFrameProfiler::LatencySpan: return t.get(Timings::SubmitEnd)>0 && t.get(Timings::UploadEnd)>0;
+        case ofxBlend2DFrameProfiler::IntervalSpan: return index>0 && history[index-1].get(Timings::UploadEnd)>0 && t.get(Timings::UploadEnd)>0;
+        default: return false;
+    }
+}
+
+// Values are micros, unless scale says otherwise
+static ofxBlend2DFrameProfiler::Summary summarize(std::vector<uint64_t>& values, float scale=1.f/1000.f){
+    ofxBlend2DFrameProfiler::Summary summary;
+    if(values.empty()) return summary;
+    std::sort(values.begin(), values.end());
+    // Nearest rank
+    auto percentile = [&values, scale](float p){
+        const std::size_t rank = std::min(values.size()-1, (std::size_t)(p*values.size()));
+        return values[rank]*scale;
+    };
+    uint64_t sum = 0;
+    for(uint64_t value : values) sum += value;
+    summary.count = values.size();
+    summary.minMs = values.front()*scale;
+    summary.maxMs = values.back()*scale;
+    summary.meanMs = (sum*scale)/values.size();
+    summary.p50Ms = percentile(.50f);
+    summary.p95Ms = percentile(.95f);
+    summary.p99Ms = percentile(.99f);
+    return summary;
+}
+
+ofxBlend2DFrameProfiler::Summary ofxBlend2DFrameProfiler::getSummary(Span span, std::size_t numFrames) const {
+    const std::vector<Timings> history = getHistory(numFrames);
+    std::vector<uint64_t> values;
+    values.reserve(history.size());
+    for(std::size_t i=0; i<history.size(); ++i){
+        if(hasSpan(history, i, span)) values.push_back(getSpanMicros(history, i, span));
+    }
+    return summarize(values);
+}
+
+std::vector<ofxBlend2DFrameProfiler::Summary> ofxBlend2DFrameProfiler::getSummaries(std::size_t numFrames) const {
+    const std::vector<Timings> history = getHistory(numFrames);
+    std::vector<Summary> summaries(NumSpans);
+    std::vector<uint64_t> values;
+    values.reserve(history.size());
+    for(int span=0; span<NumSpans; ++span){
+        values.clear();
+        for(std::size_t i=0; i<history.size(); ++i){
+            if(hasSpan(history, i, (Span)span)) values.push_back(getSpanMicros(history, i, (Span)span));
+        }
+        summaries[span] = summarize(values);
+    }
+    return summaries;
+}
+
+ofxBlend2DFrameProfiler::LatencyStats ofxBlend2DFrameProfiler::getLatencyStats(std::size_t numFrames) const {
+    LatencyStats stats;
+    // Totals first : the history may include a frame recorded right after
+    stats.numDropped = getNumDropped();
+    stats.numUploaded = getNumRecorded();
+
+    const std::vector<Timings> history = getHistory(numFrames);
+    std::vector<uint64_t> latencies;
+    std::vector<uint64_t> framesBehind;
+    latencies.reserve(history.size());
+    framesBehind.reserve(history.size());
+    for(std::size_t i=0; i<history.size(); ++i){
+        if(hasSpan(history, i, LatencySpan)) latencies.push_back(getSpanMicros(history, i, LatencySpan));
+        if(history[i].uploadAppFrame>0) framesBehind.push_back(history[i].getFramesBehind());
+    }
+    stats.latency = summarize(latencies);
+    stats.framesBehind = summarize(framesBehind, 1.f);
+    return stats;
+}
+
+std::vector<float> ofxBlend2DFrameProfiler::getHistogram(Span span, std::size_t numBins, float maxMs, std::size_t numFrames) const {
+    std::vector<float> bins(numBins, 0.f);
+    if(numBins==0 || maxMs<=0.f) return bins;
+    const std::vector<Timings> history = getHistory(numFrames);
+    for(std::size_t i=0; i<history.size(); ++i){
+        if(!hasSpan(history, i, span)) continue;
+        const float ms = getSpanMicros(history, i, span)/1000.f;
+        bins[std::min(numBins-1, (std::size_t)(ms/maxMs*numBins))] += 1.f;
+    }
+    return bins;
+}
+
+std::vector<float> ofxBlend2DFrameProfiler::getFramesBehindHistogram(std::size_t numBins, std::size_t numFrames) const {
+    std::vector<float> bins(numBins, 0.f);
+    if(numBins==0) return bins;
+    for(const Timings& timings : getHistory(numFrames)){
+        if(timings.uploadAppFrame==0) continue;
+        bins[std::min<uint64_t>(numBins-1, timings.getFramesBehind())] += 1.f;
+    }
+    return bins;
+}
+
+bool ofxBlend2DFrameProfiler::saveCsv(const std::string& path) const {
+    std::ofstream file(ofToDataPath(path, true));
+    if(!file){
+        ofLogError("ofxBlend2DFrameProfiler::saveCsv") << "Couldn't open " << path << " for writing !";
+        return false;
+    }
+    static const char* stampNames[Timings::NumStamps] = { "submitBegin", "submitEnd", "flushBegin", "flushEnd", "encodeBegin", "encodeEnd", "uploadBegin", "uploadEnd" };
+
+    // Raw stamps (micros), then the derived spans
+    file << "frame";
+    for(const char* name : stampNames) file << "," << name << "Us";
+    for(int span=0; span<NumSpans; ++span) file << "," << getSpanName((Span)span) << "Us";
+    file << ",submitAppFrame,uploadAppFrame,framesBehind,dropped,contextErrorFlags,threads\n";
+
+    const std::vector<Timings> history = getHistory();
+    for(std::size_t i=0; i<history.size(); ++i){
+        file << history[i].frameNum;
+        for(uint64_t stamp : history[i].stamps) file << "," << stamp;
+        for(int span=0; span<NumSpans; ++span) file << "," << getSpanMicros(history, i, (Span)span);
+        file << "," << history[i].submitAppFrame << "," << history[i].uploadAppFrame << "," << history[i].getFramesBehind() << "," << history[i].numDropped << "," << history[i].contextErrorFlags << "," << history[i].threadCount << "\n";
+    }
+    return bool(file);
+}
+
+bool ofxBlend2DFrameProfiler::saveChromeTrace(const std::string& path) const {
+    std::ofstream file(ofToDataPath(path, true));
+    if(!file){
+        ofLogError("ofxBlend2DFrameProfiler::saveChromeTrace") << "Couldn't open " << path << " for writing !";
+        return false;
+    }
+
+    // Complete events ("ph":"X"), one lane per pipeline thread
+    struct Event { const char* name; Timings::Stamp from; Timings::Stamp to; int lane; };
+    static const Event events[] = {
+        { "submit", Timings::SubmitBegin, Timings::SubmitEnd, 1 },
+        { "flush", Timings::FlushBegin, Timings::FlushEnd, 2 },
+        { "encode", Timings::EncodeBegin, Timings::EncodeEnd, 2 },
+        { "upload", Timings::UploadBegin, Timings::UploadEnd, 3 },
+    };
+    static const char* laneNames[] = { "", "Submission", "Worker", "GL upload" };
+
+    // Separators go before every entry but the first : no trailing comma, even without frames
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool bFirst = true;
+    for(int lane=1; lane<=3; ++lane){
+        if(!bFirst) file << ",\n";
+        bFirst = false;
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << lane << ",\"args\":{\"name\":\"" << laneNames[lane] << "\"}}";
+    }
+    const std::vector<Timings> history = getHistory();
+    for(const Timings& timings : history){
+        for(const Event& event : events){
+            if(timings.get(event.from)==0 || timings.get(event.to)<timings.get(event.from)) continue;
+            if(!bFirst) file << ",\n";
+            bFirst = false;
+            file << "{\"name\":\"" << event.name << "\",\"cat\":\"ofxBlend2D\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.lane
+                 << ",\"ts\":" << timings.get(event.from) << ",\"dur\":" << timings.getDuration(event.from, event.to)
+                 << ",\"args\":{\"frame\":" << timings.frameNum << ",\"framesBehind\":" << timings.getFramesBehind() << ",\"dropped\":" << timings.numDropped << "}}";
+        }
+    }
+    file << "\n]}\n";
+    return bool(file);
+}
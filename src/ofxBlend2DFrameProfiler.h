@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+// Frame profiler
+// - - - -
+// Per-frame pipeline timestamps, always available (no ofxFps needed). The renderer stamps every frame as it travels :
+// submission (begin() -> end()) on the drawing thread, flush and file encoding on the worker, texture upload on the GL thread.
+// Completed frames are recorded by the GL thread into a lock-free ring (one writer, any number of readers, seqlock per entry),
+// which can be summarized (p50 / p95 / p99 per span) or exported as CSV or Chrome trace JSON (chrome://tracing, Perfetto).
+// Frames also carry the app frame (ofGetFrameNum()) they were drawn at and uploaded at, and how many finished frames were discarded
+// before them, giving the end-to-end latency : submit to upload time, frames behind and dropped frames (getLatencyStats()).
+// Recording costs a few relaxed atomic stores per frame.
+
+// Timestamps of one frame, in ofGetElapsedTimeMicros(), 0 when a stage didn't happen (ex: no encoding)
+struct ofxBlend2DFrameTimings {
+    enum Stamp : uint8_t {
+        SubmitBegin = 0, // begin()
+        SubmitEnd, // end()
+        FlushBegin, // Worker picks the frame up
+        FlushEnd, // Pixels ready
+        EncodeBegin, // Saving to a file (end(frameNum, file))
+        EncodeEnd,
+        UploadBegin, // update() loads the texture (receives the frame without texture uploads)
+        UploadEnd,
+        NumStamps
+    };
+
+    unsigned int frameNum = 0; // As passed to end()
+    uint64_t stamps[NumStamps] = {0};
+    uint64_t submitAppFrame = 0; // ofGetFrameNum() at begin()
+    uint64_t uploadAppFrame = 0; // ofGetFrameNum() at upload
+    uint32_t numDropped = 0; // Finished frames discarded (never uploaded) since the previous upload
+    uint32_t contextErrorFlags = 0; // BLContextErrorFlags accumulated by the frame's context
+    uint32_t threadCount = 0; // BLContextCreateInfo::thread_count of the frame's context
+
+    // App frames between sampling the app state and showing the result
+    uint64_t getFramesBehind() const { return uploadAppFrame>submitAppFrame ? uploadAppFrame-submitAppFrame : 0; }
+
+    uint64_t get(Stamp stamp) const { return stamps[stamp]; }
+    void set(Stamp stamp, uint64_t timeMicros) { stamps[stamp] = timeMicros; }
+    // Microseconds between two stamps, 0 if either is missing
+    uint64_t getDuration(Stamp from, Stamp to) const {
+        return (stamps[from]>0 && stamps[to]>=stamps[from]) ? stamps[to]-stamps[from] : 0;
+    }
+    // Microseconds of drawing and rasterization : submit + flush, without the queue wait.
+    // Synchronous contexts (thread_count=0) rasterize while submitting, so the flush alone doesn't compare across thread counts.
+    uint64_t getRenderDuration() const {
+        return getDuration(SubmitBegin, SubmitEnd) + getDuration(FlushBegin, FlushEnd);
+    }
+};
+
+class ofxBlend2DFrameProfiler {
+    public:
+        // Durations derived from the stamps
+        enum Span : uint8_t {
+            SubmitSpan = 0, // Drawing code, begin() to end()
+            QueueSpan, // Waiting for the worker
+            FlushSpan, // Blend2D rasterization
+            EncodeSpan, // File saving
+            WaitSpan, // Ready, waiting for update()
+            UploadSpan, // Texture upload
+            TotalSpan, // begin() to uploaded
+            LatencySpan, // end() to uploaded
+            IntervalSpan, // Between two uploads (1/fps)
+            NumSpans
+        };
+        static const char* getSpanName(Span span);
+
+        struct Summary {
+            std::size_t count = 0; // Frames having this span
+            float minMs = 0.f;
+            float meanMs = 0.f;
+            float p50Ms = 0.f;
+            float p95Ms = 0.f;
+            float p99Ms = 0.f;
+            float maxMs = 0.f;
+        };
+
+        // Submit to upload latency
+        struct LatencyStats {
+            Summary latency; // LatencySpan
+            Summary framesBehind; // In app frames (values are frame counts, not ms)
+            uint64_t numUploaded = 0; // Since the last clear()
+            uint64_t numDropped = 0;
+            float getDropRate() const { return (numUploaded+numDropped)>0 ? float(numDropped)/(numUploaded+numDropped) : 0.f; }
+        };
+
+        explicit ofxBlend2DFrameProfiler(std::size_t capacity=512);
+
+        // Writer side (single thread)
+        void record(const ofxBlend2DFrameTimings& timings);
+        void clear();
+
+        // Reader side (any thread) : the last numFrames recorded frames (0 = all), oldest first
+        std::vector<ofxBlend2DFrameTimings> getHistory(std::size_t numFrames=0) const;
+        bool getLatest(ofxBlend2DFrameTimings& timings) const;
+        Summary getSummary(Span span, std::size_t numFrames=0) const;
+        // One summary per span, from the same snapshot
+        std::vector<Summary> getSummaries(std::size_t numFrames=0) const;
+        static uint64_t getSpanMicros(const std::vector<ofxBlend2DFrameTimings>& history, std::size_t index, Span span);
+        LatencyStats getLatencyStats(std::size_t numFrames=0) const;
+        // Frame counts per bin, as floats for ImGui::PlotHistogram(). Durations above maxMs (or frames behind above numBins-1) go in the last bin.
+        std::vector<float> getHistogram(Span span, std::size_t numBins, float maxMs, std::size_t numFrames=0) const;
+        std::vector<float> getFramesBehindHistogram(std::size_t numBins, std::size_t numFrames=0) const;
+
+        // File exports (relative paths are in the data folder)
+        bool saveCsv(const std::string& path) const;
+        bool saveChromeTrace(const std::string& path) const;
+
+        std::size_t getCapacity() const { return capacity; }
+        uint64_t getNumRecorded() const { return head.load(std::memory_order_acquire); }
+        uint64_t getNumDropped() const { return numDropped.load(std::memory_order_acquire); }
+
+        std::atomic<bool> bEnabled{true}; // Set from any thread, read by record()
+
+    protected:
+        // Fields are atomics so readers can copy them while the writer reuses the entry
+        struct Entry {
+            std::atomic<uint32_t> sequence{0}; // Odd while written
+            std::atomic<uint32_t> frameNum{0};
+            std::atomic<uint64_t> stamps[ofxBlend2DFrameTimings::NumStamps];
+            std::atomic<uint64_t> submitAppFrame{0};
+            std::atomic<uint64_t> uploadAppFrame{0};
+            std::atomic<uint32_t> numDropped{0};
+            std::atomic<uint32_t> contextErrorFlags{0};
+            std::atomic<uint32_t> threadCount{0};
+            Entry(){ for(auto& stamp : stamps) stamp.store(0, std::memory_order_relaxed); }
+        };
+        bool readEntry(uint64_t index, ofxBlend2DFrameTimings& timings) const;
+
+        std::size_t capacity;
+        std::unique_ptr<Entry[]> entries;
+        std::atomic<uint64_t> head{0}; // Number of recorded frames
+        std::atomic<uint64_t> numDropped{0}; // Total, the ring may not cover all of them
+};
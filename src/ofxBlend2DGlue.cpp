@@ -3,15 +3,22 @@
 // OF Types
 #include "ofPixels.h"
 
+#include <cstring>
+#include <algorithm>
+
 
 // OF Glue
 // - - - -
 BLPath toBLPath(ofPath const& _p){
+    BLPath ret;
     if(_p.getMode()!=ofPath::Mode::COMMANDS){
-        ofLogWarning("ofxBlend2D::toBLPath") << "The path is not in CMD mode, returning an empty BLPath !";
+        // Polylines mode : use the (already tessellated) outlines
+        for(const ofPolyline& outline : _p.getOutline()){
+            ret.add_path(toBLPath(outline));
+        }
+        return ret;
     }
     bool warnUnsupportedCmd = false;
-    BLPath ret;
     for( const ofPath::Command& cmd : _p.getCommands()){
         // Warning: ofxSVG, via tinyxml, doesn't reveal all SVG commands, some are converted, some are ignored !
         switch(cmd.type){
@@ -23,24 +30,30 @@ BLPath toBLPath(ofPath const& _p){
                 ret.line_to(toBLPoint(cmd.to));
                     break;
             case ofPath::Command::Type::curveTo:
-                ret.line_to(toBLPoint(cmd.to)); // todo ! (uses a line instead of an arc)
+                ret.line_to(toBLPoint(cmd.to)); // todo ! (uses a line instead of a Catmull-Rom curve)
                 warnUnsupportedCmd = true;
                     break;
             case ofPath::Command::Type::bezierTo:
                 ret.cubic_to(toBLPoint(cmd.cp1), toBLPoint(cmd.cp2), toBLPoint(cmd.to));
                     break;
             case ofPath::Command::Type::quadBezierTo:
-                warnUnsupportedCmd = true;
-                //ret.quadTo(toBLPoint(cmd.cp1),toBLPoint(cmd.cp2),cmd.);
+                // OF stores the start point in cp1 and the control point in cp2
+                if(ret.is_empty()) ret.move_to(toBLPoint(cmd.cp1));
+                ret.quad_to(toBLPoint(cmd.cp2), toBLPoint(cmd.to));
                     break;
             case ofPath::Command::Type::arc:
-                warnUnsupportedCmd = true;
-                //ret.arc(cmd.to,cmd.radiusX,cmd.radiusY,cmd.angleBegin,cmd.angleEnd);
-                    break;
-            case ofPath::Command::Type::arcNegative:
-                warnUnsupportedCmd = true;
-                //ret.arcNegative(cmd.to,cmd.radiusX,cmd.radiusY,cmd.angleBegin,cmd.angleEnd);
+            case ofPath::Command::Type::arcNegative: {
+                // OF angles are in degrees, arcs sweep towards increasing angles (or decreasing for arcNegative)
+                double sweep = cmd.angleEnd-cmd.angleBegin;
+                if(cmd.type==ofPath::Command::Type::arc){
+                    while(sweep<=0.) sweep += 360.;
+                }
+                else {
+                    while(sweep>=0.) sweep -= 360.;
+                }
+                ret.arc_to(cmd.to.x, cmd.to.y, cmd.radiusX, cmd.radiusY, cmd.angleBegin*DEG_TO_RAD, sweep*DEG_TO_RAD);
                     break;
+            }
             case ofPath::Command::Type::close:
                 ret.close();
                     break;
@@ -52,6 +65,19 @@ BLPath toBLPath(ofPath const& _p){
     return ret;
 }
 
+BLPath toBLPath(ofPolyline const& _p){
+    BLPath ret;
+    const auto& vertices = _p.getVertices();
+    if(vertices.empty()) return ret;
+    ret.reserve(vertices.size()+1);
+    ret.move_to(toBLPoint(vertices[0]));
+    for(std::size_t i=1; i<vertices.size(); ++i){
+        ret.line_to(toBLPoint(vertices[i]));
+    }
+    if(_p.isClosed()) ret.close();
+    return ret;
+}
+
 // Utility for making error codes human-readable
 // Todo: implement toString(BLResult with this for seamless logging compatibility)
 std::string blResultToString(BLResult r){
@@ -358,6 +384,59 @@ ofPixelFormat ofxBlend2DGetOfPixelFormatFromGLFormat(const GLint glFormat){
     }
 }
 
+bool toOfPixels(const uint8_t* pixelData, int width, int height, uint32_t blFormat, intptr_t stride, ofPixels& pixels){
+    if(pixelData==nullptr || width<=0 || height<=0) return false;
+    switch(blFormat){
+        case BL_FORMAT_PRGB32: {
+            // 0xAARRGGBB words, premultiplied
+            pixels.allocate(width, height, OF_PIXELS_RGBA);
+            uint8_t* dst = pixels.getData();
+            for(int y=0; y<height; ++y){
+                const uint8_t* row = pixelData + y*stride;
+                for(int x=0; x<width; ++x, dst+=4){
+                    uint32_t pixel;
+                    std::memcpy(&pixel, row + x*4, 4);
+                    const uint32_t a = pixel >> 24;
+                    const uint32_t r = (pixel >> 16) & 0xFFu, g = (pixel >> 8) & 0xFFu, b = pixel & 0xFFu;
+                    dst[3] = (uint8_t)a;
+                    if(a==0xFFu){ dst[0] = (uint8_t)r; dst[1] = (uint8_t)g; dst[2] = (uint8_t)b; }
+                    else if(a==0){ dst[0] = dst[1] = dst[2] = 0; }
+                    else {
+                        dst[0] = (uint8_t)std::min(255u, (r*255u + a/2)/a);
+                        dst[1] = (uint8_t)std::min(255u, (g*255u + a/2)/a);
+                        dst[2] = (uint8_t)std::min(255u, (b*255u + a/2)/a);
+                    }
+                }
+            }
+            return true;
+        }
+        case BL_FORMAT_XRGB32: {
+            // 0xFFRRGGBB words
+            pixels.allocate(width, height, OF_PIXELS_RGB);
+            uint8_t* dst = pixels.getData();
+            for(int y=0; y<height; ++y){
+                const uint8_t* row = pixelData + y*stride;
+                for(int x=0; x<width; ++x, dst+=3){
+                    uint32_t pixel;
+                    std::memcpy(&pixel, row + x*4, 4);
+                    dst[0] = (uint8_t)(pixel >> 16);
+                    dst[1] = (uint8_t)(pixel >> 8);
+                    dst[2] = (uint8_t)pixel;
+                }
+            }
+            return true;
+        }
+        case BL_FORMAT_A8:
+            return pixels.setFromAlignedPixels(pixelData, width, height, OF_PIXELS_GRAY, (int)stride);
+        default:
+            return false;
+    }
+}
+
+bool toOfPixels(const BLImageData& imageData, ofPixels& pixels){
+    return toOfPixels(static_cast<const uint8_t*>(imageData.pixel_data), imageData.size.w, imageData.size.h, imageData.format, imageData.stride, pixels);
+}
+
 const char* blCmdToStr(const uint8_t*const cmd){
    if(cmd==nullptr || *cmd>BL_PATH_CMD_MAX_VALUE) return "unknown";
    switch(*cmd){
@@ -6,6 +6,7 @@
 #include "ofMath.h"
 #include "ofColor.h"
 #include "ofPath.h"
+#include "ofPixels.h"
 
 
 // OF Glue
@@ -24,6 +25,7 @@ inline constexpr BLPoint toBLPoint(glm::vec3 const& _p){
 }
 
 BLPath toBLPath(ofPath const& _p);
+BLPath toBLPath(ofPolyline const& _p);
 
 // Utility for making errors human-readable
 std::string blResultToString(BLResult r);
@@ -35,5 +37,10 @@ GLint blFormatToGlFormat(uint16_t blFormat);
 // Note: lossy conversion, some glFormats have multiple corresponding ofFormats
 ofPixelFormat ofxBlend2DGetOfPixelFormatFromGLFormat(const GLint glFormat);
 
+// Copies Blend2D pixels to ofPixels, converting them : PRGB32 (premultiplied BGRA in memory) to straight RGBA, XRGB32 to RGB, A8 to gray.
+// Returns false on other formats.
+bool toOfPixels(const uint8_t* pixelData, int width, int height, uint32_t blFormat, intptr_t stride, ofPixels& pixels);
+bool toOfPixels(const BLImageData& imageData, ofPixels& pixels);
+
 // Util for printing human readable data
 const char* blCmdToStr(const uint8_t*const cmd);
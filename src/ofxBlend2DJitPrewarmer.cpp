@@ -0,0 +1,148 @@
+#include "ofxBlend2DJitPrewarmer.h"
+#include "ofLog.h"
+
+#include <chrono>
+#include <algorithm>
+
+const char* ofxBlend2DJitPrewarmer::getStyleName(Style style){
+    static const char* names[NumStyles] = { "solid", "linear gradient", "radial gradient", "conic gradient", "pattern" };
+    return style<NumStyles ? names[style] : "unknown";
+}
+
+std::vector<ofxBlend2DJitPrewarmer::Entry> ofxBlend2DJitPrewarmer::Report::getSlowest(std::size_t count) const {
+    std::vector<Entry> slowest = entries;
+    std::sort(slowest.begin(), slowest.end(), [](const Entry& a, const Entry& b){ return a.ms>b.ms; });
+    if(slowest.size()>count) slowest.resize(count);
+    return slowest;
+}
+
+ofxBlend2DJitPrewarmer::~ofxBlend2DJitPrewarmer(){
+    stop();
+}
+
+ofxBlend2DJitPrewarmer::Report ofxBlend2DJitPrewarmer::run(const Settings& settings, const std::atomic<bool>* bStop){
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point beginTime = Clock::now();
+    Report report;
+
+    std::vector<BLCompOp> compOps = settings.compOps;
+    if(compOps.empty()){
+        for(uint32_t compOp=0; compOp<=BL_COMP_OP_MAX_VALUE; ++compOp) compOps.push_back((BLCompOp)compOp);
+    }
+    const std::vector<BLFormat> formats = settings.formats.empty() ? std::vector<BLFormat>{ BL_FORMAT_PRGB32 } : settings.formats;
+    const double size = std::max(8, settings.canvasSize);
+
+    // Styles
+    BLGradient linear(BLLinearGradientValues(0, 0, size, size));
+    BLGradient radial(BLRadialGradientValues(size*.5, size*.5, size*.5, size*.5, size*.5));
+    BLGradient conic(BLConicGradientValues(size*.5, size*.5, 0.0));
+    for(BLGradient* gradient : { &linear, &radial, &conic }){
+        gradient->add_stop(0.0, BLRgba32(0xFFFF0000u));
+        gradient->add_stop(1.0, BLRgba32(0x800000FFu));
+    }
+    BLImage patternImage(8, 8, BL_FORMAT_PRGB32);
+    {
+        BLContext patternCtx(patternImage);
+        patternCtx.fill_all(BLRgba32(0xFFFFFFFFu));
+        patternCtx.fill_rect(BLRectI(0, 0, 4, 4), BLRgba32(0xFF000000u));
+        patternCtx.end();
+    }
+    BLPattern pattern(patternImage);
+    pattern.scale(1.7); // Not pixel aligned : the filtered pipelines
+
+    BLContextCreateInfo createInfo = {};
+    createInfo.flags = settings.contextFlags;
+    createInfo.thread_count = 0; // Compiles on this thread
+
+    for(BLFormat format : formats){
+        BLImage canvas((int)size, (int)size, format);
+        for(BLCompOp compOp : compOps)
+        for(Style style : settings.styles){
+            if(bStop!=nullptr && *bStop) return report;
+            const Clock::time_point entryBeginTime = Clock::now();
+
+            BLContext ctx;
+            if(ctx.begin(canvas, createInfo)!=BL_SUCCESS){
+                ofLogError("ofxBlend2DJitPrewarmer") << "Couldn't create a context for format " << format;
+                return report;
+            }
+            ctx.set_comp_op(compOp);
+            // Each quality is a different pipeline
+            const std::size_t numQualities = (style==SolidStyle) ? 1 : (style==PatternStyle) ? settings.patternQualities.size() : settings.gradientQualities.size();
+            for(std::size_t quality=0; quality<std::max<std::size_t>(1, numQualities); ++quality){
+                switch(style){
+                    case SolidStyle: ctx.set_fill_style(BLRgba32(0xC080FF40u)); break;
+                    case LinearGradientStyle: ctx.set_fill_style(linear); break;
+                    case RadialGradientStyle: ctx.set_fill_style(radial); break;
+                    case ConicGradientStyle: ctx.set_fill_style(conic); break;
+                    case PatternStyle: ctx.set_fill_style(pattern); break;
+                    default: break;
+                }
+                if(style==PatternStyle && quality<settings.patternQualities.size()) ctx.set_pattern_quality(settings.patternQualities[quality]);
+                else if(style!=SolidStyle && quality<settings.gradientQualities.size()) ctx.set_gradient_quality(settings.gradientQualities[quality]);
+
+                // Box, fractional box and analytic fills
+                ctx.fill_rect(BLRectI(1, 1, (int)(size*.4), (int)(size*.4)));
+                ctx.fill_rect(BLRect(size*.5+.3, .7, size*.4, size*.4));
+                ctx.fill_circle(size*.5, size*.75, size*.2);
+            }
+            ctx.flush(BL_CONTEXT_FLUSH_SYNC);
+            report.contextErrorFlags |= ctx.accumulated_error_flags();
+            ctx.end();
+
+            Entry entry;
+            entry.compOp = compOp;
+            entry.style = style;
+            entry.format = format;
+            entry.ms = std::chrono::duration<float, std::milli>(Clock::now()-entryBeginTime).count();
+            report.entries.push_back(entry);
+        }
+    }
+
+    report.totalMs = std::chrono::duration<float, std::milli>(Clock::now()-beginTime).count();
+    report.bCompleted = true;
+    ofLogNotice("ofxBlend2DJitPrewarmer") << "Prewarmed " << report.entries.size() << " pipeline combinations in " << report.totalMs << " ms.";
+    if(report.contextErrorFlags!=0){
+        ofLogWarning("ofxBlend2DJitPrewarmer") << "Context errors while prewarming, flags=" << report.contextErrorFlags;
+    }
+    return report;
+}
+
+ofxBlend2DJitPrewarmer::Report ofxBlend2DJitPrewarmer::runBlocking(const Settings& settings){
+    const Report newReport = run(settings);
+    if(newReport.bCompleted){
+        std::lock_guard<std::mutex> lock(mutex);
+        report = newReport;
+    }
+    return newReport;
+}
+
+bool ofxBlend2DJitPrewarmer::start(const Settings& settings){
+    if(bRunning) return false;
+    if(thread.joinable()) thread.join();
+    bStop = false;
+    bRunning = true;
+    thread = std::thread([this, settings](){
+        const Report newReport = run(settings, &bStop);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(newReport.bCompleted) report = newReport;
+        }
+        bRunning = false;
+    });
+    return true;
+}
+
+void ofxBlend2DJitPrewarmer::stop(){
+    bStop = true;
+    wait();
+}
+
+void ofxBlend2DJitPrewarmer::wait(){
+    if(thread.joinable()) thread.join();
+}
+
+ofxBlend2DJitPrewarmer::Report ofxBlend2DJitPrewarmer::getReport() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return report;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "blend2d/blend2d.h"
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+// JIT pipeline prewarming
+// - - - -
+// Blend2D compiles its fill pipelines lazily : the first frame using a new composition operator, style type or pixel format hitches.
+// The prewarmer renders a matrix of comp ops x styles x formats into a small offscreen canvas, so they're compiled before the first show frame.
+// Pipelines are cached by the global JIT runtime, shared by all contexts (except with BL_CONTEXT_CREATE_FLAG_ISOLATED_JIT_RUNTIME).
+// Each combination is drawn as an aligned rectangle, a fractional one and a circle (box, masked and analytic fills).
+//
+// Usage :
+//     blend2d.prewarm(); // Blocking, all comp ops and styles for the renderer's format
+//     blend2d.prewarm(settings, true); // On a background thread, see getPrewarmer().isRunning() and getReport()
+
+class ofxBlend2DJitPrewarmer {
+    public:
+        enum Style : uint8_t {
+            SolidStyle = 0,
+            LinearGradientStyle,
+            RadialGradientStyle,
+            ConicGradientStyle,
+            PatternStyle,
+            NumStyles
+        };
+        static const char* getStyleName(Style style);
+
+        struct Settings {
+            std::vector<BLCompOp> compOps; // Empty = all
+            std::vector<Style> styles = { SolidStyle, LinearGradientStyle, RadialGradientStyle, ConicGradientStyle, PatternStyle };
+            std::vector<BLFormat> formats; // Empty = PRGB32 (the renderer's format with ofxBlend2DThreadedRenderer::prewarm())
+            std::vector<BLGradientQuality> gradientQualities = { BL_GRADIENT_QUALITY_NEAREST };
+            std::vector<BLPatternQuality> patternQualities = { BL_PATTERN_QUALITY_NEAREST, BL_PATTERN_QUALITY_BILINEAR };
+            int canvasSize = 64;
+            uint32_t contextFlags = 0; // BLContextCreateFlags, ex: the renderer's (compiled pipelines are the same for any thread count)
+        };
+
+        // Time spent on one combination, mostly compiling
+        struct Entry {
+            BLCompOp compOp = BL_COMP_OP_SRC_OVER;
+            Style style = SolidStyle;
+            BLFormat format = BL_FORMAT_PRGB32;
+            float ms = 0.f;
+        };
+
+        struct Report {
+            std::vector<Entry> entries;
+            float totalMs = 0.f;
+            uint32_t contextErrorFlags = 0;
+            bool bCompleted = false; // False when stopped or failed
+            // The entries taking the longest first
+            std::vector<Entry> getSlowest(std::size_t count) const;
+        };
+
+        ofxBlend2DJitPrewarmer() = default;
+        ~ofxBlend2DJitPrewarmer();
+
+        // Blocking
+        static Report run(const Settings& settings, const std::atomic<bool>* bStop=nullptr);
+        // Blocking, kept as the last report (see getReport())
+        Report runBlocking(const Settings& settings);
+
+        // Background thread, returns false if already running
+        bool start(const Settings& settings);
+        void stop();
+        void wait();
+        bool isRunning() const {
+            return bRunning;
+        }
+        // The last completed run
+        Report getReport() const;
+
+    protected:
+        std::thread thread;
+        std::atomic<bool> bRunning{false};
+        std::atomic<bool> bStop{false};
+        mutable std::mutex mutex;
+        Report report;
+};
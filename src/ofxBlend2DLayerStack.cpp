@@ -0,0 +1,156 @@
+#include "ofxBlend2DLayerStack.h"
+#include "ofxBlend2DGlue.h"
+#include "ofxBlend2DUtils.h"
+#include "ofLog.h"
+
+#include <future>
+#include <chrono>
+#include <algorithm>
+
+void ofxBlend2DLayerStack::allocate(int _width, int _height, BLFormat _format){
+    if(_format!=BL_FORMAT_PRGB32 && _format!=BL_FORMAT_A8){
+        ofLogWarning("ofxBlend2DLayerStack::allocate") << "Layers need an alpha channel, using PRGB32.";
+        _format = BL_FORMAT_PRGB32;
+    }
+    width = _width;
+    height = _height;
+    format = _format;
+    for(Layer& layer : layers){
+        layer.canvas = BLImage(width, height, format);
+        layer.bIsDirty = true;
+        layer.bHasContent = false;
+    }
+}
+
+std::size_t ofxBlend2DLayerStack::addLayer(const std::string& name, RefreshPolicy policy, DrawFunction draw, unsigned int interval){
+    layers.emplace_back();
+    Layer& layer = layers.back();
+    layer.name = name;
+    layer.policy = policy;
+    layer.interval = std::max(1u, interval);
+    layer.draw = std::move(draw);
+    if(width>0 && height>0) layer.canvas = BLImage(width, height, format);
+    return layers.size()-1;
+}
+
+void ofxBlend2DLayerStack::removeLayer(std::size_t index){
+    if(index<layers.size()) layers.erase(layers.begin()+index);
+}
+
+void ofxBlend2DLayerStack::clear(){
+    layers.clear();
+    stats = Stats();
+}
+
+ofxBlend2DLayerStack::Layer* ofxBlend2DLayerStack::getLayer(const std::string& name){
+    for(Layer& layer : layers){
+        if(layer.name==name) return &layer;
+    }
+    return nullptr;
+}
+
+void ofxBlend2DLayerStack::markDirty(std::size_t index){
+    if(index<layers.size()) layers[index].bIsDirty = true;
+}
+
+bool ofxBlend2DLayerStack::markDirty(const std::string& name){
+    Layer* layer = getLayer(name);
+    if(layer==nullptr) return false;
+    layer->bIsDirty = true;
+    return true;
+}
+
+void ofxBlend2DLayerStack::markAllDirty(){
+    for(Layer& layer : layers){
+        layer.bIsDirty = true;
+    }
+}
+
+bool ofxBlend2DLayerStack::isDue(const Layer& layer, unsigned int frameNum) const {
+    if(layer.bIsDirty || !layer.bHasContent) return true;
+    switch(layer.policy){
+        case EveryFrame:
+            return true;
+        case EveryNFrames:
+            return frameNum-layer.lastRenderedFrame >= layer.interval;
+        case OnDemand:
+        default:
+            return false;
+    }
+}
+
+bool ofxBlend2DLayerStack::renderLayer(Layer& layer, unsigned int frameNum){
+    const auto startTime = std::chrono::steady_clock::now();
+
+    BLContext ctx;
+    BLResult result = ofxBlend2D::BeginCanvasContext(ctx, layer.canvas, layer.threadCount);
+    if(result != BL_SUCCESS){
+        ofLogError("ofxBlend2DLayerStack::renderLayer") << "Couldn't create a context for layer " << layer.name << " : " << blResultToString(result);
+        return false; // Stays due, retried on the next render()
+    }
+    ctx.clear_all();
+    if(layer.draw) layer.draw(ctx, frameNum);
+    ctx.end();
+
+    layer.bIsDirty = false;
+    layer.bHasContent = true;
+    layer.lastRenderedFrame = frameNum;
+    layer.renderTimeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now()-startTime).count();
+    return true;
+}
+
+std::size_t ofxBlend2DLayerStack::render(unsigned int frameNum){
+    const auto startTime = std::chrono::steady_clock::now();
+    stats = Stats();
+
+    if(width<=0 || height<=0){
+        ofxBlend2D::LogNotAllocated("ofxBlend2DLayerStack::render");
+        return 0;
+    }
+
+    std::vector<Layer*> dueLayers;
+    dueLayers.reserve(layers.size());
+    for(Layer& layer : layers){
+        if(layer.isVisible && isDue(layer, frameNum)) dueLayers.push_back(&layer);
+        else stats.numSkipped++;
+    }
+
+    if(bRenderConcurrently && dueLayers.size()>1){
+        // Every layer has its own canvas and context : no shared state between the tasks
+        std::vector<std::future<bool> > tasks;
+        tasks.reserve(dueLayers.size()-1);
+        for(std::size_t i=1; i<dueLayers.size(); ++i){
+            Layer* layer = dueLayers[i];
+            tasks.push_back(std::async(std::launch::async, [this, layer, frameNum](){
+                return renderLayer(*layer, frameNum);
+            }));
+        }
+        // Calling thread renders one too
+        if(renderLayer(*dueLayers[0], frameNum)) stats.numRendered++;
+        else stats.numFailed++;
+        for(std::future<bool>& task : tasks){
+            if(task.get()) stats.numRendered++;
+            else stats.numFailed++;
+        }
+    }
+    else {
+        for(Layer* layer : dueLayers){
+            if(renderLayer(*layer, frameNum)) stats.numRendered++;
+            else stats.numFailed++;
+        }
+    }
+
+    stats.renderTimeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now()-startTime).count();
+    return stats.numRendered;
+}
+
+void ofxBlend2DLayerStack::composite(BLContext& ctx) const {
+    ctx.save();
+    for(const Layer& layer : layers){
+        if(!layer.isVisible || !layer.bHasContent || layer.opacity<=0.f) continue;
+        ctx.set_comp_op(layer.compOp);
+        ctx.set_global_alpha(layer.opacity);
+        ctx.blit_image(BLPoint(0, 0), layer.canvas);
+    }
+    ctx.restore();
+}
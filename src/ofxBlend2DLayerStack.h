@@ -0,0 +1,113 @@
+#pragma once
+
+#include "blend2d/blend2d.h"
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <cstdint>
+
+// Layered compositing
+// - - - -
+// Scenes often mix a static background, slowly changing data and a fast cursor / HUD.
+// Each layer owns a canvas (a transparent BLImage) and is only repainted when it's dirty or when its refresh policy says so,
+// otherwise its previous canvas is reused. render() repaints the due layers concurrently (one BLContext per layer),
+// composite() then blits all canvases in stack order, with their comp op and opacity, into the frame context.
+// A static layer costs a single blit per frame after its first render.
+//
+// Usage :
+//     layers.allocate(w, h);
+//     layers.addLayer("background", ofxBlend2DLayerStack::OnDemand, [](BLContext& ctx, unsigned int frameNum){ ... });
+//     layers.addLayer("cursor", ofxBlend2DLayerStack::EveryFrame, [](BLContext& ctx, unsigned int frameNum){ ... });
+//     if(blend2d.begin()){
+//         layers.render(frameNum);
+//         layers.composite(blend2d.getBlContext());
+//         blend2d.end(frameNum);
+//     }
+//
+// Thread safety : draw functions of different layers run at the same time (on worker threads), they must not write to shared data.
+// render() returns once all layers are done, so they can safely read app data which is only modified around it.
+
+class ofxBlend2DLayerStack {
+    public:
+        enum RefreshPolicy : uint8_t {
+            OnDemand = 0, // Only when marked dirty (and on the first render, or after a resize)
+            EveryNFrames, // Every `interval` frames, or when marked dirty
+            EveryFrame,
+        };
+
+        typedef std::function<void(BLContext& ctx, unsigned int frameNum)> DrawFunction;
+
+        struct Layer {
+            std::string name;
+            RefreshPolicy policy = OnDemand;
+            unsigned int interval = 1; // For EveryNFrames
+            DrawFunction draw;
+
+            // Compositing
+            bool isVisible = true;
+            BLCompOp compOp = BL_COMP_OP_SRC_OVER;
+            float opacity = 1.f;
+
+            // Threads used by the layer's own context (0 = synchronous, layers already render in parallel)
+            uint32_t threadCount = 0;
+
+            // State
+            BLImage canvas;
+            bool bIsDirty = true;
+            bool bHasContent = false; // Rendered at least once since the last allocation
+            unsigned int lastRenderedFrame = 0;
+            float renderTimeMs = 0.f; // Duration of the last repaint
+        };
+
+        struct Stats {
+            std::size_t numRendered = 0; // Repainted layers (last render() call)
+            std::size_t numSkipped = 0; // Reused canvases (last render() call)
+            std::size_t numFailed = 0; // Due layers which couldn't begin a context, they stay due (last render() call)
+            float renderTimeMs = 0.f; // Wall time of the last render() call
+        };
+
+        // Sets the canvas size of all layers (content is lost, all layers become dirty). Layers need an alpha channel : PRGB32 or A8.
+        void allocate(int width, int height, BLFormat format=BL_FORMAT_PRGB32);
+
+        // Returns the layer index. Layers are composited in insertion order (first = bottom).
+        std::size_t addLayer(const std::string& name, RefreshPolicy policy, DrawFunction draw, unsigned int interval=1);
+        void removeLayer(std::size_t index);
+        void clear();
+
+        std::size_t size() const { return layers.size(); }
+        Layer& getLayer(std::size_t index) { return layers[index]; }
+        const Layer& getLayer(std::size_t index) const { return layers[index]; }
+        // Returns nullptr if there's no such layer
+        Layer* getLayer(const std::string& name);
+        std::vector<Layer>& getLayers() { return layers; }
+
+        // Requests a repaint on the next render()
+        void markDirty(std::size_t index);
+        bool markDirty(const std::string& name);
+        void markAllDirty();
+
+        // Repaints the layers due for frameNum, concurrently. Blocks until they're done, returns the number of repainted layers (failures are in getStats()).
+        std::size_t render(unsigned int frameNum);
+
+        // Blits the visible layer canvases onto ctx (at its current transform), restoring the context state afterwards.
+        void composite(BLContext& ctx) const;
+
+        const Stats& getStats() const { return stats; }
+
+        int getWidth() const { return width; }
+        int getHeight() const { return height; }
+
+        // Runs the layer repaints in parallel (otherwise one after the other, on the calling thread)
+        bool bRenderConcurrently = true;
+
+    protected:
+        bool isDue(const Layer& layer, unsigned int frameNum) const;
+        bool renderLayer(Layer& layer, unsigned int frameNum); // False if the layer couldn't be rendered
+
+        std::vector<Layer> layers;
+        int width = 0;
+        int height = 0;
+        BLFormat format = BL_FORMAT_PRGB32;
+        Stats stats;
+};
@@ -0,0 +1,270 @@
+#include "ofxBlend2DOfflineExporter.h"
+#include "ofxBlend2DGlue.h"
+#include "ofAppRunner.h" // ofGetElapsedTimeMicros
+#include "ofLog.h"
+
+#include <algorithm>
+
+std::mutex ofxBlend2DOfflineExporter::encodeMutex;
+
+ofxBlend2DOfflineExporter::~ofxBlend2DOfflineExporter(){
+    cancel();
+    join();
+}
+
+void ofxBlend2DOfflineExporter::setup(const Settings& _settings){
+    if(bRunning){
+        ofLogWarning("ofxBlend2DOfflineExporter::setup") << "Can't change the settings while exporting !";
+        return;
+    }
+    settings = _settings;
+}
+
+bool ofxBlend2DOfflineExporter::start(unsigned int _firstFrame, unsigned int _numFrames, DrawFunction draw, WriteFunction write){
+    if(bRunning){
+        ofLogError("ofxBlend2DOfflineExporter::start") << "Already exporting !";
+        return false;
+    }
+    join(); // Previous export
+    if(!draw || _numFrames==0 || settings.width<=0 || settings.height<=0){
+        ofLogError("ofxBlend2DOfflineExporter::start") << "Nothing to export (no draw function, no frames or invalid size).";
+        return false;
+    }
+
+    drawFunction = std::move(draw);
+    writeFunction = std::move(write);
+    firstFrame = _firstFrame;
+    numFrames = _numFrames;
+
+    // File mode
+    if(!writeFunction){
+        if(settings.filePattern.empty()){
+            ofLogError("ofxBlend2DOfflineExporter::start") << "No write function and no file pattern !";
+            return false;
+        }
+        std::string extension = ofToLower(ofFilePath::getFileExt(settings.filePattern));
+        if(extension=="png") fileFormat = OF_IMAGE_FORMAT_PNG;
+        else if(extension=="jpg" || extension=="jpeg") fileFormat = OF_IMAGE_FORMAT_JPEG;
+        else if(extension=="bmp") fileFormat = OF_IMAGE_FORMAT_BMP;
+        else if(extension=="tif" || extension=="tiff") fileFormat = OF_IMAGE_FORMAT_TIFF;
+        else {
+            ofLogWarning("ofxBlend2DOfflineExporter::start") << "Unknown image extension \"" << extension << "\", writing PNG data.";
+            fileFormat = OF_IMAGE_FORMAT_PNG;
+        }
+        const std::string directory = ofFilePath::getEnclosingDirectory(ofToDataPath(settings.filePattern, true), false);
+        if(!directory.empty() && !ofDirectory::doesDirectoryExist(directory, false)){
+            ofDirectory::createDirectory(directory, false, true);
+        }
+    }
+
+    // Frame parallelism
+    unsigned int numThreads = settings.numConcurrentFrames;
+    if(numThreads==0){
+        numThreads = std::max(1u, std::thread::hardware_concurrency()/std::max(1u, settings.threadsPerFrame));
+    }
+    numThreads = std::min(numThreads, numFrames);
+    maxAhead = std::max(settings.maxFramesAhead>0 ? settings.maxFramesAhead : 2*numThreads, numThreads);
+
+    results.clear();
+    canvasPool->clear();
+    canvasPool->maxFree = maxAhead;
+    nextToRender = 0;
+    numWritten = 0;
+    numRendered = 0;
+    renderMicros = 0;
+    writeMicros = 0;
+    bCancelled = false;
+    bFailed = false;
+    bRunning = true;
+    startTime = ofGetElapsedTimeMicros();
+    endTime = 0;
+
+    ofLogNotice("ofxBlend2DOfflineExporter::start") << "Exporting " << numFrames << " frames, " << numThreads << " at once with " << settings.threadsPerFrame << " Blend2D threads each.";
+
+    writerThread = std::thread(&ofxBlend2DOfflineExporter::writerFunction, this);
+    renderThreads.reserve(numThreads);
+    for(unsigned int i=0; i<numThreads; ++i){
+        renderThreads.emplace_back(&ofxBlend2DOfflineExporter::renderFunction, this);
+    }
+    return true;
+}
+
+bool ofxBlend2DOfflineExporter::wait(){
+    join();
+    return !bFailed && !bCancelled && numWritten==numFrames;
+}
+
+void ofxBlend2DOfflineExporter::cancel(){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        bCancelled = true;
+    }
+    resultCondition.notify_all();
+    writtenCondition.notify_all();
+}
+
+void ofxBlend2DOfflineExporter::fail(){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        bFailed = true;
+    }
+    resultCondition.notify_all();
+    writtenCondition.notify_all();
+}
+
+void ofxBlend2DOfflineExporter::join(){
+    for(std::thread& thread : renderThreads){
+        if(thread.joinable()) thread.join();
+    }
+    renderThreads.clear();
+    if(writerThread.joinable()) writerThread.join();
+}
+
+ofxBlend2DOfflineExporter::Stats ofxBlend2DOfflineExporter::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats stats;
+    stats.numFrames = numFrames;
+    stats.numRendered = numRendered;
+    stats.numWritten = numWritten;
+    const uint64_t now = endTime>0 ? endTime : (bRunning ? ofGetElapsedTimeMicros() : startTime);
+    stats.elapsedSeconds = (now-startTime)/1000000.f;
+    stats.renderSeconds = renderMicros/1000000.f;
+    stats.writeSeconds = writeMicros/1000000.f;
+    return stats;
+}
+
+std::string ofxBlend2DOfflineExporter::getFileName(const std::string& pattern, unsigned int frameNum){
+    const std::size_t start = pattern.find('#');
+    std::string number = ofToString(frameNum);
+    if(start==std::string::npos){
+        // No placeholder : append the number before the extension
+        const std::string extension = ofFilePath::getFileExt(pattern);
+        return ofFilePath::removeExt(pattern) + "_" + number + (extension.empty() ? "" : "." + extension);
+    }
+    std::size_t end = pattern.find_first_not_of('#', start);
+    if(end==std::string::npos) end = pattern.size();
+    const std::size_t numDigits = end-start;
+    if(number.size()<numDigits) number.insert(0, numDigits-number.size(), '0');
+    return pattern.substr(0, start) + number + pattern.substr(end);
+}
+
+void ofxBlend2DOfflineExporter::renderFunction(){
+    BLContextCreateInfo createInfo = {};
+    createInfo.thread_count = settings.threadsPerFrame;
+
+    for(;;){
+        if(bCancelled || bFailed) return;
+        const unsigned int offset = nextToRender++;
+        if(offset>=numFrames) return;
+
+        // Don't get too far ahead of the writer (memory), the lowest pending frame always passes
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            writtenCondition.wait(lock, [this, offset](){ return offset<numWritten+maxAhead || bCancelled || bFailed; });
+        }
+        if(bCancelled || bFailed) return;
+
+        const unsigned int frameNum = firstFrame+offset;
+        const uint64_t beginTime = ofGetElapsedTimeMicros();
+        Result result;
+
+        BLImage img = canvasPool->acquire(settings.width, settings.height, settings.format);
+        BLContext ctx;
+        BLResult blResult = ctx.begin(img, createInfo);
+        if(blResult==BL_SUCCESS){
+            ctx.clear_all();
+            if(settings.clearColor.a()>0){
+                ctx.fill_all(settings.clearColor);
+            }
+            drawFunction(ctx, frameNum);
+            blResult = ctx.end();
+        }
+        if(blResult!=BL_SUCCESS){
+            ofLogError("ofxBlend2DOfflineExporter") << "Couldn't render frame " << frameNum << " : " << blResultToString(blResult);
+        }
+        else {
+            ofxBlend2DFrameTimings timings;
+            timings.frameNum = frameNum;
+            timings.set(ofxBlend2DFrameTimings::SubmitBegin, beginTime);
+            timings.set(ofxBlend2DFrameTimings::FlushEnd, ofGetElapsedTimeMicros());
+            result.frame = ofxBlend2DFrame::create(std::move(img), timings, canvasPool);
+            result.isValid = result.frame.isValid();
+
+            // Convert here (in parallel), the canvas can then be reused right away.
+            // FreeImage isn't guaranteed to be thread safe : encoding is serialized (by all exporters).
+            if(result.isValid && !writeFunction){
+                ofPixels pixels;
+                result.isValid = result.frame.toPixels(pixels);
+                result.frame = ofxBlend2DFrame();
+                if(result.isValid){
+                    std::lock_guard<std::mutex> encodeLock(encodeMutex);
+                    result.isValid = ofSaveImage(pixels, result.encoded, fileFormat, settings.quality);
+                }
+                if(!result.isValid){
+                    ofLogError("ofxBlend2DOfflineExporter") << "Couldn't encode frame " << frameNum;
+                }
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            results[offset] = std::move(result);
+            numRendered++;
+            renderMicros += ofGetElapsedTimeMicros()-beginTime;
+        }
+        resultCondition.notify_all();
+    }
+}
+
+void ofxBlend2DOfflineExporter::writerFunction(){
+    for(unsigned int offset=0; offset<numFrames; ++offset){
+        Result result;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            resultCondition.wait(lock, [this, offset](){ return results.count(offset)>0 || bCancelled || bFailed; });
+            auto it = results.find(offset);
+            if(it==results.end()) break; // Cancelled or failed
+            result = std::move(it->second);
+            results.erase(it);
+        }
+
+        const unsigned int frameNum = firstFrame+offset;
+        const uint64_t writeStart = ofGetElapsedTimeMicros();
+        bool bWritten = false;
+        if(result.isValid){
+            if(writeFunction){
+                bWritten = writeFunction(result.frame);
+            }
+            else {
+                const std::string fileName = getFileName(settings.filePattern, frameNum);
+                bWritten = ofBufferToFile(fileName, result.encoded, true);
+                if(!bWritten){
+                    ofLogError("ofxBlend2DOfflineExporter") << "Couldn't write " << fileName;
+                }
+            }
+        }
+        result = Result(); // Releases the canvas
+        if(!bWritten){
+            ofLogError("ofxBlend2DOfflineExporter") << "Export stopped at frame " << frameNum;
+            fail();
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            writeMicros += ofGetElapsedTimeMicros()-writeStart;
+            numWritten++;
+        }
+        writtenCondition.notify_all();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        endTime = ofGetElapsedTimeMicros();
+        results.clear();
+    }
+    if(numWritten==numFrames){
+        ofLogNotice("ofxBlend2DOfflineExporter") << "Exported " << numFrames << " frames in " << (endTime-startTime)/1000000.f << " seconds.";
+    }
+    bRunning = false;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "blend2d/blend2d.h"
+#include "ofxBlend2DFrame.h"
+#include "ofImage.h"
+#include "ofFileUtils.h" // ofBuffer
+
+#include <string>
+#include <map>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// Offline animation export
+// - - - -
+// Renders a range of frames concurrently : K frames at once, each on its own context with few (or no) Blend2D worker threads.
+// Small canvases don't split well into Blend2D bands, rendering whole frames in parallel keeps all cores busy instead.
+// Frames are handed to an ordered writer (one thread, strictly increasing frame numbers), which either :
+// - calls your WriteFunction (ex: pipe to a video encoder),
+// - or writes image files from a pattern ("export/frame_#####.png", # runs are replaced by the zero-padded frame number).
+//   Pixels are converted by the render threads and encoded one at a time (FreeImage isn't thread safe), the writer only does the I/O.
+// The draw function is called from several threads at once and must only depend on the frame number (no shared mutable state).
+//
+// Usage :
+//     exporter.setup(settings);
+//     exporter.start(0, 600, [](BLContext& ctx, unsigned int frameNum){ ... });
+//     exporter.wait(); // Or poll isRunning() / getNumWritten()
+
+class ofxBlend2DOfflineExporter {
+    public:
+        typedef std::function<void(BLContext& ctx, unsigned int frameNum)> DrawFunction;
+        typedef std::function<bool(const ofxBlend2DFrame& frame)> WriteFunction; // Return false to abort the export
+
+        struct Settings {
+            int width = 1920;
+            int height = 1080;
+            BLFormat format = BL_FORMAT_PRGB32;
+            unsigned int numConcurrentFrames = 0; // K, 0 = hardware concurrency / threadsPerFrame
+            unsigned int threadsPerFrame = 0; // Blend2D workers per context, 0 = synchronous (rasterized by the frame's thread)
+            unsigned int maxFramesAhead = 0; // Rendered frames waiting for the writer at most, 0 = 2*K
+            std::string filePattern = "export/frame_#####.png"; // Used without a WriteFunction
+            ofImageQualityType quality = OF_IMAGE_QUALITY_BEST;
+            BLRgba32 clearColor = BLRgba32(0u); // Transparent
+        };
+
+        struct Stats {
+            unsigned int numFrames = 0;
+            unsigned int numRendered = 0;
+            unsigned int numWritten = 0;
+            float elapsedSeconds = 0.f;
+            float renderSeconds = 0.f; // Sum over the render threads
+            float writeSeconds = 0.f; // Writer thread
+            float getFps() const { return elapsedSeconds>0.f ? numWritten/elapsedSeconds : 0.f; }
+        };
+
+        ofxBlend2DOfflineExporter() = default;
+        ~ofxBlend2DOfflineExporter();
+
+        void setup(const Settings& settings);
+        const Settings& getSettings() const { return settings; }
+
+        // Exports frames [firstFrame, firstFrame+numFrames), returns immediately
+        bool start(unsigned int firstFrame, unsigned int numFrames, DrawFunction draw, WriteFunction write=nullptr);
+        // Blocks until done, returns false if the export failed or was cancelled
+        bool wait();
+        // Stops after the frames being rendered
+        void cancel();
+
+        bool isRunning() const { return bRunning; }
+        unsigned int getNumWritten() const { return numWritten; }
+        float getProgress() const { return numFrames>0 ? float(numWritten)/numFrames : 0.f; }
+        Stats getStats() const;
+
+        // Pattern to file name, exposed for writers
+        static std::string getFileName(const std::string& pattern, unsigned int frameNum);
+
+    protected:
+        struct Result {
+            ofxBlend2DFrame frame;
+            ofBuffer encoded; // File mode only
+            bool isValid = false;
+        };
+
+        void renderFunction();
+        void writerFunction();
+        void join();
+        void fail();
+
+        Settings settings;
+        DrawFunction drawFunction;
+        WriteFunction writeFunction;
+        ofImageFormat fileFormat = OF_IMAGE_FORMAT_PNG;
+        std::shared_ptr<ofxBlend2DCanvasPool> canvasPool = std::make_shared<ofxBlend2DCanvasPool>();
+
+        std::vector<std::thread> renderThreads;
+        std::thread writerThread;
+        unsigned int firstFrame = 0;
+        unsigned int numFrames = 0;
+        unsigned int maxAhead = 0;
+        std::atomic<unsigned int> nextToRender{0}; // Offset from firstFrame
+        std::atomic<unsigned int> numWritten{0};
+        std::atomic<bool> bRunning{false};
+        std::atomic<bool> bCancelled{false};
+        std::atomic<bool> bFailed{false};
+
+        mutable std::mutex mutex; // Protects results and the timings
+        static std::mutex encodeMutex; // ofSaveImage() calls, shared by all exporters
+        std::condition_variable resultCondition; // A frame was rendered
+        std::condition_variable writtenCondition; // A frame was written (render threads wait when too far ahead)
+        std::map<unsigned int, Result> results; // By offset, waiting for the writer
+        uint64_t startTime = 0;
+        uint64_t endTime = 0;
+        uint64_t renderMicros = 0;
+        uint64_t writeMicros = 0;
+        unsigned int numRendered = 0;
+};
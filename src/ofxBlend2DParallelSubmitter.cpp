@@ -0,0 +1,137 @@
+#include "ofxBlend2DParallelSubmitter.h"
+#include "ofxBlend2DGlue.h"
+#include "ofLog.h"
+
+#include <chrono>
+#include <algorithm>
+
+static float msSince(const std::chrono::steady_clock::time_point& start){
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now()-start).count();
+}
+
+BLResult ofxBlend2DParallelSubmitter::submitRecorded(BLContext& ctx, std::size_t numJobs, const RecordFunction& record){
+    stats = Stats();
+    stats.numJobs = numJobs;
+    if(numJobs==0 || !record) return BL_SUCCESS;
+
+    // Buffers are kept between frames, clear() keeps their capacity
+    if(buffers.size()<numJobs) buffers.resize(numJobs);
+
+    auto startTime = std::chrono::steady_clock::now();
+    pool.run(numJobs, [this, &record](std::size_t job){
+        buffers[job].clear();
+        record(buffers[job], job);
+    }, numThreads);
+    stats.jobsTimeMs = msSince(startTime);
+
+    // Merge in job order
+    startTime = std::chrono::steady_clock::now();
+    BLResult ret = BL_SUCCESS;
+    for(std::size_t job=0; job<numJobs; ++job){
+        stats.numCommands += buffers[job].size();
+        // Replaying is balanced : the buffer's saves can't outlive it and its restores can't pop this save
+        ctx.save();
+        BLResult result = buffers[job].replay(ctx);
+        ctx.restore();
+        if(result!=BL_SUCCESS && ret==BL_SUCCESS) ret = result;
+    }
+    stats.mergeTimeMs = msSince(startTime);
+
+    if(ret!=BL_SUCCESS){
+        ofLogWarning("ofxBlend2DParallelSubmitter::submitRecorded") << "Replaying failed : " << blResultToString(ret);
+    }
+    return ret;
+}
+
+BLResult ofxBlend2DParallelSubmitter::submitLayered(BLContext& ctx, std::size_t numJobs, const DrawFunction& draw, const BoundsFunction& bounds){
+    stats = Stats();
+    stats.numJobs = numJobs;
+    if(numJobs==0 || !draw) return BL_SUCCESS;
+
+    const BLSize targetSize = ctx.target_size();
+    const int width = (int)targetSize.w;
+    const int height = (int)targetSize.h;
+    if(width<=0 || height<=0){
+        ofLogWarning("ofxBlend2DParallelSubmitter::submitLayered") << "The context has no target !";
+        return BL_ERROR_INVALID_STATE;
+    }
+    // Both transforms are replicated : the sub-canvases are in the target's pixel space
+    const BLMatrix2D metaTransform = ctx.meta_transform();
+    const BLMatrix2D transform = ctx.user_transform();
+
+    // Job areas, clipped to the target
+    const BLRectI targetRect(0, 0, width, height);
+    std::vector<BLRectI> areas(numJobs, targetRect);
+    if(bounds){
+        for(std::size_t job=0; job<numJobs; ++job){
+            const BLRectI area = bounds(job);
+            const int x0 = std::max(area.x, 0);
+            const int y0 = std::max(area.y, 0);
+            const int x1 = std::min(area.x+area.w, width);
+            const int y1 = std::min(area.y+area.h, height);
+            areas[job] = BLRectI(x0, y0, std::max(x1-x0, 0), std::max(y1-y0, 0));
+        }
+    }
+
+    // Canvases are kept between frames (reallocated when their area's size changes)
+    if(canvases.size()<numJobs) canvases.resize(numJobs);
+
+    std::vector<BLResult> results(numJobs, BL_SUCCESS);
+    auto startTime = std::chrono::steady_clock::now();
+    pool.run(numJobs, [&](std::size_t job){
+        const BLRectI& area = areas[job];
+        if(area.w<=0 || area.h<=0) return; // Nothing visible
+        BLImage& canvas = canvases[job];
+        if(canvas.width()!=area.w || canvas.height()!=area.h){
+            results[job] = canvas.create(area.w, area.h, BL_FORMAT_PRGB32);
+            if(results[job]!=BL_SUCCESS) return;
+        }
+
+        // Synchronous context : the job's thread rasterizes
+        BLContext subCtx;
+        results[job] = subCtx.begin(canvas);
+        if(results[job]!=BL_SUCCESS) return;
+        subCtx.clear_all();
+        // Same pixel space as the target, shifted to the canvas' area
+        BLMatrix2D jobMeta = metaTransform;
+        jobMeta.post_translate(-area.x, -area.y);
+        subCtx.set_transform(jobMeta);
+        subCtx.user_to_meta();
+        subCtx.set_transform(transform);
+        draw(subCtx, job);
+        results[job] = subCtx.end();
+    }, numThreads);
+    stats.jobsTimeMs = msSince(startTime);
+
+    // Merge in job order
+    startTime = std::chrono::steady_clock::now();
+    BLResult ret = BL_SUCCESS;
+    ctx.save();
+    // Blits in pixel space, undoing the meta transform already applied by the sub-contexts
+    BLMatrix2D inverseMeta = metaTransform;
+    if(inverseMeta.invert()==BL_SUCCESS) ctx.set_transform(inverseMeta);
+    else ctx.reset_transform();
+    ctx.set_comp_op(BL_COMP_OP_SRC_OVER);
+    ctx.set_global_alpha(1.0); // Jobs didn't inherit the context's alpha either
+    for(std::size_t job=0; job<numJobs; ++job){
+        if(results[job]!=BL_SUCCESS){
+            if(ret==BL_SUCCESS) ret = results[job];
+            continue;
+        }
+        if(areas[job].w<=0 || areas[job].h<=0) continue;
+        ctx.blit_image(BLPoint(areas[job].x, areas[job].y), canvases[job]);
+    }
+    ctx.restore();
+    stats.mergeTimeMs = msSince(startTime);
+
+    if(ret!=BL_SUCCESS){
+        ofLogWarning("ofxBlend2DParallelSubmitter::submitLayered") << "A sub-context failed : " << blResultToString(ret);
+    }
+    return ret;
+}
+
+void ofxBlend2DParallelSubmitter::clear(){
+    buffers.clear();
+    canvases.clear();
+    stats = Stats();
+}
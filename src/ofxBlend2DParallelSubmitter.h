@@ -0,0 +1,60 @@
+#pragma once
+
+#include "blend2d/blend2d.h"
+#include "ofxBlend2DCommandBuffer.h"
+#include "ofxBlend2DWorkerPool.h"
+
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+// Parallel command submission
+// - - - -
+// Blend2D rasterizes on its worker threads, but all draw calls are submitted from a single thread.
+// With many small shapes, generating the geometry and submitting it becomes the bottleneck.
+// This splits a frame into jobs (ex: bands of rows) which run on several threads, then merges them into the frame context in job order :
+// - submitRecorded() : each job records into its own ofxBlend2DCommandBuffer, the buffers are then replayed into the context.
+//   Geometry generation scales, the context receives the exact same calls as with single-threaded code.
+//   Every job is replayed with the context's state at submission, state changes don't leak between jobs.
+// - submitLayered() : each job draws into its own sub-context (a transparent canvas, rasterized on the job's thread),
+//   the canvases are then blitted (SRC_OVER) into the context. Rasterization scales too, at the cost of one canvas per job.
+//   Canvases cover the target, or only the job's bounds when a BoundsFunction is given (drawing outside of them is clipped).
+//   Sub-contexts start with the context's transforms only : other state (styles, comp op, global alpha, clip...) is Blend2D's default.
+//   The blit uses SRC_OVER at full opacity, clipped by the context's clip.
+//   Source-over is associative, so the result is the same as drawing the jobs in order, as long as jobs only use SRC_OVER themselves.
+// Jobs run on a persistent ofxBlend2DWorkerPool.
+//
+// Usage (between begin() and end()) :
+//     submitter.submitRecorded(blend2d.getBlContext(), numJobs, [&](ofxBlend2DCommandBuffer& cmd, std::size_t job){ ... });
+
+class ofxBlend2DParallelSubmitter {
+    public:
+        typedef std::function<void(ofxBlend2DCommandBuffer& cmd, std::size_t job)> RecordFunction;
+        typedef std::function<void(BLContext& ctx, std::size_t job)> DrawFunction;
+        typedef std::function<BLRectI(std::size_t job)> BoundsFunction; // Area drawn by a job, in the target's pixels
+
+        struct Stats {
+            std::size_t numJobs = 0;
+            std::size_t numCommands = 0; // Recorded mode only
+            float jobsTimeMs = 0.f; // Wall time of the parallel part
+            float mergeTimeMs = 0.f; // Replaying or blitting, on the calling thread
+        };
+
+        // Returns the first error of the merge
+        BLResult submitRecorded(BLContext& ctx, std::size_t numJobs, const RecordFunction& record);
+        BLResult submitLayered(BLContext& ctx, std::size_t numJobs, const DrawFunction& draw, const BoundsFunction& bounds = nullptr);
+
+        const Stats& getStats() const { return stats; }
+
+        // Releases the buffers and canvases kept between frames
+        void clear();
+
+        // Worker threads (0 = hardware concurrency), the calling thread runs jobs too
+        unsigned int numThreads = 0;
+
+    protected:
+        ofxBlend2DWorkerPool pool;
+        std::vector<ofxBlend2DCommandBuffer> buffers;
+        std::vector<BLImage> canvases;
+        Stats stats;
+};
@@ -0,0 +1,333 @@
+#include "ofxBlend2DPathCache.h"
+#include "ofxBlend2DGlue.h"
+#include "ofLog.h"
+#include "ofFileUtils.h" // ofToDataPath
+
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace ofxBlend2DPathCacheFormat;
+
+namespace {
+    uint64_t alignUp(uint64_t v){
+        return (v+alignment-1) & ~(alignment-1);
+    }
+
+    void hashBytes(uint64_t& hash, const void* bytes, std::size_t size){
+        const uint8_t* p = static_cast<const uint8_t*>(bytes);
+        for(std::size_t i=0; i<size; ++i){
+            hash ^= p[i];
+            hash *= 1099511628211ull;
+        }
+    }
+
+    uint64_t computeChecksum(const Header& header, const Entry* entries){
+        Header h = header;
+        h.checksum = 0;
+        uint64_t hash = 14695981039346656037ull;
+        hashBytes(hash, &h, sizeof(Header));
+        hashBytes(hash, entries, sizeof(Entry)*header.numPaths);
+        return hash;
+    }
+
+    void colorToArray(const ofFloatColor& c, float (&out)[4]){
+        out[0] = c.r; out[1] = c.g; out[2] = c.b; out[3] = c.a;
+    }
+}
+
+//--------------------------------------------------------------
+// Writer
+void ofxBlend2DPathCacheWriter::add(const BLPath& path, const ofxBlend2DPathStyle& style){
+    const BLPathView view = path.view();
+
+    Entry entry;
+    std::memset(&entry, 0, sizeof(Entry)); // Deterministic padding, it's hashed
+    entry.vertexStart = vertices.size();
+    entry.vertexCount = view.size;
+
+    BLBox bbox(0, 0, 0, 0);
+    if(view.size>0) path.get_bounding_box(&bbox);
+    entry.bounds[0] = bbox.x0; entry.bounds[1] = bbox.y0;
+    entry.bounds[2] = bbox.x1; entry.bounds[3] = bbox.y1;
+
+    colorToArray(style.fillColor, entry.style.fillColor);
+    colorToArray(style.strokeColor, entry.style.strokeColor);
+    entry.style.strokeWidth = style.strokeWidth;
+    entry.style.miterLimit = style.miterLimit;
+    entry.style.opacity = style.opacity;
+    entry.style.isVisible = style.isVisible;
+    entry.style.isFilled = style.isFilled;
+    entry.style.hasStroke = style.hasStroke;
+    entry.style.fillRule = style.fillRule;
+    entry.style.strokeJoin = style.strokeJoin;
+    entry.style.strokeCap = style.strokeCap;
+    entry.style.compOp = style.compOp;
+    entries.push_back(entry);
+
+    vertices.insert(vertices.end(), view.vertex_data, view.vertex_data+view.size);
+    commands.insert(commands.end(), view.command_data, view.command_data+view.size);
+}
+
+void ofxBlend2DPathCacheWriter::reserve(std::size_t numPaths, std::size_t numVertices){
+    entries.reserve(numPaths);
+    vertices.reserve(numVertices);
+    commands.reserve(numVertices);
+}
+
+void ofxBlend2DPathCacheWriter::clear(){
+    entries.clear();
+    vertices.clear();
+    commands.clear();
+}
+
+bool ofxBlend2DPathCacheWriter::save(const std::string& filePath) const {
+    Header header;
+    std::memset(&header, 0, sizeof(Header));
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.endianCheck = endianCheck;
+    header.headerSize = sizeof(Header);
+    header.entrySize = sizeof(Entry);
+    header.pointSize = sizeof(BLPoint);
+    header.numPaths = entries.size();
+    header.numVertices = vertices.size();
+    header.indexOffset = alignUp(sizeof(Header));
+    header.vertexOffset = alignUp(header.indexOffset + sizeof(Entry)*entries.size());
+    header.commandOffset = alignUp(header.vertexOffset + sizeof(BLPoint)*vertices.size());
+    header.fileSize = alignUp(header.commandOffset + commands.size());
+    header.checksum = computeChecksum(header, entries.data());
+
+    std::ofstream file(ofToDataPath(filePath), std::ios::binary | std::ios::trunc);
+    if(!file){
+        ofLogError("ofxBlend2DPathCacheWriter::save") << "Couldn't open " << filePath << " for writing !";
+        return false;
+    }
+
+    static const char padding[alignment] = {0};
+    auto writeSection = [&file](uint64_t offset, const void* sectionData, std::size_t size){
+        const uint64_t pos = (uint64_t)file.tellp();
+        if(offset>pos) file.write(padding, offset-pos);
+        if(size>0) file.write(static_cast<const char*>(sectionData), size);
+    };
+    writeSection(0, &header, sizeof(Header));
+    writeSection(header.indexOffset, entries.data(), sizeof(Entry)*entries.size());
+    writeSection(header.vertexOffset, vertices.data(), sizeof(BLPoint)*vertices.size());
+    writeSection(header.commandOffset, commands.data(), commands.size());
+    writeSection(header.fileSize, nullptr, 0);
+
+    if(!file.good()){
+        ofLogError("ofxBlend2DPathCacheWriter::save") << "Failed writing " << filePath << " !";
+        return false;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+// Reader
+ofxBlend2DPathCache::~ofxBlend2DPathCache(){
+    close();
+}
+
+ofxBlend2DPathCache::ofxBlend2DPathCache(ofxBlend2DPathCache&& other) noexcept {
+    *this = std::move(other);
+}
+
+ofxBlend2DPathCache& ofxBlend2DPathCache::operator=(ofxBlend2DPathCache&& other) noexcept {
+    if(this==&other) return *this;
+    close();
+    std::swap(data, other.data);
+    std::swap(mappedSize, other.mappedSize);
+    std::swap(header, other.header);
+    std::swap(entries, other.entries);
+    std::swap(vertices, other.vertices);
+    std::swap(commands, other.commands);
+#ifdef _WIN32
+    std::swap(fileHandle, other.fileHandle);
+    std::swap(mappingHandle, other.mappingHandle);
+#endif
+    return *this;
+}
+
+bool ofxBlend2DPathCache::open(const std::string& filePath, bool verifyCommands){
+    close();
+    const std::string fullPath = ofToDataPath(filePath, true);
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(fullPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file==INVALID_HANDLE_VALUE){
+        ofLogError("ofxBlend2DPathCache::open") << "Couldn't open " << fullPath << " !";
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart<(LONGLONG)sizeof(Header)){
+        ofLogError("ofxBlend2DPathCache::open") << fullPath << " is too small to be a path cache !";
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* mapped = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if(mapped==nullptr){
+        ofLogError("ofxBlend2DPathCache::open") << "Couldn't map " << fullPath << " !";
+        if(mapping) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    mappedSize = (std::size_t)fileSize.QuadPart;
+#else
+    const int fd = ::open(fullPath.c_str(), O_RDONLY);
+    if(fd<0){
+        ofLogError("ofxBlend2DPathCache::open") << "Couldn't open " << fullPath << " !";
+        return false;
+    }
+    struct stat fileStat;
+    if(fstat(fd, &fileStat)!=0 || fileStat.st_size<(off_t)sizeof(Header)){
+        ofLogError("ofxBlend2DPathCache::open") << fullPath << " is too small to be a path cache !";
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps its own reference
+    if(mapped==MAP_FAILED){
+        ofLogError("ofxBlend2DPathCache::open") << "Couldn't map " << fullPath << " !";
+        return false;
+    }
+    mappedSize = fileStat.st_size;
+#endif
+
+    data = static_cast<const uint8_t*>(mapped);
+    header = reinterpret_cast<const Header*>(data);
+    if(!validate(verifyCommands)){
+        ofLogError("ofxBlend2DPathCache::open") << fullPath << " is not a valid path cache (or was written by an incompatible version), please regenerate it.";
+        close();
+        return false;
+    }
+    entries = reinterpret_cast<const Entry*>(data + header->indexOffset);
+    vertices = reinterpret_cast<const BLPoint*>(data + header->vertexOffset);
+    commands = data + header->commandOffset;
+    return true;
+}
+
+bool ofxBlend2DPathCache::validate(bool verifyCommands) const {
+    // Header
+    if(std::memcmp(header->magic, magic, sizeof(magic))!=0) return false;
+    if(header->version!=version || header->endianCheck!=endianCheck) return false;
+    if(header->headerSize!=sizeof(Header) || header->entrySize!=sizeof(Entry) || header->pointSize!=sizeof(BLPoint)) return false;
+    if(header->fileSize>mappedSize) return false;
+
+    // Sections : aligned, ordered, in bounds.
+    // Each offset is checked against the file size first, then the count against the space left : no sum can wrap.
+    const uint64_t fileSize = header->fileSize;
+    if(header->indexOffset%alignment || header->vertexOffset%alignment || header->commandOffset%alignment) return false;
+    if(header->indexOffset<sizeof(Header) || header->indexOffset>fileSize) return false;
+    if(header->numPaths > (fileSize-header->indexOffset)/sizeof(Entry)) return false;
+    if(header->vertexOffset < header->indexOffset + header->numPaths*sizeof(Entry) || header->vertexOffset>fileSize) return false;
+    if(header->numVertices > (fileSize-header->vertexOffset)/sizeof(BLPoint)) return false;
+    if(header->commandOffset < header->vertexOffset + header->numVertices*sizeof(BLPoint) || header->commandOffset>fileSize) return false;
+    if(header->numVertices > fileSize-header->commandOffset) return false;
+
+    // Index
+    const Entry* index = reinterpret_cast<const Entry*>(data + header->indexOffset);
+    if(computeChecksum(*header, index)!=header->checksum) return false;
+    for(uint64_t i=0; i<header->numPaths; ++i){
+        if(index[i].vertexStart>header->numVertices || index[i].vertexCount>header->numVertices-index[i].vertexStart) return false;
+        const Style& style = index[i].style;
+        if(style.fillRule>BL_FILL_RULE_MAX_VALUE || style.compOp>BL_COMP_OP_MAX_VALUE) return false;
+        // Blend2D's MAX_VALUEs are the last valid ones
+        if(style.strokeJoin>BL_STROKE_JOIN_MAX_VALUE || style.strokeCap>BL_STROKE_CAP_MAX_VALUE) return false;
+    }
+
+    // Commands
+    if(verifyCommands){
+        const uint8_t* cmds = data + header->commandOffset;
+        for(uint64_t i=0; i<header->numVertices; ++i){
+            if(cmds[i]>BL_PATH_CMD_MAX_VALUE) return false;
+        }
+    }
+    return true;
+}
+
+void ofxBlend2DPathCache::close(){
+    if(data!=nullptr){
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+        if(mappingHandle) CloseHandle((HANDLE)mappingHandle);
+        if(fileHandle) CloseHandle((HANDLE)fileHandle);
+        mappingHandle = nullptr;
+        fileHandle = nullptr;
+#else
+        munmap(const_cast<uint8_t*>(data), mappedSize);
+#endif
+    }
+    data = nullptr;
+    mappedSize = 0;
+    header = nullptr;
+    entries = nullptr;
+    vertices = nullptr;
+    commands = nullptr;
+}
+
+BLPathView ofxBlend2DPathCache::getPathView(std::size_t index) const {
+    const Entry& entry = entries[index];
+    BLPathView view;
+    view.command_data = commands + entry.vertexStart;
+    view.vertex_data = vertices + entry.vertexStart;
+    view.size = entry.vertexCount;
+    return view;
+}
+
+BLBox ofxBlend2DPathCache::getBounds(std::size_t index) const {
+    const double* b = entries[index].bounds;
+    return BLBox(b[0], b[1], b[2], b[3]);
+}
+
+ofxBlend2DPathStyle ofxBlend2DPathCache::getStyle(std::size_t index) const {
+    const Style& s = entries[index].style;
+    ofxBlend2DPathStyle ret;
+    ret.isVisible = s.isVisible;
+    ret.isFilled = s.isFilled;
+    ret.fillColor = ofFloatColor(s.fillColor[0], s.fillColor[1], s.fillColor[2], s.fillColor[3]);
+    ret.fillRule = (BLFillRule)s.fillRule;
+    ret.hasStroke = s.hasStroke;
+    ret.strokeWidth = s.strokeWidth;
+    ret.strokeColor = ofFloatColor(s.strokeColor[0], s.strokeColor[1], s.strokeColor[2], s.strokeColor[3]);
+    ret.strokeJoin = (BLStrokeJoin)s.strokeJoin;
+    ret.strokeCap = (BLStrokeCap)s.strokeCap;
+    ret.miterLimit = s.miterLimit;
+    ret.opacity = s.opacity;
+    ret.compOp = (BLCompOp)s.compOp;
+    return ret;
+}
+
+BLResult ofxBlend2DPathCache::getPath(std::size_t index, BLPath& out) const {
+    const BLPathView view = getPathView(index);
+    uint8_t* cmdOut = nullptr;
+    BLPoint* vtxOut = nullptr;
+    BLResult result = out.modify_op(BL_MODIFY_OP_ASSIGN_FIT, view.size, &cmdOut, &vtxOut);
+    if(result!=BL_SUCCESS){
+        ofLogError("ofxBlend2DPathCache::getPath") << "Couldn't allocate path : " << blResultToString(result);
+        return result;
+    }
+    if(view.size>0){
+        std::memcpy(cmdOut, view.command_data, view.size);
+        std::memcpy(vtxOut, view.vertex_data, view.size*sizeof(BLPoint));
+    }
+    return BL_SUCCESS;
+}
+
+BLPath ofxBlend2DPathCache::getPath(std::size_t index) const {
+    BLPath ret;
+    getPath(index, ret);
+    return ret;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "blend2d/blend2d.h"
+#include "ofxBlend2DPathStyle.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Binary path cache
+// - - - -
+// An on-disk format for collections of BLPath + style + bounding box, designed to be memory-mapped instead of parsed.
+// Converted vector assets can be saved once (ofxBlend2DPathCacheWriter), then a cold start is an mmap and some page faults.
+//
+// Layout (native endianness, every section 16-byte aligned) :
+// - Header : magic, version, endianness + BLPoint size checks, section offsets, checksum
+// - Index  : one Entry per path (vertex range, bounding box, style)
+// - Vertices : BLPoint[numVertices], all paths contiguous
+// - Commands : uint8_t[numVertices], same order
+// Opening validates the header and the index (O(numPaths)), vertex data is only touched when used.
+//
+// Note: BLPath can't reference external memory, so getPathView() is the zero-copy access.
+// getPath() is a single memcpy of the range into a BLPath (no parsing), which is what drawing needs.
+
+namespace ofxBlend2DPathCacheFormat {
+    constexpr char magic[8] = {'B','L','2','D','P','A','T','H'};
+    constexpr uint32_t version = 1;
+    constexpr uint32_t endianCheck = 0x01020304u;
+    constexpr uint64_t alignment = 16;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t endianCheck;
+        uint32_t headerSize;
+        uint32_t entrySize;
+        uint32_t pointSize;
+        uint32_t reserved;
+        uint64_t numPaths;
+        uint64_t numVertices;
+        uint64_t indexOffset;
+        uint64_t vertexOffset;
+        uint64_t commandOffset;
+        uint64_t fileSize;
+        uint64_t checksum; // FNV-1a of the header (with checksum=0) and the index
+        uint64_t reserved2;
+    };
+
+    // Style, stored with fixed-size types
+    struct Style {
+        float fillColor[4];
+        float strokeColor[4];
+        float strokeWidth;
+        float miterLimit;
+        float opacity;
+        uint8_t isVisible;
+        uint8_t isFilled;
+        uint8_t hasStroke;
+        uint8_t fillRule;
+        uint8_t strokeJoin;
+        uint8_t strokeCap;
+        uint8_t compOp;
+        uint8_t reserved;
+    };
+
+    struct Entry {
+        uint64_t vertexStart;
+        uint64_t vertexCount;
+        double bounds[4]; // x0, y0, x1, y1
+        Style style;
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(Header)%alignment==0, "Header must keep sections aligned");
+    static_assert(sizeof(Entry)%8==0, "Entries must keep doubles aligned");
+}
+
+class ofxBlend2DPathCacheWriter {
+    public:
+        void add(const BLPath& path, const ofxBlend2DPathStyle& style=ofxBlend2DPathStyle());
+        void reserve(std::size_t numPaths, std::size_t numVertices);
+        void clear();
+        std::size_t size() const { return entries.size(); }
+
+        // Writes the cache file (relative to the data folder). Returns false on IO errors.
+        bool save(const std::string& filePath) const;
+
+    protected:
+        std::vector<ofxBlend2DPathCacheFormat::Entry> entries;
+        std::vector<BLPoint> vertices;
+        std::vector<uint8_t> commands;
+};
+
+class ofxBlend2DPathCache {
+    public:
+        ofxBlend2DPathCache() = default;
+        ~ofxBlend2DPathCache();
+        ofxBlend2DPathCache(const ofxBlend2DPathCache&) = delete;
+        ofxBlend2DPathCache& operator=(const ofxBlend2DPathCache&) = delete;
+        ofxBlend2DPathCache(ofxBlend2DPathCache&& other) noexcept;
+        ofxBlend2DPathCache& operator=(ofxBlend2DPathCache&& other) noexcept;
+
+        // Maps the file (relative to the data folder) read-only.
+        // With verifyCommands, all command bytes are checked too (touches that whole section).
+        bool open(const std::string& filePath, bool verifyCommands=false);
+        void close();
+        bool isOpen() const { return header!=nullptr; }
+
+        std::size_t size() const { return header ? header->numPaths : 0; }
+        std::size_t getNumVertices() const { return header ? header->numVertices : 0; }
+        std::size_t getMappedSize() const { return mappedSize; }
+
+        // Zero-copy access into the mapping, valid while the cache is open
+        BLPathView getPathView(std::size_t index) const;
+        BLBox getBounds(std::size_t index) const;
+        ofxBlend2DPathStyle getStyle(std::size_t index) const;
+
+        // Copies the path data into out (replaces its content)
+        BLResult getPath(std::size_t index, BLPath& out) const;
+        BLPath getPath(std::size_t index) const;
+
+    protected:
+        bool validate(bool verifyCommands) const;
+
+        const uint8_t* data = nullptr;
+        std::size_t mappedSize = 0;
+        const ofxBlend2DPathCacheFormat::Header* header = nullptr;
+        const ofxBlend2DPathCacheFormat::Entry* entries = nullptr;
+        const BLPoint* vertices = nullptr;
+        const uint8_t* commands = nullptr;
+#ifdef _WIN32
+        void* fileHandle = nullptr;
+        void* mappingHandle = nullptr;
+#endif
+};
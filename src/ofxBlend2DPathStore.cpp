@@ -0,0 +1,183 @@
+#include "ofxBlend2DPathStore.h"
+#include "ofxBlend2DGlue.h"
+#include "ofLog.h"
+
+#include <cmath>
+#include <algorithm>
+
+ofxBlend2DPathStore::ofxBlend2DPathStore(double _tolerance) : tolerance(_tolerance) {
+    // Also catches NaN
+    if(!(tolerance>=MinTolerance)){
+        ofLogWarning("ofxBlend2DPathStore") << "Tolerance " << _tolerance << " is too small, using " << MinTolerance << ".";
+        tolerance = MinTolerance;
+    }
+}
+
+// Close commands have NaN vertices, they don't count
+static bool hasFiniteVertices(const BLPathView& view){
+    for(std::size_t i=0; i<view.size; ++i){
+        if(view.command_data[i]==BL_PATH_CMD_CLOSE) continue;
+        if(!std::isfinite(view.vertex_data[i].x) || !std::isfinite(view.vertex_data[i].y)) return false;
+    }
+    return true;
+}
+
+// Grid cell of a coordinate. Coordinates too large for the grid share one cell, isSameGeometry() still compares them.
+static uint64_t getCell(double value, double tolerance){
+    const double cell = std::round(value/tolerance);
+    if(!(std::abs(cell)<9.0e18)) return 0x7FF0000000000000ull;
+    return uint64_t(int64_t(cell));
+}
+
+void ofxBlend2DPathStore::clear(){
+    shapes.clear();
+    instances.clear();
+    shapesByHash.clear();
+    bytesSaved = 0;
+}
+
+void ofxBlend2DPathStore::reserve(std::size_t numInstances){
+    instances.reserve(numInstances);
+    shapesByHash.reserve(numInstances);
+}
+
+std::size_t ofxBlend2DPathStore::add(const ofPath& path, const BLMatrix2D& transform){
+    return add(toBLPath(path), transform);
+}
+
+std::size_t ofxBlend2DPathStore::add(const BLPath& path, const BLMatrix2D& transform){
+    // NaN or infinite coordinates would hash randomly and compare as equal to anything
+    if(!hasFiniteVertices(path.view())){
+        ofLogWarning("ofxBlend2DPathStore::add") << "The path has non-finite coordinates, it's stored without deduplication.";
+        return addUnique(path, transform);
+    }
+
+    // Canonicalize : move the bounding box to the origin
+    BLPoint origin(0, 0);
+    BLBox bbox;
+    if(!path.is_empty() && path.get_bounding_box(&bbox)==BL_SUCCESS){
+        origin = BLPoint(bbox.x0, bbox.y0);
+    }
+    BLPath canonical(path);
+    if(origin.x!=0 || origin.y!=0){
+        canonical.translate(BLPoint(-origin.x, -origin.y));
+    }
+
+    // The instance maps shape -> origin offset -> user transform
+    Instance instance;
+    instance.transform = transform;
+    instance.transform.translate(origin.x, origin.y);
+
+    // Lookup identical geometry
+    const BLPathView view = canonical.view();
+    const uint64_t hash = hashPath(view);
+    auto range = shapesByHash.equal_range(hash);
+    for(auto it=range.first; it!=range.second; ++it){
+        Shape& shape = shapes[it->second];
+        if(isSameGeometry(shape.path.view(), view)){
+            instance.shapeIndex = it->second;
+            shape.useCount++;
+            bytesSaved += view.size*(sizeof(BLPoint)+sizeof(uint8_t));
+            instances.push_back(instance);
+            return instances.size()-1;
+        }
+    }
+
+    // New shape
+    canonical.shrink();
+    instance.shapeIndex = shapes.size();
+    shapes.push_back({std::move(canonical), 1u});
+    shapesByHash.emplace(hash, instance.shapeIndex);
+    instances.push_back(instance);
+    return instances.size()-1;
+}
+
+std::size_t ofxBlend2DPathStore::addUnique(const BLPath& path, const BLMatrix2D& transform){
+    // Not in shapesByHash : later add() calls won't match it
+    Instance instance;
+    instance.transform = transform;
+    instance.shapeIndex = shapes.size();
+    shapes.push_back({path, 1u});
+    instances.push_back(instance);
+    return instances.size()-1;
+}
+
+uint64_t ofxBlend2DPathStore::hashPath(const BLPathView& view) const {
+    // FNV-1a over commands and tolerance-quantized vertices.
+    // Neighbouring cells aren't probed (2^vertices combinations) : near-equal shapes straddling a cell edge hash differently.
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](uint64_t v){
+        for(int i=0; i<8; ++i){
+            hash ^= (v >> (i*8)) & 0xFFu;
+            hash *= 1099511628211ull;
+        }
+    };
+    mix(view.size);
+    for(std::size_t i=0; i<view.size; ++i){
+        const uint8_t cmd = view.command_data[i];
+        mix(cmd);
+        if(cmd==BL_PATH_CMD_CLOSE) continue; // NaN vertex
+        const BLPoint& p = view.vertex_data[i];
+        mix(getCell(p.x, tolerance));
+        if(cmd!=BL_PATH_CMD_WEIGHT) mix(getCell(p.y, tolerance));
+    }
+    return hash;
+}
+
+bool ofxBlend2DPathStore::isSameGeometry(const BLPathView& a, const BLPathView& b) const {
+    if(a.size != b.size) return false;
+    if(!std::equal(a.command_data, a.command_data+a.size, b.command_data)) return false;
+    for(std::size_t i=0; i<a.size; ++i){
+        const uint8_t cmd = a.command_data[i];
+        if(cmd==BL_PATH_CMD_CLOSE) continue;
+        if(std::abs(a.vertex_data[i].x-b.vertex_data[i].x) > tolerance) return false;
+        if(cmd!=BL_PATH_CMD_WEIGHT && std::abs(a.vertex_data[i].y-b.vertex_data[i].y) > tolerance) return false;
+    }
+    return true;
+}
+
+BLBox ofxBlend2DPathStore::getInstanceBounds(std::size_t instanceIndex) const {
+    const Instance& instance = instances[instanceIndex];
+    BLBox local;
+    if(shapes[instance.shapeIndex].path.get_bounding_box(&local) != BL_SUCCESS){
+        return BLBox(0, 0, 0, 0);
+    }
+    // Transform the 4 corners
+    const BLPoint corners[4] = {
+        instance.transform.map_point(local.x0, local.y0),
+        instance.transform.map_point(local.x1, local.y0),
+        instance.transform.map_point(local.x1, local.y1),
+        instance.transform.map_point(local.x0, local.y1),
+    };
+    BLBox ret(corners[0].x, corners[0].y, corners[0].x, corners[0].y);
+    for(const BLPoint& p : corners){
+        ret.x0 = std::min(ret.x0, p.x); ret.y0 = std::min(ret.y0, p.y);
+        ret.x1 = std::max(ret.x1, p.x); ret.y1 = std::max(ret.y1, p.y);
+    }
+    return ret;
+}
+
+void ofxBlend2DPathStore::fillInstance(BLContext& ctx, std::size_t instanceIndex) const {
+    const Instance& instance = instances[instanceIndex];
+    ctx.save();
+    ctx.apply_transform(instance.transform);
+    ctx.fill_path(shapes[instance.shapeIndex].path);
+    ctx.restore();
+}
+
+void ofxBlend2DPathStore::strokeInstance(BLContext& ctx, std::size_t instanceIndex) const {
+    const Instance& instance = instances[instanceIndex];
+    ctx.save();
+    ctx.apply_transform(instance.transform);
+    ctx.stroke_path(shapes[instance.shapeIndex].path);
+    ctx.restore();
+}
+
+void ofxBlend2DPathStore::drawInstance(BLContext& ctx, std::size_t instanceIndex, const ofxBlend2DPathStyle& style) const {
+    if(!style.isVisible) return;
+    const Instance& instance = instances[instanceIndex];
+    ctx.save();
+    ctx.apply_transform(instance.transform);
+    style.draw(ctx, shapes[instance.shapeIndex].path);
+    ctx.restore();
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "blend2d/blend2d.h"
+#include "ofPath.h"
+#include "ofxBlend2DPathStyle.h"
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// Deduplicating path store
+// - - - -
+// Imported scenes (SVG symbols, hatch tiles, glyph copies) often contain many identical shapes at different positions.
+// Each added path is canonicalized (translated so its bounding box starts at the origin) and hashed.
+// Identical geometry is stored once as a shared BLPath, each addition becomes an instance referencing it with a transform.
+// Geometry is considered identical when commands match and vertices are within `tolerance` (after canonicalization).
+// The match is approximate : candidates are found by hashing vertices rounded to a `tolerance` grid, so two shapes within tolerance
+// whose vertices round to different grid cells (on either side of a cell edge) are stored twice.
+// Copies at the same position always match. Translated copies usually do, but canonicalization rounds their vertices differently,
+// which can push one of them over a cell edge.
+// Paths with non-finite coordinates can't be compared : they are stored as unique shapes.
+
+class ofxBlend2DPathStore {
+    public:
+        struct Instance {
+            std::size_t shapeIndex = 0;
+            BLMatrix2D transform = BLMatrix2D::make_identity(); // Maps shape coordinates to scene coordinates
+        };
+
+        // Tolerances below MinTolerance (or not a number) are clamped
+        explicit ofxBlend2DPathStore(double _tolerance=1e-4);
+        static constexpr double MinTolerance = 1e-9;
+
+        // Adds a path (in scene coordinates, optionally transformed), returns the instance index
+        std::size_t add(const BLPath& path, const BLMatrix2D& transform=BLMatrix2D::make_identity());
+        std::size_t add(const ofPath& path, const BLMatrix2D& transform=BLMatrix2D::make_identity());
+        // Adds a path as its own shape, without canonicalization nor deduplication (nothing is hashed nor compared).
+        // For geometry that is known to be unique or already processed, ex: loaded from an ofxBlend2DPathCache.
+        std::size_t addUnique(const BLPath& path, const BLMatrix2D& transform=BLMatrix2D::make_identity());
+        void clear();
+        void reserve(std::size_t numInstances);
+
+        // Shapes
+        std::size_t getNumShapes() const { return shapes.size(); }
+        const BLPath& getShape(std::size_t shapeIndex) const { return shapes[shapeIndex].path; }
+        // Number of instances referencing a shape
+        std::size_t getShapeUseCount(std::size_t shapeIndex) const { return shapes[shapeIndex].useCount; }
+
+        // Instances
+        std::size_t getNumInstances() const { return instances.size(); }
+        const Instance& getInstance(std::size_t instanceIndex) const { return instances[instanceIndex]; }
+        const std::vector<Instance>& getInstances() const { return instances; }
+        const BLPath& getInstanceShape(std::size_t instanceIndex) const { return getShape(instances[instanceIndex].shapeIndex); }
+        // Scene-space bounding box of an instance
+        BLBox getInstanceBounds(std::size_t instanceIndex) const;
+
+        // Drawing helpers (the context transform is restored afterwards)
+        void fillInstance(BLContext& ctx, std::size_t instanceIndex) const;
+        void strokeInstance(BLContext& ctx, std::size_t instanceIndex) const;
+        template<typename StyleT>
+        void fillInstance(BLContext& ctx, std::size_t instanceIndex, const StyleT& style) const {
+            const Instance& instance = instances[instanceIndex];
+            ctx.save();
+            ctx.apply_transform(instance.transform);
+            ctx.fill_path(shapes[instance.shapeIndex].path, style);
+            ctx.restore();
+        }
+        template<typename StyleT>
+        void strokeInstance(BLContext& ctx, std::size_t instanceIndex, const StyleT& style) const {
+            const Instance& instance = instances[instanceIndex];
+            ctx.save();
+            ctx.apply_transform(instance.transform);
+            ctx.stroke_path(shapes[instance.shapeIndex].path, style);
+            ctx.restore();
+        }
+        // Fill + stroke with a full path style (also restores the style state)
+        void drawInstance(BLContext& ctx, std::size_t instanceIndex, const ofxBlend2DPathStyle& style) const;
+
+        // Stats
+        std::size_t getNumDeduplicated() const { return instances.size()-shapes.size(); }
+        // Bytes of path data that would have been stored without deduplication, minus what is stored
+        std::size_t getMemorySaved() const { return bytesSaved; }
+
+    protected:
+        struct Shape {
+            BLPath path; // Canonical geometry
+            std::size_t useCount = 0;
+        };
+
+        uint64_t hashPath(const BLPathView& view) const;
+        bool isSameGeometry(const BLPathView& a, const BLPathView& b) const;
+
+        double tolerance;
+        std::vector<Shape> shapes;
+        std::vector<Instance> instances;
+        std::unordered_multimap<uint64_t, std::size_t> shapesByHash;
+        std::size_t bytesSaved = 0;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "blend2d/blend2d.h"
+#include "ofxBlend2DGlue.h"
+#include "ofColor.h"
+#include "ofPath.h"
+
+// Rendering style of a path (fill, stroke, compositing)
+// - - - -
+// BLPath only holds geometry, this record holds what ofPath keeps next to it.
+// Colors are ofFloatColor and are converted with toBLColor() when drawing, like the rest of the addon.
+
+struct ofxBlend2DPathStyle {
+    bool isVisible = true;
+
+    // Fill
+    bool isFilled = true;
+    ofFloatColor fillColor = ofFloatColor::black;
+    BLFillRule fillRule = BL_FILL_RULE_NON_ZERO;
+
+    // Stroke
+    bool hasStroke = false;
+    float strokeWidth = 1.f;
+    ofFloatColor strokeColor = ofFloatColor::black;
+    BLStrokeJoin strokeJoin = BL_STROKE_JOIN_MITER_CLIP;
+    BLStrokeCap strokeCap = BL_STROKE_CAP_BUTT;
+    float miterLimit = 4.f;
+
+    // Compositing
+    float opacity = 1.f; // Multiplies fill and stroke alpha
+    BLCompOp compOp = BL_COMP_OP_SRC_OVER;
+
+    bool isStroked() const {
+        return hasStroke && strokeWidth>0.f;
+    }
+
+    static ofxBlend2DPathStyle fromOfPath(ofPath const& _path, bool _isVisible=true){
+        ofxBlend2DPathStyle ret;
+        ret.isVisible = _isVisible;
+        ret.isFilled = _path.isFilled();
+        ret.fillColor = _path.getFillColor();
+        ret.fillRule = (_path.getWindingMode()==OF_POLY_WINDING_ODD) ? BL_FILL_RULE_EVEN_ODD : BL_FILL_RULE_NON_ZERO;
+        ret.strokeWidth = _path.getStrokeWidth();
+        ret.hasStroke = ret.strokeWidth>0.f;
+        ret.strokeColor = _path.getStrokeColor();
+        return ret;
+    }
+
+    // Colors with opacity applied, as submitted to Blend2D
+    BLRgba32 getBLFillColor() const {
+        ofFloatColor c = fillColor;
+        c.a *= opacity;
+        return toBLColor(c);
+    }
+    BLRgba32 getBLStrokeColor() const {
+        ofFloatColor c = strokeColor;
+        c.a *= opacity;
+        return toBLColor(c);
+    }
+
+    // Applies the style to the context then draws the path
+    void fill(BLContext& ctx, const BLPath& path) const {
+        if(!isVisible || !isFilled) return;
+        ctx.set_comp_op(compOp);
+        ctx.set_fill_rule(fillRule);
+        ctx.fill_path(path, getBLFillColor());
+    }
+    void stroke(BLContext& ctx, const BLPath& path) const {
+        if(!isVisible || !isStroked()) return;
+        ctx.set_comp_op(compOp);
+        ctx.set_stroke_width(strokeWidth);
+        ctx.set_stroke_join(strokeJoin);
+        ctx.set_stroke_caps(strokeCap);
+        ctx.set_stroke_miter_limit(miterLimit);
+        ctx.stroke_path(path, getBLStrokeColor());
+    }
+    // Fill then stroke, like SVG and ofPath
+    void draw(BLContext& ctx, const BLPath& path) const {
+        fill(ctx, path);
+        stroke(ctx, path);
+    }
+};
@@ -0,0 +1,186 @@
+#include "ofxBlend2DProgressiveRenderer.h"
+#include "ofxBlend2DGlue.h"
+#include "ofxBlend2DUtils.h"
+#include "ofLog.h"
+
+#include <chrono>
+#include <algorithm>
+
+void ofxBlend2DProgressiveRenderer::allocate(int _width, int _height, BLFormat _format){
+    width = _width;
+    height = _height;
+    format = _format;
+    canvas = BLImage(width, height, format);
+    restart();
+}
+
+std::size_t ofxBlend2DProgressiveRenderer::addItem(DrawFunction draw, float priority){
+    items.emplace_back();
+    Item& item = items.back();
+    item.draw = std::move(draw);
+    item.priority = priority;
+    pending.push_back((uint32_t)(items.size()-1));
+    bNeedsSort = true;
+    stats.numItems = items.size();
+    return items.size()-1;
+}
+
+std::size_t ofxBlend2DProgressiveRenderer::addItem(DrawFunction draw, const BLBox& bounds, float priority){
+    const std::size_t index = addItem(std::move(draw), priority);
+    items[index].bounds = bounds;
+    items[index].hasBounds = true;
+    return index;
+}
+
+std::size_t ofxBlend2DProgressiveRenderer::addPath(const BLPath& path, const ofxBlend2DPathStyle& style, float priority){
+    BLBox bounds;
+    const bool hasBounds = !path.is_empty() && path.get_bounding_box(&bounds)==BL_SUCCESS;
+    const std::size_t index = addItem([path, style](BLContext& ctx){
+        style.draw(ctx, path);
+    }, priority);
+    items[index].bounds = bounds;
+    items[index].hasBounds = hasBounds;
+    return index;
+}
+
+void ofxBlend2DProgressiveRenderer::clear(){
+    items.clear();
+    restart();
+}
+
+void ofxBlend2DProgressiveRenderer::restart(){
+    pending.resize(items.size());
+    for(std::size_t i=0; i<items.size(); ++i){
+        pending[i] = (uint32_t)i;
+    }
+    next = 0;
+    bNeedsSort = true;
+    bNeedsClear = true;
+    stats = Stats();
+    stats.numItems = items.size();
+}
+
+void ofxBlend2DProgressiveRenderer::setTransform(const BLMatrix2D& _transform){
+    if(transform.m00==_transform.m00 && transform.m01==_transform.m01 && transform.m10==_transform.m10 &&
+       transform.m11==_transform.m11 && transform.m20==_transform.m20 && transform.m21==_transform.m21) return;
+    transform = _transform;
+    restart();
+}
+
+void ofxBlend2DProgressiveRenderer::setFocus(const BLPoint& _focus){
+    if(focus.x==_focus.x && focus.y==_focus.y) return;
+    focus = _focus;
+    if(order==CenterFirst) bNeedsSort = true;
+}
+
+void ofxBlend2DProgressiveRenderer::setOrder(Order _order){
+    if(order==_order) return;
+    order = _order;
+    bNeedsSort = true;
+}
+
+double ofxBlend2DProgressiveRenderer::getFocusDistance(const Item& item) const {
+    if(!item.hasBounds) return 0.0; // Unknown location : as if centered
+    const BLPoint center = transform.map_point((item.bounds.x0+item.bounds.x1)*0.5, (item.bounds.y0+item.bounds.y1)*0.5);
+    const double dx = center.x-focus.x;
+    const double dy = center.y-focus.y;
+    return dx*dx+dy*dy;
+}
+
+void ofxBlend2DProgressiveRenderer::sortPending(){
+    bNeedsSort = false;
+    if(order==SubmissionOrder){
+        // Pending indexes are already increasing, except after another order was used
+        std::sort(pending.begin()+next, pending.end());
+        return;
+    }
+    if(order==PriorityOrder){
+        std::stable_sort(pending.begin()+next, pending.end(), [this](uint32_t a, uint32_t b){
+            return items[a].priority < items[b].priority || (items[a].priority==items[b].priority && a<b);
+        });
+        return;
+    }
+
+    // CenterFirst : compute the distances once
+    std::vector<std::pair<double, uint32_t> > keys;
+    keys.reserve(pending.size()-next);
+    for(std::size_t i=next; i<pending.size(); ++i){
+        keys.emplace_back(getFocusDistance(items[pending[i]]), pending[i]);
+    }
+    std::sort(keys.begin(), keys.end(), [this](const std::pair<double, uint32_t>& a, const std::pair<double, uint32_t>& b){
+        const float pa = items[a.second].priority;
+        const float pb = items[b.second].priority;
+        if(pa!=pb) return pa<pb;
+        if(a.first!=b.first) return a.first<b.first;
+        return a.second<b.second;
+    });
+    for(std::size_t i=0; i<keys.size(); ++i){
+        pending[next+i] = keys[i].second;
+    }
+}
+
+bool ofxBlend2DProgressiveRenderer::renderSlice(){
+    stats.numDrawnLastFrame = 0;
+    stats.sliceTimeMs = 0.f;
+    if(canvas.empty()){
+        ofxBlend2D::LogNotAllocated("ofxBlend2DProgressiveRenderer::renderSlice");
+        return false;
+    }
+    if(isConverged() && !bNeedsClear) return true;
+
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point startTime = Clock::now();
+    const Clock::time_point deadline = startTime + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float, std::milli>(timeBudgetMs));
+
+    if(bNeedsSort) sortPending();
+
+    BLContext ctx;
+    BLResult result = ofxBlend2D::BeginCanvasContext(ctx, canvas, threadCount);
+    if(result != BL_SUCCESS){
+        ofLogError("ofxBlend2DProgressiveRenderer::renderSlice") << "Couldn't create the accumulation context : " << blResultToString(result);
+        return false;
+    }
+    if(bNeedsClear){
+        ctx.clear_all();
+        if(clearColor.a()>0) ctx.fill_all(clearColor);
+        bNeedsClear = false;
+    }
+    ctx.set_transform(transform);
+
+    // At least one item per slice, so it always converges
+    const std::size_t checkInterval = threadCount>0 ? std::max<std::size_t>(1, batchSize) : 1;
+    std::size_t numDrawn = 0;
+    while(next<pending.size()){
+        const Item& item = items[pending[next++]];
+        if(item.draw){
+            ctx.save();
+            item.draw(ctx);
+            ctx.restore();
+        }
+        numDrawn++;
+
+        if(numDrawn%checkInterval==0){
+            // Threaded contexts only rasterize on flush, wait for them to measure the real cost
+            if(threadCount>0) ctx.flush(BL_CONTEXT_FLUSH_SYNC);
+            if(Clock::now()>=deadline) break;
+        }
+    }
+    ctx.end();
+
+    stats.numDrawn += numDrawn;
+    stats.numDrawnLastFrame = numDrawn;
+    stats.numSlices++;
+    stats.sliceTimeMs = std::chrono::duration<float, std::milli>(Clock::now()-startTime).count();
+    return isConverged();
+}
+
+bool ofxBlend2DProgressiveRenderer::render(BLContext& ctx){
+    const bool bConverged = renderSlice();
+    if(!canvas.empty()){
+        ctx.save();
+        ctx.set_comp_op(BL_COMP_OP_SRC_OVER);
+        ctx.blit_image(BLPoint(0, 0), canvas);
+        ctx.restore();
+    }
+    return bConverged;
+}
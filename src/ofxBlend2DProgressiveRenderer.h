@@ -0,0 +1,110 @@
+#pragma once
+
+#include "blend2d/blend2d.h"
+#include "ofxBlend2DPathStyle.h"
+
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+// Progressive rendering
+// - - - -
+// Heavy scenes (millions of elements) can take seconds to draw, submitting them in a single frame freezes the output meanwhile.
+// Here, the scene is split into work items which are drawn over several frames into a persistent accumulation canvas :
+// each frame, render() draws pending items for a time budget, then composites the canvas as it is. The output stays interactive
+// and the scene converges over a few frames. Items are processed by priority (ex: coarse levels of detail first),
+// optionally closest to a focus point first (ex: viewport center, mouse).
+// Changing the view (setTransform()) or calling restart() clears the canvas and starts over.
+// Note: reordering changes how overlapping items stack, use priorities for order independent content
+// (points, tiles, detail levels meant to be drawn over coarser ones) or keep SubmissionOrder.
+//
+// Usage (between begin() and end()) :
+//     progressive.allocate(w, h);
+//     for(...) progressive.addPath(path, style, lodLevel);
+//     ...
+//     progressive.render(blend2d.getBlContext()); // Each frame
+//
+// Items must stay valid until they're drawn (they're kept to be redrawn after a restart). Not thread safe.
+
+class ofxBlend2DProgressiveRenderer {
+    public:
+        enum Order : uint8_t {
+            SubmissionOrder = 0,
+            PriorityOrder, // Lowest priority value first, then submission order
+            CenterFirst, // Lowest priority value first, then closest to the focus point
+        };
+
+        typedef std::function<void(BLContext& ctx)> DrawFunction;
+
+        struct Item {
+            DrawFunction draw;
+            BLBox bounds; // In item coordinates, used by CenterFirst
+            bool hasBounds = false;
+            float priority = 0.f;
+        };
+
+        struct Stats {
+            std::size_t numItems = 0;
+            std::size_t numDrawn = 0; // Since the last restart
+            std::size_t numDrawnLastFrame = 0;
+            float sliceTimeMs = 0.f; // Last render() slice
+            unsigned int numSlices = 0; // Frames since the last restart
+            float getProgress() const { return numItems>0 ? float(numDrawn)/numItems : 1.f; }
+        };
+
+        // Sets the accumulation canvas size (restarts)
+        void allocate(int width, int height, BLFormat format=BL_FORMAT_PRGB32);
+
+        // Returns the item index
+        std::size_t addItem(DrawFunction draw, float priority=0.f);
+        std::size_t addItem(DrawFunction draw, const BLBox& bounds, float priority=0.f);
+        // The path is referenced (BLPath is copy on write), bounds are computed from it
+        std::size_t addPath(const BLPath& path, const ofxBlend2DPathStyle& style, float priority=0.f);
+        void clear();
+
+        // Draws pending items into the accumulation canvas for up to timeBudgetMs, then blits it onto ctx.
+        // Returns true once all items are drawn.
+        bool render(BLContext& ctx);
+        // Only the accumulation part, to composite the canvas yourself
+        bool renderSlice();
+
+        // Clears the canvas and queues all items again
+        void restart();
+        // Applied to the items (restarts if it changes)
+        void setTransform(const BLMatrix2D& transform);
+        // In canvas coordinates, reorders the pending items when using CenterFirst
+        void setFocus(const BLPoint& focus);
+        void setOrder(Order order);
+        Order getOrder() const { return order; }
+
+        bool isConverged() const { return next>=pending.size(); }
+        const BLImage& getCanvas() const { return canvas; }
+        const Stats& getStats() const { return stats; }
+        std::size_t size() const { return items.size(); }
+
+        // Time spent drawing items per render() call
+        float timeBudgetMs = 8.f;
+        // Threads of the accumulation context (0 = synchronous). Threaded contexts are flushed every batchSize items to check the time.
+        uint32_t threadCount = 0;
+        std::size_t batchSize = 256;
+        BLRgba32 clearColor = BLRgba32(0u); // Canvas background after a restart (transparent)
+
+    protected:
+        void sortPending();
+        double getFocusDistance(const Item& item) const;
+
+        std::vector<Item> items;
+        std::vector<uint32_t> pending; // Item indexes, in drawing order from `next`
+        std::size_t next = 0;
+        bool bNeedsSort = false;
+        bool bNeedsClear = true;
+
+        BLImage canvas;
+        int width = 0;
+        int height = 0;
+        BLFormat format = BL_FORMAT_PRGB32;
+        BLMatrix2D transform = BLMatrix2D::make_identity();
+        BLPoint focus = BLPoint(0, 0);
+        Order order = PriorityOrder;
+        Stats stats;
+};
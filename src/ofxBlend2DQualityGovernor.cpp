@@ -0,0 +1,170 @@
+#include "ofxBlend2DQualityGovernor.h"
+
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+
+// Blend2D's default flatten tolerance
+static const double defaultFlattenTolerance = 0.2;
+
+ofxBlend2DQualityGovernor::ofxBlend2DQualityGovernor(){
+    buildLevels();
+}
+
+void ofxBlend2DQualityGovernor::setSettings(const Settings& _settings){
+    std::lock_guard<std::mutex> lock(mutex);
+    settings = _settings;
+    settings.windowSize = std::max(1u, settings.windowSize);
+    settings.minRenderScale = std::min(1.f, std::max(.1f, settings.minRenderScale));
+    buildLevels();
+    level = std::min<unsigned int>(level, levels.size()-1);
+    window.clear();
+    numCalmWindows = 0;
+}
+
+ofxBlend2DQualityGovernor::Settings ofxBlend2DQualityGovernor::getSettings() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return settings;
+}
+
+// Each level degrades one more knob than the previous one
+void ofxBlend2DQualityGovernor::buildLevels(){
+    levels.assign(1, State());
+    State state;
+    auto addLevel = [this, &state](){
+        state.level = levels.size();
+        levels.push_back(state);
+    };
+
+    // No visual cost
+    if(settings.maxThreads>0){
+        state.threadCount = settings.maxThreads;
+        addLevel();
+    }
+    // Banding on gradients, blocky scaled patterns
+    if(settings.bAllowNearestStyles){
+        state.bNearestStyles = true;
+        addLevel();
+    }
+    // Visible on large curves, in two steps
+    if(settings.maxFlattenTolerance>defaultFlattenTolerance || settings.maxSimplifyTolerance>0.0){
+        state.flattenTolerance = std::max(defaultFlattenTolerance, (defaultFlattenTolerance+settings.maxFlattenTolerance)*.5);
+        state.simplifyTolerance = settings.maxSimplifyTolerance*.5;
+        addLevel();
+        state.flattenTolerance = std::max(defaultFlattenTolerance, settings.maxFlattenTolerance);
+        state.simplifyTolerance = settings.maxSimplifyTolerance;
+        addLevel();
+    }
+    // Blurry, last resort
+    for(float scale=.75f; scale>settings.minRenderScale+.01f; scale-=.25f){
+        state.renderScale = scale;
+        addLevel();
+    }
+    if(settings.minRenderScale<1.f){
+        state.renderScale = settings.minRenderScale;
+        addLevel();
+    }
+}
+
+void ofxBlend2DQualityGovernor::addFrame(const ofxBlend2DFrameTimings& timings){
+    if(!bEnabled || timings.get(ofxBlend2DFrameTimings::SubmitBegin)==0 || timings.get(ofxBlend2DFrameTimings::FlushBegin)==0) return;
+    const float renderMs = timings.getRenderDuration()/1000.f;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    window.push_back(renderMs);
+    if(window.size()>=settings.windowSize){
+        decide(false);
+    }
+    // A spike doesn't wait for the whole window
+    else if(renderMs>settings.targetMs*settings.spikeRatio && window.size()*4>=settings.windowSize){
+        decide(true);
+    }
+}
+
+void ofxBlend2DQualityGovernor::decide(bool bEarly){
+    std::vector<float> sorted = window;
+    std::sort(sorted.begin(), sorted.end());
+    lastWindowMs = sorted[std::min(sorted.size()-1, sorted.size()*95/100)];
+    window.clear();
+
+    if(bEarly || lastWindowMs>settings.targetMs){
+        numCalmWindows = 0;
+        if(level+1<levels.size()){
+            level++;
+            numDegrades++;
+        }
+    }
+    else if(lastWindowMs<settings.targetMs*settings.restoreRatio){
+        if(++numCalmWindows>=settings.restoreWindows && level>0){
+            level--;
+            numRestores++;
+            numCalmWindows = 0;
+        }
+    }
+    else {
+        // Within budget, without enough headroom to restore
+        numCalmWindows = 0;
+    }
+}
+
+void ofxBlend2DQualityGovernor::reset(){
+    std::lock_guard<std::mutex> lock(mutex);
+    level = 0;
+    window.clear();
+    numCalmWindows = 0;
+}
+
+ofxBlend2DQualityGovernor::State ofxBlend2DQualityGovernor::getState() const {
+    if(!bEnabled) return State();
+    std::lock_guard<std::mutex> lock(mutex);
+    return levels[level];
+}
+
+unsigned int ofxBlend2DQualityGovernor::getNumLevels() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return levels.size();
+}
+
+float ofxBlend2DQualityGovernor::getLastWindowMs() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lastWindowMs;
+}
+
+unsigned int ofxBlend2DQualityGovernor::getNumDegrades() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return numDegrades;
+}
+
+unsigned int ofxBlend2DQualityGovernor::getNumRestores() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return numRestores;
+}
+
+void ofxBlend2DQualityGovernor::apply(BLContext& ctx, const State& state){
+    if(state.bNearestStyles){
+        ctx.set_gradient_quality(BL_GRADIENT_QUALITY_NEAREST);
+        ctx.set_pattern_quality(BL_PATTERN_QUALITY_NEAREST);
+    }
+    if(state.flattenTolerance>0.0){
+        ctx.set_flatten_tolerance(state.flattenTolerance);
+    }
+    if(state.renderScale<1.f){
+        // Part of the meta transform, so draw code resetting its transform keeps it
+        ctx.scale(state.renderScale);
+        ctx.user_to_meta();
+    }
+}
+
+std::string ofxBlend2DQualityGovernor::getDescription(const State& state){
+    if(state.level==0) return "full quality";
+    std::ostringstream description;
+    description << std::fixed << std::setprecision(2);
+    if(state.threadCount>=0) description << "threads=" << state.threadCount << " ";
+    if(state.bNearestStyles) description << "styles=nearest ";
+    if(state.flattenTolerance>0.0) description << "flatten=" << state.flattenTolerance << " ";
+    if(state.simplifyTolerance>0.0) description << "simplify=" << state.simplifyTolerance << " ";
+    if(state.renderScale<1.f) description << "scale=" << state.renderScale;
+    std::string ret = description.str();
+    if(!ret.empty() && ret.back()==' ') ret.pop_back();
+    return ret;
+}
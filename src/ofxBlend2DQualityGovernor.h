@@ -0,0 +1,90 @@
+#pragma once
+
+#include "blend2d/blend2d.h"
+#include "ofxBlend2DFrameProfiler.h"
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+// Quality governor
+// - - - -
+// Keeps the frame rate stable when the scene load spikes, instead of falling behind (begin() returning false).
+// Watches the render time (submit + flush : synchronous contexts rasterize while submitting) of the received frames against a budget and steps through quality levels,
+// cheapest visual cost first, within the bounds of getSettings() :
+//   more threads, nearest gradient and pattern quality, coarser curve flattening (and stroke simplification), lower render resolution.
+// Levels are decided per window of frames (p95 of their render times), and only restored after a few calm windows to avoid oscillating.
+//
+// ofxBlend2DThreadedRenderer owns one (getQualityGovernor(), disabled by default) : it feeds the frames and applies the state in begin().
+// Draw code setting the same context options after begin() overrides the governor.
+// With a render scale below 1, the canvas (and texture) is smaller and begin() scales the context :
+// draw in full size coordinates and draw the texture at getSize(), ex: getTexture().draw(0, 0, getSize().x, getSize().y).
+// Thread safe : frames are added by update(), the state can be read by the producer thread.
+
+class ofxBlend2DQualityGovernor {
+    public:
+        // Bounds and behaviour
+        struct Settings {
+            float targetMs = 16.f; // Render time budget per frame
+            float restoreRatio = .6f; // Quality comes back when the p95 stays below targetMs*restoreRatio
+            float spikeRatio = 2.f; // A frame above targetMs*spikeRatio decides early (needs a quarter window)
+            unsigned int windowSize = 20; // Frames per decision
+            unsigned int restoreWindows = 3; // Consecutive calm windows before restoring a level
+            unsigned int maxThreads = 0; // Thread count when degraded, 0 = leaves the thread count alone
+            bool bAllowNearestStyles = true; // Nearest gradient and pattern quality
+            double maxFlattenTolerance = 1.0; // Blend2D's default is 0.2
+            double maxSimplifyTolerance = 1.0; // Not applied to the context, see State::simplifyTolerance
+            float minRenderScale = 1.f; // Below 1, lowers the resolution as a last resort
+        };
+
+        // What begin() applies, defaults = unchanged
+        struct State {
+            unsigned int level = 0; // 0 = full quality
+            int threadCount = -1; // -1 = unchanged
+            bool bNearestStyles = false;
+            double flattenTolerance = 0.0; // 0 = unchanged
+            double simplifyTolerance = 0.0; // For draw code simplifying its own strokes (ex: ofPolyline::simplify()), 0 = full detail
+            float renderScale = 1.f;
+        };
+
+        ofxBlend2DQualityGovernor();
+
+        // Rebuilds the levels, keeps the current one when possible
+        void setSettings(const Settings& settings);
+        Settings getSettings() const;
+
+        // Feeds a received frame (frames without submit or flush stamps are ignored)
+        void addFrame(const ofxBlend2DFrameTimings& timings);
+        // Back to full quality
+        void reset();
+
+        // Level 0 when disabled
+        State getState() const;
+        unsigned int getNumLevels() const;
+        float getLastWindowMs() const; // p95 render time of the last decision window
+        unsigned int getNumDegrades() const;
+        unsigned int getNumRestores() const;
+
+        // Sets up a context (right after BLContext::begin() and clearing it)
+        static void apply(BLContext& ctx, const State& state);
+        // Ex: "threads=8 styles=nearest flatten=0.60 scale=0.75"
+        static std::string getDescription(const State& state);
+
+        std::atomic<bool> bEnabled{false}; // Read by the submitting and GL threads
+
+    protected:
+        void buildLevels();
+        void decide(bool bEarly);
+
+        mutable std::mutex mutex;
+        Settings settings;
+        std::vector<State> levels;
+        unsigned int level = 0;
+        std::vector<float> window; // Render times (ms) of the current window
+        unsigned int numCalmWindows = 0;
+        float lastWindowMs = 0.f;
+        unsigned int numDegrades = 0;
+        unsigned int numRestores = 0;
+};
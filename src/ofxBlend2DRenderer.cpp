@@ -0,0 +1,857 @@
+#include "ofxBlend2DRenderer.h"
+#include "ofxBlend2D.h" // ofxBlend2D::GetDefaultFont
+
+#include "ofAppRunner.h" // ofGetCurrentRenderer
+#include "ofGraphics.h" // ofSetCurrentRenderer
+#include "ofLog.h"
+#include "ofImage.h"
+#include "ofMesh.h"
+#include "of3dPrimitives.h"
+#include "ofNode.h"
+#include "ofTrueTypeFont.h"
+#include "ofMath.h" // ofDegToRad
+#include "ofVideoBaseTypes.h"
+
+#include <algorithm>
+#include <sstream>
+#include <cmath>
+
+const std::string ofxBlend2DRenderer::TYPE = "ofxBlend2D";
+
+namespace {
+    // OF matrices are column-major 4x4, only the 2D affine part is used
+    BLMatrix2D toBLMatrix(const glm::mat4& m){
+        return BLMatrix2D(m[0][0], m[0][1], m[1][0], m[1][1], m[3][0], m[3][1]);
+    }
+
+    glm::mat4 toGlmMatrix(const BLMatrix2D& m){
+        glm::mat4 ret(1.0f);
+        ret[0][0] = m.m00; ret[0][1] = m.m01;
+        ret[1][0] = m.m10; ret[1][1] = m.m11;
+        ret[3][0] = m.m20; ret[3][1] = m.m21;
+        return ret;
+    }
+
+    glm::mat4 toGlmMatrix(const float* m){
+        glm::mat4 ret;
+        for(int c=0; c<4; ++c){
+            for(int r=0; r<4; ++r){
+                ret[c][r] = m[c*4+r];
+            }
+        }
+        return ret;
+    }
+
+    BLCompOp toBLCompOp(ofBlendMode mode){
+        switch(mode){
+            case OF_BLENDMODE_DISABLED: return BL_COMP_OP_SRC_COPY;
+            case OF_BLENDMODE_ADD:      return BL_COMP_OP_PLUS;
+            case OF_BLENDMODE_SUBTRACT: return BL_COMP_OP_MINUS;
+            case OF_BLENDMODE_MULTIPLY: return BL_COMP_OP_MULTIPLY;
+            case OF_BLENDMODE_SCREEN:   return BL_COMP_OP_SCREEN;
+            case OF_BLENDMODE_ALPHA:
+            default:                    return BL_COMP_OP_SRC_OVER;
+        }
+    }
+
+    BLFillRule toBLFillRule(ofPolyWindingMode mode){
+        // Blend2D only has these 2, the other OF winding modes fall back to non-zero
+        return (mode==OF_POLY_WINDING_ODD) ? BL_FILL_RULE_EVEN_ODD : BL_FILL_RULE_NON_ZERO;
+    }
+
+    // Converts 8 bit pixels to a premultiplied Blend2D image
+    BLImage toBLImage(const ofPixels& pixels){
+        BLImage ret;
+        const int w = pixels.getWidth();
+        const int h = pixels.getHeight();
+        const int channels = pixels.getNumChannels();
+        if(w<=0 || h<=0 || ret.create(w, h, BL_FORMAT_PRGB32)!=BL_SUCCESS) return ret;
+
+        BLImageData data;
+        ret.make_mutable(&data);
+        const bool isBGR = pixels.getPixelFormat()==OF_PIXELS_BGRA || pixels.getPixelFormat()==OF_PIXELS_BGR;
+        for(int y=0; y<h; ++y){
+            uint32_t* dst = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(data.pixel_data) + y*data.stride);
+            const unsigned char* src = pixels.getData() + std::size_t(y)*w*channels;
+            for(int x=0; x<w; ++x, src+=channels){
+                uint32_t r, g, b, a;
+                if(channels>=3){
+                    r = src[isBGR?2:0]; g = src[1]; b = src[isBGR?0:2];
+                    a = (channels==4) ? src[3] : 255u;
+                }
+                else {
+                    r = g = b = src[0];
+                    a = (channels==2) ? src[1] : 255u;
+                }
+                // Premultiply (rounded)
+                r = (r*a+127u)/255u; g = (g*a+127u)/255u; b = (b*a+127u)/255u;
+                dst[x] = (a<<24) | (r<<16) | (g<<8) | b;
+            }
+        }
+        return ret;
+    }
+}
+
+//--------------------------------------------------------------
+ofxBlend2DRenderer::ofxBlend2DRenderer() : graphics3d(this) {
+    viewMatrix = BLMatrix2D::make_identity();
+}
+
+ofxBlend2DRenderer::~ofxBlend2DRenderer(){
+}
+
+void ofxBlend2DRenderer::bindContext(BLContext& _ctx){
+    ctx = &_ctx;
+    viewMatrix = ctx->user_transform();
+    matrixStack.clear();
+    viewStack.clear();
+    const BLSize size = ctx->target_size();
+    currentViewport.set(0, 0, size.w, size.h);
+    bHasCommandPoint = false;
+
+    // Sync the context with the current style
+    setStyle(currentStyle);
+}
+
+void ofxBlend2DRenderer::unbindContext(){
+    if(ctx!=nullptr){
+        if(!matrixStack.empty()) ofLogWarning("ofxBlend2DRenderer::unbindContext") << "Unbalanced pushMatrix() / popMatrix() calls !";
+        ctx->set_transform(viewMatrix);
+    }
+    ctx = nullptr;
+}
+
+bool ofxBlend2DRenderer::setBitmapFont(const std::string& fontFile, float size){
+    bFontSearched = true;
+    bFontLoaded = false;
+    fontSize = size;
+    BLResult result = fontFace.create_from_file(fontFile.c_str());
+    if(result==BL_SUCCESS) result = font.create_from_face(fontFace, fontSize);
+    if(result!=BL_SUCCESS){
+        ofLogError("ofxBlend2DRenderer::setBitmapFont") << "Couldn't load " << fontFile << " : " << blResultToString(result);
+        return false;
+    }
+    bFontLoaded = true;
+    return true;
+}
+
+bool ofxBlend2DRenderer::ensureBitmapFont() const {
+    if(bFontLoaded || bFontSearched) return bFontLoaded;
+    bFontSearched = true;
+
+#ifndef ofxBlend2D_DISABLE_DEFAULT_FONT
+    // The addon's default font (data/fonts/gohufont-14.ttf)
+    const BLFont& defaultFont = ofxBlend2D::GetDefaultFont();
+    if(defaultFont.face().is_valid()){
+        font = defaultFont;
+        fontSize = font.size();
+        bFontLoaded = true;
+        return true;
+    }
+#endif
+    ofLogWarning("ofxBlend2DRenderer") << "No font for drawing strings, use setBitmapFont() to provide one.";
+    return false;
+}
+
+void ofxBlend2DRenderer::warnUnsupportedOnce(const char* feature) const {
+    if(std::find(warnedFeatures.begin(), warnedFeatures.end(), feature)!=warnedFeatures.end()) return;
+    warnedFeatures.emplace_back(feature);
+    ofLogWarning("ofxBlend2DRenderer") << feature << " is not supported by the Blend2D renderer, ignoring it.";
+}
+
+void ofxBlend2DRenderer::startRender(){
+    // Frames are driven by the context owner (ofxBlend2DThreadedRenderer::begin()/end())
+}
+
+void ofxBlend2DRenderer::finishRender(){
+}
+
+//--------------------------------------------------------------
+// Drawing
+void ofxBlend2DRenderer::drawPath(const BLPath& blPath) const {
+    if(ctx==nullptr) return;
+    if(currentStyle.bFill) ctx->fill_path(blPath, getCurrentColor());
+    else ctx->stroke_path(blPath, getCurrentColor());
+}
+
+void ofxBlend2DRenderer::draw(const ofPath & shape) const {
+    if(ctx==nullptr) return;
+    const BLPath blPath = toBLPath(shape);
+    if(blPath.is_empty()) return;
+
+    if(shape.isFilled()){
+        const ofFloatColor color = shape.getUseShapeColor() ? ofFloatColor(shape.getFillColor()) : ofFloatColor(currentStyle.color);
+        ctx->set_fill_rule(toBLFillRule(shape.getWindingMode()));
+        ctx->fill_path(blPath, toBLColor(color));
+        ctx->set_fill_rule(toBLFillRule(currentStyle.polyMode));
+    }
+    if(shape.hasOutline()){
+        const ofFloatColor color = shape.getUseShapeColor() ? ofFloatColor(shape.getStrokeColor()) : ofFloatColor(currentStyle.color);
+        ctx->set_stroke_width(shape.getStrokeWidth());
+        ctx->stroke_path(blPath, toBLColor(color));
+        ctx->set_stroke_width(currentStyle.lineWidth);
+    }
+}
+
+void ofxBlend2DRenderer::draw(const ofPath::Command & command) const {
+    ofPath single;
+    single.setMode(ofPath::COMMANDS);
+    single.setFilled(currentStyle.bFill);
+    single.setUseShapeColor(false);
+    if(!currentStyle.bFill) single.setStrokeWidth(currentStyle.lineWidth);
+
+    // Segments start from the end of the previous command
+    if(command.type==ofPath::Command::moveTo){
+        commandPoint = commandSubpathStart = command.to;
+        bHasCommandPoint = true;
+        return;
+    }
+    const bool bIsArc = command.type==ofPath::Command::arc || command.type==ofPath::Command::arcNegative;
+    if(!bHasCommandPoint && !bIsArc){
+        // Nothing to draw from, the command starts a subpath instead
+        commandPoint = commandSubpathStart = command.to;
+        bHasCommandPoint = true;
+        return;
+    }
+    if(bHasCommandPoint) single.moveTo(commandPoint);
+
+    switch(command.type){
+        case ofPath::Command::lineTo:       single.lineTo(command.to); break;
+        case ofPath::Command::curveTo:      single.curveTo(command.to); break;
+        case ofPath::Command::bezierTo:     single.bezierTo(command.cp1, command.cp2, command.to); break;
+        case ofPath::Command::quadBezierTo: single.quadBezierTo(command.cp1, command.cp2, command.to); break;
+        case ofPath::Command::arc:          single.arc(command.to, command.radiusX, command.radiusY, command.angleBegin, command.angleEnd); break;
+        case ofPath::Command::arcNegative:  single.arcNegative(command.to, command.radiusX, command.radiusY, command.angleBegin, command.angleEnd); break;
+        case ofPath::Command::close:        single.lineTo(commandSubpathStart); break;
+        default: break;
+    }
+    draw(single);
+
+    // Pen position after the command
+    if(command.type==ofPath::Command::close) commandPoint = commandSubpathStart;
+    else if(bIsArc){
+        auto getArcPoint = [&command](float angleDeg){
+            const float angle = ofDegToRad(angleDeg);
+            return command.to + glm::vec3(command.radiusX*std::cos(angle), command.radiusY*std::sin(angle), 0.f);
+        };
+        if(!bHasCommandPoint) commandSubpathStart = getArcPoint(command.angleBegin);
+        commandPoint = getArcPoint(command.angleEnd);
+        bHasCommandPoint = true;
+    }
+    else commandPoint = command.to;
+}
+
+void ofxBlend2DRenderer::draw(const ofPolyline & poly) const {
+    if(ctx==nullptr || poly.size()<2) return;
+    // Polylines are always outlines in OF
+    ctx->stroke_path(toBLPath(poly), getCurrentColor());
+}
+
+void ofxBlend2DRenderer::drawMeshPrimitive(const ofMesh & mesh, ofPrimitiveMode mode, ofPolyRenderMode renderType, bool useColors) const {
+    if(ctx==nullptr) return;
+    const bool hasIndices = mesh.getNumIndices()>0;
+    const std::size_t count = hasIndices ? mesh.getNumIndices() : mesh.getNumVertices();
+    if(count==0) return;
+    useColors = useColors && mesh.getNumColors()>0;
+
+    auto vertexIndex = [&](std::size_t i){ return hasIndices ? (std::size_t)mesh.getIndex(i) : i; };
+    auto point = [&](std::size_t i){
+        const glm::vec3& v = mesh.getVertex(vertexIndex(i));
+        return BLPoint(v.x, v.y);
+    };
+    auto color = [&](std::size_t i){
+        return useColors ? toBLColor(mesh.getColor(vertexIndex(i))) : getCurrentColor();
+    };
+
+    // Points
+    if(renderType==OF_MESH_POINTS || mode==OF_PRIMITIVE_POINTS){
+        const double radius = std::max(currentStyle.lineWidth, 1.f)*0.5;
+        for(std::size_t i=0; i<count; ++i){
+            const BLPoint p = point(i);
+            ctx->fill_circle(p.x, p.y, radius, color(i));
+        }
+        return;
+    }
+
+    // Lines
+    if(mode==OF_PRIMITIVE_LINES || mode==OF_PRIMITIVE_LINE_STRIP || mode==OF_PRIMITIVE_LINE_LOOP){
+        const std::size_t step = (mode==OF_PRIMITIVE_LINES) ? 2 : 1;
+        for(std::size_t i=0; i+1<count; i+=step){
+            const BLPoint a = point(i), b = point(i+1);
+            ctx->stroke_line(a.x, a.y, b.x, b.y, color(i));
+        }
+        if(mode==OF_PRIMITIVE_LINE_LOOP && count>2){
+            const BLPoint a = point(count-1), b = point(0);
+            ctx->stroke_line(a.x, a.y, b.x, b.y, color(count-1));
+        }
+        return;
+    }
+
+    // Triangles (one flat color per triangle : the first vertex color)
+    auto triangle = [&](std::size_t i0, std::size_t i1, std::size_t i2){
+        const BLPoint a = point(i0), b = point(i1), c = point(i2);
+        if(renderType==OF_MESH_WIREFRAME){
+            BLPath outline;
+            outline.move_to(a); outline.line_to(b); outline.line_to(c); outline.close();
+            ctx->stroke_path(outline, color(i0));
+        }
+        else ctx->fill_triangle(a.x, a.y, b.x, b.y, c.x, c.y, color(i0));
+    };
+    switch(mode){
+        case OF_PRIMITIVE_TRIANGLES:
+            for(std::size_t i=0; i+2<count; i+=3) triangle(i, i+1, i+2);
+            break;
+        case OF_PRIMITIVE_TRIANGLE_STRIP:
+            for(std::size_t i=0; i+2<count; ++i) triangle(i, i+1, i+2);
+            break;
+        case OF_PRIMITIVE_TRIANGLE_FAN:
+            for(std::size_t i=1; i+1<count; ++i) triangle(0, i, i+1);
+            break;
+        default:
+            warnUnsupportedOnce("This mesh primitive mode");
+            break;
+    }
+}
+
+void ofxBlend2DRenderer::draw(const ofMesh & vertexData, ofPolyRenderMode renderType, bool useColors, bool useTextures, bool useNormals) const {
+    if(useTextures && vertexData.getNumTexCoords()>0) warnUnsupportedOnce("Mesh texturing");
+    drawMeshPrimitive(vertexData, vertexData.getMode(), renderType, useColors && vertexData.usingColors());
+}
+
+void ofxBlend2DRenderer::draw(const of3dPrimitive& model, ofPolyRenderMode renderType) const {
+    if(ctx==nullptr) return;
+    ctx->save();
+    ctx->apply_transform(toBLMatrix(model.getGlobalTransformMatrix()));
+    draw(model.getMesh(), renderType, model.getMesh().usingColors(), false, false);
+    ctx->restore();
+}
+
+void ofxBlend2DRenderer::draw(const ofNode& node) const {
+    if(ctx==nullptr) return;
+    ctx->save();
+    ctx->apply_transform(toBLMatrix(node.getGlobalTransformMatrix()));
+    node.customDraw(this);
+    ctx->restore();
+}
+
+void ofxBlend2DRenderer::draw(const std::vector<glm::vec3> & vertexData, ofPrimitiveMode drawMode) const {
+    ofMesh mesh(drawMode, vertexData);
+    drawMeshPrimitive(mesh, drawMode, currentStyle.bFill ? OF_MESH_FILL : OF_MESH_WIREFRAME, false);
+}
+
+void ofxBlend2DRenderer::drawImage(const BLImage& image, float x, float y, float w, float h, float sx, float sy, float sw, float sh) const {
+    if(ctx==nullptr || image.empty()) return;
+    if(currentStyle.rectMode==OF_RECTMODE_CENTER){
+        x -= w*0.5f;
+        y -= h*0.5f;
+    }
+    ctx->blit_image(BLRect(x, y, w, h), image, BLRectI(sx, sy, sw, sh));
+}
+
+void ofxBlend2DRenderer::draw(const ofPixels & pixels, float x, float y, float w, float h, float sx, float sy, float sw, float sh) const {
+    drawImage(toBLImage(pixels), x, y, w, h, sx, sy, sw, sh);
+}
+
+void ofxBlend2DRenderer::draw(const ofImage & image, float x, float y, float z, float w, float h, float sx, float sy, float sw, float sh) const {
+    draw(image.getPixels(), x, y, w, h, sx, sy, sw, sh);
+}
+
+void ofxBlend2DRenderer::draw(const ofFloatImage & image, float x, float y, float z, float w, float h, float sx, float sy, float sw, float sh) const {
+    ofPixels pixels;
+    pixels = image.getPixels(); // Converts to 8 bit
+    draw(pixels, x, y, w, h, sx, sy, sw, sh);
+}
+
+void ofxBlend2DRenderer::draw(const ofShortImage & image, float x, float y, float z, float w, float h, float sx, float sy, float sw, float sh) const {
+    ofPixels pixels;
+    pixels = image.getPixels();
+    draw(pixels, x, y, w, h, sx, sy, sw, sh);
+}
+
+void ofxBlend2DRenderer::draw(const ofBaseVideoDraws & video, float x, float y, float w, float h) const {
+    const ofPixels& pixels = video.getPixels();
+    draw(pixels, x, y, w, h, 0, 0, pixels.getWidth(), pixels.getHeight());
+}
+
+void ofxBlend2DRenderer::drawLine(float x1, float y1, float z1, float x2, float y2, float z2) const {
+    if(ctx==nullptr) return;
+    ctx->stroke_line(x1, y1, x2, y2, getCurrentColor());
+}
+
+void ofxBlend2DRenderer::drawRectangle(float x, float y, float z, float w, float h) const {
+    if(ctx==nullptr) return;
+    if(currentStyle.rectMode==OF_RECTMODE_CENTER){
+        x -= w*0.5f;
+        y -= h*0.5f;
+    }
+    if(currentStyle.bFill) ctx->fill_rect(BLRect(x, y, w, h), getCurrentColor());
+    else ctx->stroke_rect(BLRect(x, y, w, h), getCurrentColor());
+}
+
+void ofxBlend2DRenderer::drawTriangle(float x1, float y1, float z1, float x2, float y2, float z2, float x3, float y3, float z3) const {
+    if(ctx==nullptr) return;
+    if(currentStyle.bFill) ctx->fill_triangle(x1, y1, x2, y2, x3, y3, getCurrentColor());
+    else ctx->stroke_triangle(x1, y1, x2, y2, x3, y3, getCurrentColor());
+}
+
+void ofxBlend2DRenderer::drawCircle(float x, float y, float z, float radius) const {
+    if(ctx==nullptr) return;
+    if(currentStyle.bFill) ctx->fill_circle(x, y, radius, getCurrentColor());
+    else ctx->stroke_circle(x, y, radius, getCurrentColor());
+}
+
+void ofxBlend2DRenderer::drawEllipse(float x, float y, float z, float width, float height) const {
+    if(ctx==nullptr) return;
+    // OF ellipses are centered, with a diameter
+    if(currentStyle.bFill) ctx->fill_ellipse(x, y, width*0.5f, height*0.5f, getCurrentColor());
+    else ctx->stroke_ellipse(x, y, width*0.5f, height*0.5f, getCurrentColor());
+}
+
+void ofxBlend2DRenderer::drawString(std::string text, float x, float y, float z) const {
+    if(ctx==nullptr || text.empty() || !ensureBitmapFont()) return;
+    std::istringstream lines(text);
+    std::string line;
+    const float lineHeight = fontSize*1.2f;
+    while(std::getline(lines, line)){
+        if(!line.empty()) ctx->fill_utf8_text(BLPoint(x, y), font, line.c_str(), line.size(), getCurrentColor());
+        y += lineHeight;
+    }
+}
+
+void ofxBlend2DRenderer::drawString(const ofTrueTypeFont & ttf, std::string text, float x, float y) const {
+    if(ctx==nullptr) return;
+    // Needs the font to be loaded with contours (makeContours=true)
+    const std::vector<ofPath> glyphs = ttf.getStringAsPoints(text, true, currentStyle.bFill);
+    if(glyphs.empty()){
+        if(!text.empty()) warnUnsupportedOnce("ofTrueTypeFont without contours");
+        return;
+    }
+    BLPath blPath;
+    for(const ofPath& glyph : glyphs){
+        blPath.add_path(toBLPath(glyph));
+    }
+    ctx->save();
+    ctx->translate(x, y);
+    ctx->set_fill_rule(BL_FILL_RULE_NON_ZERO);
+    drawPath(blPath);
+    ctx->restore();
+}
+
+//--------------------------------------------------------------
+// Transformations
+void ofxBlend2DRenderer::pushView(){
+    if(ctx==nullptr) return;
+    viewStack.emplace_back(ctx->user_transform(), currentViewport);
+}
+
+void ofxBlend2DRenderer::popView(){
+    if(ctx==nullptr || viewStack.empty()) return;
+    ctx->set_transform(viewStack.back().first);
+    currentViewport = viewStack.back().second;
+    viewStack.pop_back();
+}
+
+void ofxBlend2DRenderer::viewport(ofRectangle _viewport){
+    viewport(_viewport.x, _viewport.y, _viewport.width, _viewport.height, isVFlipped());
+}
+
+void ofxBlend2DRenderer::viewport(float x, float y, float width, float height, bool vflip){
+    const ofRectangle native = getNativeViewport();
+    if(width<0) width = native.width;
+    if(height<0) height = native.height;
+    currentViewport.set(x, y, width, height);
+}
+
+void ofxBlend2DRenderer::setupScreenPerspective(float width, float height, float fov, float nearDist, float farDist){
+    warnUnsupportedOnce("Perspective projection");
+    setupScreen();
+}
+
+void ofxBlend2DRenderer::setupScreenOrtho(float width, float height, float nearDist, float farDist){
+    setupScreen();
+}
+
+void ofxBlend2DRenderer::setOrientation(ofOrientation orientation, bool vFlip){
+}
+
+ofRectangle ofxBlend2DRenderer::getCurrentViewport() const {
+    return currentViewport;
+}
+
+ofRectangle ofxBlend2DRenderer::getNativeViewport() const {
+    if(ctx==nullptr) return ofRectangle();
+    const BLSize size = ctx->target_size();
+    return ofRectangle(0, 0, size.w, size.h);
+}
+
+int ofxBlend2DRenderer::getViewportWidth() const {
+    return currentViewport.width;
+}
+
+int ofxBlend2DRenderer::getViewportHeight() const {
+    return currentViewport.height;
+}
+
+bool ofxBlend2DRenderer::isVFlipped() const {
+    // Blend2D has y going down, like OF screen coordinates
+    return true;
+}
+
+void ofxBlend2DRenderer::setCoordHandedness(ofHandednessType handedness){
+}
+
+ofHandednessType ofxBlend2DRenderer::getCoordHandedness() const {
+    return OF_LEFT_HANDED;
+}
+
+void ofxBlend2DRenderer::pushMatrix(){
+    if(ctx==nullptr) return;
+    matrixStack.push_back(ctx->user_transform());
+}
+
+void ofxBlend2DRenderer::popMatrix(){
+    if(ctx==nullptr) return;
+    if(matrixStack.empty()){
+        ofLogWarning("ofxBlend2DRenderer::popMatrix") << "popMatrix() without pushMatrix() !";
+        return;
+    }
+    ctx->set_transform(matrixStack.back());
+    matrixStack.pop_back();
+}
+
+glm::mat4 ofxBlend2DRenderer::getCurrentMatrix(ofMatrixMode matrixMode_) const {
+    if(ctx==nullptr || matrixMode_!=OF_MATRIX_MODELVIEW) return glm::mat4(1.0f);
+    return toGlmMatrix(ctx->user_transform());
+}
+
+glm::mat4 ofxBlend2DRenderer::getCurrentOrientationMatrix() const {
+    return glm::mat4(1.0f);
+}
+
+void ofxBlend2DRenderer::translate(float x, float y, float z){
+    if(ctx==nullptr) return;
+    ctx->translate(x, y);
+}
+
+void ofxBlend2DRenderer::translate(const glm::vec3 & p){
+    translate(p.x, p.y, p.z);
+}
+
+void ofxBlend2DRenderer::scale(float xAmnt, float yAmnt, float zAmnt){
+    if(ctx==nullptr) return;
+    ctx->scale(xAmnt, yAmnt);
+}
+
+void ofxBlend2DRenderer::rotateDeg(float degrees, float vecX, float vecY, float vecZ){
+    rotateRad(degrees*DEG_TO_RAD, vecX, vecY, vecZ);
+}
+
+void ofxBlend2DRenderer::rotateXDeg(float degrees){
+    rotateXRad(degrees*DEG_TO_RAD);
+}
+
+void ofxBlend2DRenderer::rotateYDeg(float degrees){
+    rotateYRad(degrees*DEG_TO_RAD);
+}
+
+void ofxBlend2DRenderer::rotateZDeg(float degrees){
+    rotateZRad(degrees*DEG_TO_RAD);
+}
+
+void ofxBlend2DRenderer::rotateDeg(float degrees){
+    rotateRad(degrees*DEG_TO_RAD);
+}
+
+void ofxBlend2DRenderer::rotateRad(float radians, float vecX, float vecY, float vecZ){
+    if(vecX==0.f && vecY==0.f && vecZ!=0.f){
+        rotateRad(vecZ>0.f ? radians : -radians);
+    }
+    else warnUnsupportedOnce("3D rotation");
+}
+
+void ofxBlend2DRenderer::rotateXRad(float radians){
+    warnUnsupportedOnce("3D rotation");
+}
+
+void ofxBlend2DRenderer::rotateYRad(float radians){
+    warnUnsupportedOnce("3D rotation");
+}
+
+void ofxBlend2DRenderer::rotateZRad(float radians){
+    rotateRad(radians);
+}
+
+void ofxBlend2DRenderer::rotateRad(float radians){
+    if(ctx==nullptr) return;
+    ctx->rotate(radians);
+}
+
+void ofxBlend2DRenderer::matrixMode(ofMatrixMode mode){
+    if(mode!=OF_MATRIX_MODELVIEW) warnUnsupportedOnce("Matrix modes other than OF_MATRIX_MODELVIEW");
+}
+
+void ofxBlend2DRenderer::loadIdentityMatrix(){
+    if(ctx==nullptr) return;
+    ctx->set_transform(viewMatrix);
+}
+
+void ofxBlend2DRenderer::loadMatrix(const glm::mat4 & m){
+    if(ctx==nullptr) return;
+    BLMatrix2D matrix = toBLMatrix(m);
+    matrix.post_transform(viewMatrix);
+    ctx->set_transform(matrix);
+}
+
+void ofxBlend2DRenderer::loadMatrix(const float *m){
+    loadMatrix(toGlmMatrix(m));
+}
+
+void ofxBlend2DRenderer::multMatrix(const glm::mat4 & m){
+    if(ctx==nullptr) return;
+    ctx->apply_transform(toBLMatrix(m));
+}
+
+void ofxBlend2DRenderer::multMatrix(const float *m){
+    multMatrix(toGlmMatrix(m));
+}
+
+void ofxBlend2DRenderer::loadViewMatrix(const glm::mat4 & m){
+    viewMatrix = toBLMatrix(m);
+    if(ctx!=nullptr) ctx->set_transform(viewMatrix);
+}
+
+void ofxBlend2DRenderer::multViewMatrix(const glm::mat4 & m){
+    viewMatrix.transform(toBLMatrix(m));
+    if(ctx!=nullptr) ctx->set_transform(viewMatrix);
+}
+
+glm::mat4 ofxBlend2DRenderer::getCurrentViewMatrix() const {
+    return toGlmMatrix(viewMatrix);
+}
+
+glm::mat4 ofxBlend2DRenderer::getCurrentNormalMatrix() const {
+    return glm::mat4(1.0f);
+}
+
+void ofxBlend2DRenderer::bind(const ofCamera & camera, const ofRectangle & _viewport){
+    warnUnsupportedOnce("ofCamera");
+}
+
+void ofxBlend2DRenderer::unbind(const ofCamera & camera){
+}
+
+void ofxBlend2DRenderer::setupGraphicDefaults(){
+    setStyle(ofStyle());
+}
+
+void ofxBlend2DRenderer::setupScreen(){
+    if(ctx==nullptr) return;
+    ctx->set_transform(viewMatrix);
+}
+
+//--------------------------------------------------------------
+// Style
+void ofxBlend2DRenderer::setRectMode(ofRectMode mode){
+    currentStyle.rectMode = mode;
+}
+
+ofRectMode ofxBlend2DRenderer::getRectMode(){
+    return currentStyle.rectMode;
+}
+
+void ofxBlend2DRenderer::setFillMode(ofFillFlag fill){
+    currentStyle.bFill = (fill==OF_FILLED);
+}
+
+ofFillFlag ofxBlend2DRenderer::getFillMode(){
+    return currentStyle.bFill ? OF_FILLED : OF_OUTLINE;
+}
+
+void ofxBlend2DRenderer::setLineWidth(float lineWidth){
+    currentStyle.lineWidth = lineWidth;
+    if(ctx!=nullptr) ctx->set_stroke_width(lineWidth);
+}
+
+void ofxBlend2DRenderer::setDepthTest(bool depthTest){
+    if(depthTest) warnUnsupportedOnce("Depth testing");
+}
+
+void ofxBlend2DRenderer::setBlendMode(ofBlendMode blendMode){
+    currentStyle.blendingMode = blendMode;
+    if(ctx!=nullptr) ctx->set_comp_op(toBLCompOp(blendMode));
+}
+
+void ofxBlend2DRenderer::setLineSmoothing(bool smooth){
+    // Blend2D always antialiases
+    currentStyle.smoothing = smooth;
+}
+
+void ofxBlend2DRenderer::setCircleResolution(int res){
+    // Circles are true curves in Blend2D
+    currentStyle.circleResolution = res;
+}
+
+void ofxBlend2DRenderer::enableAntiAliasing(){
+}
+
+void ofxBlend2DRenderer::disableAntiAliasing(){
+}
+
+void ofxBlend2DRenderer::setColor(int r, int g, int b){
+    setColor(ofColor(r, g, b));
+}
+
+void ofxBlend2DRenderer::setColor(int r, int g, int b, int a){
+    setColor(ofColor(r, g, b, a));
+}
+
+void ofxBlend2DRenderer::setColor(const ofColor & color){
+    currentStyle.color = color;
+}
+
+void ofxBlend2DRenderer::setColor(const ofColor & color, int _a){
+    setColor(ofColor(color, _a));
+}
+
+void ofxBlend2DRenderer::setColor(int gray){
+    setColor(ofColor(gray));
+}
+
+void ofxBlend2DRenderer::setHexColor(int hexColor){
+    setColor(ofColor::fromHex(hexColor));
+}
+
+void ofxBlend2DRenderer::setBitmapTextMode(ofDrawBitmapMode mode){
+    currentStyle.drawBitmapMode = mode;
+}
+
+ofColor ofxBlend2DRenderer::getBackgroundColor(){
+    return currentStyle.bgColor;
+}
+
+void ofxBlend2DRenderer::setBackgroundColor(const ofColor & c){
+    currentStyle.bgColor = c;
+}
+
+void ofxBlend2DRenderer::background(const ofColor & c){
+    setBackgroundColor(c);
+    if(ctx==nullptr) return;
+    ctx->save();
+    ctx->set_comp_op(BL_COMP_OP_SRC_COPY);
+    ctx->fill_all(toBLColor(ofFloatColor(c)));
+    ctx->restore();
+}
+
+void ofxBlend2DRenderer::background(float brightness){
+    background(ofColor(brightness));
+}
+
+void ofxBlend2DRenderer::background(int hexColor, float _a){
+    background(ofColor::fromHex(hexColor, _a));
+}
+
+void ofxBlend2DRenderer::background(int r, int g, int b, int a){
+    background(ofColor(r, g, b, a));
+}
+
+void ofxBlend2DRenderer::setBackgroundAuto(bool bManual){
+    bBackgroundAuto = bManual;
+}
+
+bool ofxBlend2DRenderer::getBackgroundAuto(){
+    return bBackgroundAuto;
+}
+
+void ofxBlend2DRenderer::clear(){
+    if(ctx==nullptr) return;
+    ctx->clear_all();
+}
+
+void ofxBlend2DRenderer::clear(float r, float g, float b, float a){
+    if(ctx==nullptr) return;
+    ctx->save();
+    ctx->set_comp_op(BL_COMP_OP_SRC_COPY);
+    ctx->fill_all(toBLColor(ofFloatColor(r/255.f, g/255.f, b/255.f, a/255.f)));
+    ctx->restore();
+}
+
+void ofxBlend2DRenderer::clear(float brightness, float a){
+    clear(brightness, brightness, brightness, a);
+}
+
+void ofxBlend2DRenderer::clearAlpha(){
+    warnUnsupportedOnce("clearAlpha()");
+}
+
+ofPath & ofxBlend2DRenderer::getPath(){
+    return path;
+}
+
+ofStyle ofxBlend2DRenderer::getStyle() const {
+    return currentStyle;
+}
+
+void ofxBlend2DRenderer::setStyle(const ofStyle & style){
+    currentStyle = style;
+    if(ctx==nullptr) return;
+    ctx->set_comp_op(toBLCompOp(style.blendingMode));
+    ctx->set_fill_rule(toBLFillRule(style.polyMode));
+    ctx->set_stroke_width(style.lineWidth);
+}
+
+void ofxBlend2DRenderer::pushStyle(){
+    styleHistory.push_back(currentStyle);
+    // Same limit as the other OF renderers
+    if(styleHistory.size()>OF_MAX_STYLE_HISTORY){
+        styleHistory.pop_front();
+        ofLogWarning("ofxBlend2DRenderer::pushStyle") << "Style history overflow, did you forget a popStyle() ?";
+    }
+}
+
+void ofxBlend2DRenderer::popStyle(){
+    if(styleHistory.empty()) return;
+    setStyle(styleHistory.back());
+    styleHistory.pop_back();
+}
+
+void ofxBlend2DRenderer::setCurveResolution(int resolution){
+    currentStyle.curveResolution = resolution;
+}
+
+void ofxBlend2DRenderer::setPolyMode(ofPolyWindingMode mode){
+    currentStyle.polyMode = mode;
+    if(ctx!=nullptr) ctx->set_fill_rule(toBLFillRule(mode));
+}
+
+const of3dGraphics & ofxBlend2DRenderer::get3dGraphics() const {
+    return graphics3d;
+}
+
+of3dGraphics & ofxBlend2DRenderer::get3dGraphics(){
+    return graphics3d;
+}
+
+//--------------------------------------------------------------
+namespace {
+    std::shared_ptr<ofBaseRenderer> previousRenderer;
+    std::shared_ptr<ofxBlend2DRenderer> activeRenderer;
+}
+
+void ofxBlend2DBeginRenderer(const std::shared_ptr<ofxBlend2DRenderer>& renderer, BLContext& ctx){
+    if(activeRenderer){
+        ofLogWarning("ofxBlend2DBeginRenderer") << "Already active, call ofxBlend2DEndRenderer() first !";
+        return;
+    }
+    renderer->bindContext(ctx);
+    previousRenderer = ofGetCurrentRenderer();
+    activeRenderer = renderer;
+    ofSetCurrentRenderer(renderer, true); // Inherits the current style
+}
+
+void ofxBlend2DEndRenderer(){
+    if(!activeRenderer) return;
+    ofSetCurrentRenderer(previousRenderer);
+    activeRenderer->unbindContext();
+    activeRenderer.reset();
+    previousRenderer.reset();
+}
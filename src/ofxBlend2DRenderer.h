@@ -0,0 +1,224 @@
+#pragma once
+
+#include "blend2d/blend2d.h"
+#include "ofxBlend2DGlue.h"
+
+#include "ofGraphicsBaseTypes.h"
+#include "of3dGraphics.h"
+#include "ofPath.h"
+#include "ofRectangle.h"
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <string>
+
+// ofBaseRenderer backed by Blend2D
+// - - - -
+// Maps the OpenFrameworks drawing API (ofDrawRectangle, ofDrawCircle, ofPath::draw, ofPolyline::draw, matrix and style stacks, strings...)
+// onto a BLContext, typically the one of an ofxBlend2DThreadedRenderer frame. Existing OF draw code then rasterizes on the CPU, using Blend2D's threads.
+//
+// Usage (from the main thread) :
+//     if(blend2d.begin()){
+//         ofxBlend2DBeginRenderer(renderer, blend2d.getBlContext()); // ofDraw...() calls now go to Blend2D
+//         ofDrawCircle(100, 100, 50);
+//         ofxBlend2DEndRenderer(); // Restores the previous renderer
+//         blend2d.end(ofGetFrameNum());
+//     }
+//
+// Limitations :
+// - 2D only : z coordinates are ignored, 3D rotations, cameras and perspective are not supported.
+// - Meshes are drawn as flat colored triangles / lines / points (no textures, no shaders, no lighting).
+// - Bitmap strings use a font file (the addon's default font or setBitmapFont()), not the OF bitmap glyphs.
+// - Images are converted to Blend2D images on every draw, prefer native Blend2D images for repeated drawing.
+
+class ofxBlend2DRenderer : public ofBaseRenderer {
+    public:
+        ofxBlend2DRenderer();
+        ~ofxBlend2DRenderer();
+
+        static const std::string TYPE;
+        const std::string & getType(){ return TYPE; }
+
+        // Binds a context to draw into, until unbindContext(). The current context transform becomes the view matrix.
+        void bindContext(BLContext& ctx);
+        void unbindContext();
+        bool hasContext() const { return ctx!=nullptr; }
+        BLContext* getBlContext() { return ctx; }
+
+        // Font used for drawString() / ofDrawBitmapString(). If not set, the addon's default font is used.
+        bool setBitmapFont(const std::string& fontFile, float size=13.f);
+
+        void startRender();
+        void finishRender();
+
+        using ofBaseRenderer::draw;
+        void draw(const ofPath & shape) const;
+        void draw(const ofPath::Command & path) const; // Continues from the previous command (moveTo only moves the pen)
+        void draw(const ofPolyline & poly) const;
+        void draw(const ofMesh & vertexData, ofPolyRenderMode renderType, bool useColors, bool useTextures, bool useNormals) const;
+        void draw(const of3dPrimitive& model, ofPolyRenderMode renderType) const;
+        void draw(const ofNode& node) const;
+        void draw(const std::vector<glm::vec3> & vertexData, ofPrimitiveMode drawMode) const;
+        void draw(const ofImage & image, float x, float y, float z, float w, float h, float sx, float sy, float sw, float sh) const;
+        void draw(const ofFloatImage & image, float x, float y, float z, float w, float h, float sx, float sy, float sw, float sh) const;
+        void draw(const ofShortImage & image, float x, float y, float z, float w, float h, float sx, float sy, float sw, float sh) const;
+        void draw(const ofBaseVideoDraws & video, float x, float y, float w, float h) const;
+        void draw(const ofPixels & pixels, float x, float y, float w, float h, float sx, float sy, float sw, float sh) const;
+
+        bool rendersPathPrimitives(){
+            return true;
+        }
+
+        //--------------------------------------------
+        // transformations
+        void pushView();
+        void popView();
+
+        void viewport(ofRectangle viewport);
+        void viewport(float x = 0, float y = 0, float width = -1, float height = -1, bool vflip=true);
+        void setupScreenPerspective(float width = -1, float height = -1, float fov = 60, float nearDist = 0, float farDist = 0);
+        void setupScreenOrtho(float width = -1, float height = -1, float nearDist = -1, float farDist = 1);
+        void setOrientation(ofOrientation orientation, bool vFlip);
+        ofRectangle getCurrentViewport() const;
+        ofRectangle getNativeViewport() const;
+        int getViewportWidth() const;
+        int getViewportHeight() const;
+        bool isVFlipped() const;
+
+        void setCoordHandedness(ofHandednessType handedness);
+        ofHandednessType getCoordHandedness() const;
+
+        void pushMatrix();
+        void popMatrix();
+        glm::mat4 getCurrentMatrix(ofMatrixMode matrixMode_) const;
+        glm::mat4 getCurrentOrientationMatrix() const;
+        void translate(float x, float y, float z = 0);
+        void translate(const glm::vec3 & p);
+        void scale(float xAmnt, float yAmnt, float zAmnt = 1);
+        void rotateDeg(float degrees, float vecX, float vecY, float vecZ);
+        void rotateXDeg(float degrees);
+        void rotateYDeg(float degrees);
+        void rotateZDeg(float degrees);
+        void rotateDeg(float degrees);
+        void rotateRad(float radians, float vecX, float vecY, float vecZ);
+        void rotateXRad(float radians);
+        void rotateYRad(float radians);
+        void rotateZRad(float radians);
+        void rotateRad(float radians);
+        void matrixMode(ofMatrixMode mode);
+        void loadIdentityMatrix (void);
+        void loadMatrix (const glm::mat4 & m);
+        void loadMatrix (const float *m);
+        void multMatrix (const glm::mat4 & m);
+        void multMatrix (const float *m);
+        void loadViewMatrix(const glm::mat4 & m);
+        void multViewMatrix(const glm::mat4 & m);
+        glm::mat4 getCurrentViewMatrix() const;
+        glm::mat4 getCurrentNormalMatrix() const;
+
+        void bind(const ofCamera & camera, const ofRectangle & viewport);
+        void unbind(const ofCamera & camera);
+
+        // screen coordinate things / default gl values
+        void setupGraphicDefaults();
+        void setupScreen();
+
+        // drawing modes
+        void setRectMode(ofRectMode mode);
+        ofRectMode getRectMode();
+        void setFillMode(ofFillFlag fill);
+        ofFillFlag getFillMode();
+        void setLineWidth(float lineWidth);
+        void setDepthTest(bool depthTest);
+        void setBlendMode(ofBlendMode blendMode);
+        void setLineSmoothing(bool smooth);
+        void setCircleResolution(int res);
+        void enableAntiAliasing();
+        void disableAntiAliasing();
+
+        // color options
+        void setColor(int r, int g, int b);
+        void setColor(int r, int g, int b, int a);
+        void setColor(const ofColor & color);
+        void setColor(const ofColor & color, int _a);
+        void setColor(int gray);
+        void setHexColor( int hexColor );
+
+        void setBitmapTextMode(ofDrawBitmapMode mode);
+
+        // bg color
+        ofColor getBackgroundColor();
+        void setBackgroundColor(const ofColor & c);
+        void background(const ofColor & c);
+        void background(float brightness);
+        void background(int hexColor, float _a=255.0f);
+        void background(int r, int g, int b, int a=255);
+
+        void setBackgroundAuto(bool bManual);
+        bool getBackgroundAuto();
+
+        void clear();
+        void clear(float r, float g, float b, float a=0);
+        void clear(float brightness, float a=0);
+        void clearAlpha();
+
+        // drawing
+        void drawLine(float x1, float y1, float z1, float x2, float y2, float z2) const;
+        void drawRectangle(float x, float y, float z, float w, float h) const;
+        void drawTriangle(float x1, float y1, float z1, float x2, float y2, float z2, float x3, float y3, float z3) const;
+        void drawCircle(float x, float y, float z, float radius) const;
+        void drawEllipse(float x, float y, float z, float width, float height) const;
+        void drawString(std::string text, float x, float y, float z) const;
+        void drawString(const ofTrueTypeFont & font, std::string text, float x, float y) const;
+
+        ofPath & getPath();
+        ofStyle getStyle() const;
+        void setStyle(const ofStyle & style);
+        void pushStyle();
+        void popStyle();
+
+        void setCurveResolution(int resolution);
+        void setPolyMode(ofPolyWindingMode mode);
+
+        const of3dGraphics & get3dGraphics() const;
+        of3dGraphics & get3dGraphics();
+
+    protected:
+        BLRgba32 getCurrentColor() const { return toBLColor(ofFloatColor(currentStyle.color)); }
+        // Fills or strokes, depending on the fill mode
+        void drawPath(const BLPath& path) const;
+        void drawImage(const BLImage& image, float x, float y, float w, float h, float sx, float sy, float sw, float sh) const;
+        void drawMeshPrimitive(const ofMesh & mesh, ofPrimitiveMode mode, ofPolyRenderMode renderType, bool useColors) const;
+        bool ensureBitmapFont() const;
+        void warnUnsupportedOnce(const char* feature) const;
+
+        BLContext* ctx = nullptr;
+        BLMatrix2D viewMatrix; // Context transform when bound
+        std::vector<BLMatrix2D> matrixStack;
+        std::vector<std::pair<BLMatrix2D, ofRectangle> > viewStack;
+        ofRectangle currentViewport;
+
+        ofStyle currentStyle;
+        std::deque<ofStyle> styleHistory;
+        bool bBackgroundAuto = true;
+
+        mutable ofPath path;
+        // Pen of the isolated draw(ofPath::Command) calls, which continue from the previous one
+        mutable glm::vec3 commandPoint;
+        mutable glm::vec3 commandSubpathStart;
+        mutable bool bHasCommandPoint = false;
+        of3dGraphics graphics3d;
+
+        mutable BLFontFace fontFace;
+        mutable BLFont font;
+        mutable bool bFontLoaded = false;
+        mutable bool bFontSearched = false;
+        mutable float fontSize = 13.f;
+
+        mutable std::vector<std::string> warnedFeatures;
+};
+
+// Routes the global ofDraw...() functions to a Blend2D renderer bound to ctx, until ofxBlend2DEndRenderer().
+void ofxBlend2DBeginRenderer(const std::shared_ptr<ofxBlend2DRenderer>& renderer, BLContext& ctx);
+void ofxBlend2DEndRenderer();
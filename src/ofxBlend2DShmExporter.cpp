@@ -0,0 +1,417 @@
+#include "ofxBlend2DShmExporter.h"
+#include "ofxBlend2DGlue.h"
+#include "ofLog.h"
+
+#include <cstring>
+#include <thread>
+#include <chrono>
+#include <new>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <climits>
+#endif
+
+using namespace ofxBlend2DShmFormat;
+
+static constexpr uint64_t pageSize = 4096;
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment){
+    return (value+alignment-1)/alignment*alignment;
+}
+
+static int getBytesPerPixel(BLFormat format){
+    switch(format){
+        case BL_FORMAT_PRGB32:
+        case BL_FORMAT_XRGB32:
+            return 4;
+        case BL_FORMAT_A8:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// - - - - ofxBlend2DShmExporter
+
+struct ofxBlend2DShmExporter::Mapping {
+    uint8_t* data = nullptr;
+    std::size_t size = 0;
+    Header* header = nullptr;
+    SlotHeader* slots = nullptr;
+    std::vector<bool> slotInUse; // Reserved by a canvas or a copy
+    std::mutex mutex; // Protects slotInUse
+
+    uint8_t* getPixels(uint32_t slot) const {
+        return data + header->pixelsOffset + slot*header->slotSize;
+    }
+
+    ~Mapping(){
+#ifndef _WIN32
+        if(data) munmap(data, size);
+#endif
+    }
+};
+
+struct ofxBlend2DShmExporter::SlotToken {
+    std::shared_ptr<Mapping> mapping;
+    int slot;
+};
+
+ofxBlend2DShmExporter::~ofxBlend2DShmExporter(){
+    close();
+}
+
+bool ofxBlend2DShmExporter::open(const std::string& _name, int width, int height, BLFormat format, unsigned int numSlots){
+    close();
+
+#ifdef _WIN32
+    ofLogError("ofxBlend2DShmExporter::open") << "Shared memory export needs POSIX shared memory, it's not available on Windows.";
+    return false;
+#else
+    const int bytesPerPixel = getBytesPerPixel(format);
+    if(width<=0 || height<=0 || bytesPerPixel==0 || numSlots<2){
+        ofLogError("ofxBlend2DShmExporter::open") << "Invalid geometry : " << width << "x" << height << ", format=" << format << ", " << numSlots << " slots.";
+        return false;
+    }
+    if(_name.empty() || _name[0]!='/'){
+        ofLogError("ofxBlend2DShmExporter::open") << "Shared memory names must start with a slash, ex: /ofxBlend2D";
+        return false;
+    }
+
+    const int64_t stride = alignUp((uint64_t)width*bytesPerPixel, 64);
+    const uint64_t pixelsOffset = alignUp(sizeof(Header)+numSlots*sizeof(SlotHeader), pageSize);
+    const uint64_t slotSize = alignUp(stride*height, pageSize);
+    const uint64_t totalSize = pixelsOffset + numSlots*slotSize;
+
+    // Replace any leftover segment (crashed writer), readers still mapping it keep the old one
+    shm_unlink(_name.c_str());
+    const int fd = shm_open(_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if(fd<0){
+        ofLogError("ofxBlend2DShmExporter::open") << "Couldn't create " << _name << " : " << strerror(errno);
+        return false;
+    }
+    if(ftruncate(fd, (off_t)totalSize)!=0){
+        ofLogError("ofxBlend2DShmExporter::open") << "Couldn't resize " << _name << " to " << totalSize << " bytes : " << strerror(errno);
+        ::close(fd);
+        shm_unlink(_name.c_str());
+        return false;
+    }
+    void* mapped = mmap(nullptr, totalSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping keeps its own reference
+    if(mapped==MAP_FAILED){
+        ofLogError("ofxBlend2DShmExporter::open") << "Couldn't map " << _name << " : " << strerror(errno);
+        shm_unlink(_name.c_str());
+        return false;
+    }
+
+    std::shared_ptr<Mapping> newMapping = std::make_shared<Mapping>();
+    newMapping->data = static_cast<uint8_t*>(mapped);
+    newMapping->size = totalSize;
+    newMapping->slotInUse.assign(numSlots, false);
+
+    // Fresh pages are zeroed, construct the atomics in place
+    Header* header = new (mapped) Header();
+    header->version = version;
+    header->headerSize = sizeof(Header);
+    header->slotHeaderSize = sizeof(SlotHeader);
+    header->numSlots = numSlots;
+    header->width = width;
+    header->height = height;
+    header->stride = stride;
+    header->format = format;
+    header->writerPid = (uint32_t)getpid();
+    header->pixelsOffset = pixelsOffset;
+    header->slotSize = slotSize;
+    header->totalSize = totalSize;
+    header->publishCount.store(0);
+    header->latestSlot.store(noSlot);
+    newMapping->header = header;
+    newMapping->slots = reinterpret_cast<SlotHeader*>(newMapping->data + sizeof(Header));
+    for(unsigned int i=0; i<numSlots; ++i){
+        new (&newMapping->slots[i]) SlotHeader();
+        newMapping->slots[i].sequence.store(0);
+    }
+    // Readers check the magic last
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->magic, magic, sizeof(magic));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    mapping = std::move(newMapping);
+    name = _name;
+    publishedFrames = 0;
+    copiedFrames = 0;
+    bWarnedFormat = false;
+    ofLogNotice("ofxBlend2DShmExporter::open") << "Publishing " << width << "x" << height << " frames to " << name << " (" << numSlots << " slots, " << totalSize/(1024*1024) << " MB)";
+    return true;
+#endif
+}
+
+void ofxBlend2DShmExporter::close(){
+    std::lock_guard<std::mutex> lock(mutex);
+    if(!mapping) return;
+#ifndef _WIN32
+    shm_unlink(name.c_str());
+#endif
+    mapping.reset();
+}
+
+bool ofxBlend2DShmExporter::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return mapping!=nullptr;
+}
+
+int ofxBlend2DShmExporter::reserveSlot(){
+    if(!mapping) return -1;
+    std::lock_guard<std::mutex> lock(mapping->mutex);
+    const uint32_t numSlots = mapping->header->numSlots;
+    const uint32_t latest = mapping->header->latestSlot.load(std::memory_order_relaxed);
+    // Oldest first, never the latest published frame (readers are on it)
+    const uint32_t first = latest==noSlot ? 0 : (latest+1)%numSlots;
+    for(uint32_t i=0; i<numSlots; ++i){
+        const uint32_t slot = (first+i)%numSlots;
+        if(slot==latest || mapping->slotInUse[slot]) continue;
+        mapping->slotInUse[slot] = true;
+
+        // Odd sequence : readers reject the slot until it's committed
+        std::atomic<uint32_t>& sequence = mapping->slots[slot].sequence;
+        if((sequence.load(std::memory_order_relaxed)&1u)==0){
+            sequence.fetch_add(1, std::memory_order_acq_rel);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        return (int)slot;
+    }
+    return -1;
+}
+
+void ofxBlend2DShmExporter::commitSlot(int slot, unsigned int frameNum, uint64_t timeMicros){
+    SlotHeader& slotHeader = mapping->slots[slot];
+    if((slotHeader.sequence.load(std::memory_order_relaxed)&1u)==0) return; // Already committed
+    slotHeader.frameNum = frameNum;
+    slotHeader.timeMicros = timeMicros;
+    slotHeader.sequence.fetch_add(1, std::memory_order_release);
+
+    Header* header = mapping->header;
+    header->latestSlot.store((uint32_t)slot, std::memory_order_release);
+    header->publishCount.fetch_add(1, std::memory_order_release);
+#if defined(__linux__)
+    // Shared futex (not _PRIVATE) : the waiters are in other processes
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&header->publishCount), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+    publishedFrames++;
+}
+
+void ofxBlend2DShmExporter::releaseSlot(void* impl, void* externalData, void* userData) noexcept {
+    SlotToken* token = static_cast<SlotToken*>(userData);
+    {
+        std::lock_guard<std::mutex> lock(token->mapping->mutex);
+        token->mapping->slotInUse[token->slot] = false;
+    }
+    delete token;
+}
+
+BLImage ofxBlend2DShmExporter::acquireCanvas(int width, int height, BLFormat format){
+    std::lock_guard<std::mutex> lock(mutex);
+    BLImage image;
+    if(!mapping) return image;
+    const Header* header = mapping->header;
+    if((int)header->width!=width || (int)header->height!=height || header->format!=(uint32_t)format){
+        return image;
+    }
+
+    const int slot = reserveSlot();
+    if(slot<0) return image; // All slots busy, the caller uses a regular canvas
+
+    SlotToken* token = new SlotToken{mapping, slot};
+    if(image.create_from_data(width, height, format, mapping->getPixels(slot), header->stride, BL_DATA_ACCESS_RW, &ofxBlend2DShmExporter::releaseSlot, token)!=BL_SUCCESS){
+        releaseSlot(nullptr, nullptr, token);
+        return BLImage();
+    }
+    return image;
+}
+
+bool ofxBlend2DShmExporter::publish(const ofxBlend2DFrame& frame){
+    std::lock_guard<std::mutex> lock(mutex);
+    if(!mapping || !frame.isValid()) return false;
+    const Header* header = mapping->header;
+
+    // Drawn in a slot : commit in place
+    const uint8_t* pixels = frame.getPixels();
+    const uint8_t* slotsBegin = mapping->getPixels(0);
+    const uint8_t* slotsEnd = slotsBegin + header->numSlots*header->slotSize;
+    if(pixels>=slotsBegin && pixels<slotsEnd){
+        commitSlot((int)((pixels-slotsBegin)/header->slotSize), frame.getFrameNum(), frame.getReadyTimeMicros());
+        return true;
+    }
+
+    // Otherwise copy
+    if(frame.getWidth()!=(int)header->width || frame.getHeight()!=(int)header->height || frame.getFormat()!=(BLFormat)header->format){
+        if(!bWarnedFormat){
+            ofLogWarning("ofxBlend2DShmExporter::publish") << "Frame " << frame.getWidth() << "x" << frame.getHeight() << " (format " << frame.getFormat() << ") doesn't match " << name << ", re-open it with the new size. Skipping frames.";
+            bWarnedFormat = true;
+        }
+        return false;
+    }
+    const int slot = reserveSlot();
+    if(slot<0){
+        ofLogVerbose("ofxBlend2DShmExporter::publish") << "No free slot, dropping frame " << frame.getFrameNum();
+        return false;
+    }
+    uint8_t* dst = mapping->getPixels(slot);
+    const std::size_t rowSize = (std::size_t)header->width*getBytesPerPixel((BLFormat)header->format);
+    for(uint32_t y=0; y<header->height; ++y){
+        std::memcpy(dst + y*header->stride, pixels + y*frame.getStride(), rowSize);
+    }
+    commitSlot(slot, frame.getFrameNum(), frame.getReadyTimeMicros());
+    {
+        std::lock_guard<std::mutex> slotLock(mapping->mutex);
+        mapping->slotInUse[slot] = false;
+    }
+    copiedFrames++;
+    return true;
+}
+
+// - - - - ofxBlend2DShmReader
+
+ofxBlend2DShmReader::~ofxBlend2DShmReader(){
+    close();
+}
+
+bool ofxBlend2DShmReader::open(const std::string& name){
+    close();
+#ifdef _WIN32
+    ofLogError("ofxBlend2DShmReader::open") << "Shared memory export needs POSIX shared memory, it's not available on Windows.";
+    return false;
+#else
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if(fd<0){
+        ofLogError("ofxBlend2DShmReader::open") << "Couldn't open " << name << " : " << strerror(errno);
+        return false;
+    }
+    struct stat segmentStat;
+    if(fstat(fd, &segmentStat)!=0 || segmentStat.st_size<(off_t)sizeof(Header)){
+        ofLogError("ofxBlend2DShmReader::open") << name << " is too small to be a frame segment !";
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, segmentStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(mapped==MAP_FAILED){
+        ofLogError("ofxBlend2DShmReader::open") << "Couldn't map " << name << " : " << strerror(errno);
+        return false;
+    }
+    data = static_cast<uint8_t*>(mapped);
+    mappedSize = segmentStat.st_size;
+
+    const Header* candidate = reinterpret_cast<const Header*>(data);
+    const bool isValid =
+        std::memcmp(candidate->magic, magic, sizeof(magic))==0 &&
+        candidate->version==version &&
+        candidate->headerSize==sizeof(Header) &&
+        candidate->slotHeaderSize==sizeof(SlotHeader) &&
+        candidate->totalSize<=mappedSize &&
+        candidate->pixelsOffset>=sizeof(Header)+candidate->numSlots*sizeof(SlotHeader) &&
+        candidate->pixelsOffset+candidate->numSlots*candidate->slotSize<=mappedSize &&
+        (uint64_t)candidate->stride*candidate->height<=candidate->slotSize;
+    if(!isValid){
+        ofLogError("ofxBlend2DShmReader::open") << name << " is not a valid frame segment (or was written by an incompatible version).";
+        close();
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    header = candidate;
+    lastPublishCount = 0;
+    return true;
+#endif
+}
+
+void ofxBlend2DShmReader::close(){
+#ifndef _WIN32
+    if(data) munmap(data, mappedSize);
+#endif
+    data = nullptr;
+    mappedSize = 0;
+    header = nullptr;
+}
+
+const SlotHeader* ofxBlend2DShmReader::getSlotHeader(uint32_t slot) const {
+    return reinterpret_cast<const SlotHeader*>(data + sizeof(Header)) + slot;
+}
+
+uint32_t ofxBlend2DShmReader::getPublishCount() const {
+    return header ? header->publishCount.load(std::memory_order_acquire) : 0;
+}
+
+bool ofxBlend2DShmReader::waitForFrame(int timeoutMs){
+    if(!header) return false;
+    const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now()+std::chrono::milliseconds(timeoutMs);
+    for(;;){
+        const uint32_t count = header->publishCount.load(std::memory_order_acquire);
+        if(count!=lastPublishCount) return true;
+
+        const auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline-std::chrono::steady_clock::now()).count();
+        if(remaining<=0) return false;
+#if defined(__linux__)
+        struct timespec timeout;
+        timeout.tv_sec = remaining/1000000000;
+        timeout.tv_nsec = remaining%1000000000;
+        // Returns immediately if the counter moved meanwhile
+        syscall(SYS_futex, reinterpret_cast<const uint32_t*>(&header->publishCount), FUTEX_WAIT, count, &timeout, nullptr, 0);
+#else
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+    }
+}
+
+bool ofxBlend2DShmReader::getLatest(View& view){
+    if(!header) return false;
+    // Retry if the writer started reusing the slot in between
+    for(int attempt=0; attempt<4; ++attempt){
+        const uint32_t count = header->publishCount.load(std::memory_order_acquire);
+        const uint32_t slot = header->latestSlot.load(std::memory_order_acquire);
+        if(slot==noSlot || slot>=header->numSlots) return false;
+
+        const SlotHeader* slotHeader = getSlotHeader(slot);
+        const uint32_t sequence = slotHeader->sequence.load(std::memory_order_acquire);
+        if(sequence&1u) continue;
+
+        view.pixels = data + header->pixelsOffset + slot*header->slotSize;
+        view.width = header->width;
+        view.height = header->height;
+        view.stride = header->stride;
+        view.format = (BLFormat)header->format;
+        view.frameNum = slotHeader->frameNum;
+        view.timeMicros = slotHeader->timeMicros;
+        view.slot = slot;
+        view.sequence = sequence;
+        if(!isIntact(view)) continue;
+        lastPublishCount = count;
+        return true;
+    }
+    return false;
+}
+
+bool ofxBlend2DShmReader::isIntact(const View& view) const {
+    if(!header || view.slot>=header->numSlots) return false;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return getSlotHeader(view.slot)->sequence.load(std::memory_order_relaxed)==view.sequence;
+}
+
+bool ofxBlend2DShmReader::copyLatest(ofPixels& pixels){
+    for(int attempt=0; attempt<4; ++attempt){
+        View view;
+        if(!getLatest(view)) return false;
+        if(!toOfPixels(view.pixels, view.width, view.height, view.format, view.stride, pixels)) return false;
+        if(isIntact(view)) return true;
+    }
+    ofLogVerbose("ofxBlend2DShmReader::copyLatest") << "The writer kept overwriting the frame, try more slots.";
+    return false;
+}
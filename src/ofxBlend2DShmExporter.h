@@ -0,0 +1,143 @@
+#pragma once
+
+#include "blend2d/blend2d.h"
+#include "ofxBlend2DFrame.h"
+#include "ofPixels.h"
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+
+// Shared memory frame export
+// - - - -
+// Publishes finished frames into a POSIX shared memory ring (shm_open), so other processes on the same machine
+// (projection mapping, recorders, analysis...) receive them without texture readbacks or files.
+// When attached to a renderer (setShmExporter()), the renderer draws directly into the shared slots : publishing is then a header update, no copy.
+// Frames from other sources are copied into the next slot.
+//
+// Layout (native endianness, one writer, any number of readers) :
+// - Header : magic, version, geometry (width, height, stride, BLFormat), slot count, publish counter (futex word), latest slot
+// - SlotHeader[numSlots] : sequence (seqlock : odd while written), frame number, timestamp
+// - Pixels : numSlots page aligned canvases
+// Readers wait on the publish counter (futex on Linux, polling elsewhere), read the latest slot and validate its sequence afterwards.
+// Windows isn't supported (open() fails).
+
+namespace ofxBlend2DShmFormat {
+    constexpr char magic[8] = {'B','L','2','D','S','H','M','F'};
+    constexpr uint32_t version = 1;
+    constexpr uint32_t noSlot = 0xFFFFFFFFu;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;
+        uint32_t slotHeaderSize;
+        uint32_t numSlots;
+        uint32_t width;
+        uint32_t height;
+        int64_t stride;
+        uint32_t format; // BLFormat
+        uint32_t writerPid;
+        uint64_t pixelsOffset; // First slot's pixels
+        uint64_t slotSize; // Bytes between slots
+        uint64_t totalSize;
+        std::atomic<uint32_t> publishCount; // Incremented (and woken) on every published frame
+        std::atomic<uint32_t> latestSlot;
+    };
+
+    struct alignas(64) SlotHeader {
+        std::atomic<uint32_t> sequence; // Even when readable
+        uint32_t frameNum;
+        uint64_t timeMicros; // Writer's ofGetElapsedTimeMicros() when the pixels were ready
+    };
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "Shared atomics must be lock free");
+}
+
+class ofxBlend2DShmExporter {
+    public:
+        ofxBlend2DShmExporter() = default;
+        ~ofxBlend2DShmExporter();
+        ofxBlend2DShmExporter(const ofxBlend2DShmExporter&) = delete;
+        ofxBlend2DShmExporter& operator=(const ofxBlend2DShmExporter&) = delete;
+
+        // Creates (or replaces) the segment, ex: name="/ofxBlend2D". At least 3 slots are recommended.
+        bool open(const std::string& name, int width, int height, BLFormat format=BL_FORMAT_PRGB32, unsigned int numSlots=3);
+        // Unlinks the segment, canvases still in use keep their mapping
+        void close();
+        bool isOpen() const;
+
+        // A canvas backed by a free slot, empty if there's none or the size doesn't match. Thread safe.
+        // The slot is reserved until the image is released.
+        BLImage acquireCanvas(int width, int height, BLFormat format);
+
+        // Publishes the frame : committed in place if it was drawn in a slot, copied otherwise. Thread safe.
+        bool publish(const ofxBlend2DFrame& frame);
+
+        const std::string& getName() const { return name; }
+        uint32_t getPublishedFrames() const { return publishedFrames; }
+        uint32_t getCopiedFrames() const { return copiedFrames; }
+
+    protected:
+        struct Mapping; // Shared with the acquired canvases
+        struct SlotToken;
+        static void releaseSlot(void* impl, void* externalData, void* userData) noexcept;
+
+        // Returns a writable slot not used by a canvas, marked as being written (locked)
+        int reserveSlot();
+        void commitSlot(int slot, unsigned int frameNum, uint64_t timeMicros);
+
+        std::shared_ptr<Mapping> mapping;
+        mutable std::mutex mutex;
+        std::string name;
+        std::atomic<uint32_t> publishedFrames{0};
+        std::atomic<uint32_t> copiedFrames{0};
+        bool bWarnedFormat = false;
+};
+
+// Consumer side, for other processes (or tests)
+class ofxBlend2DShmReader {
+    public:
+        // Zero-copy access to a slot. Check isIntact() after reading the pixels, the writer may have reused the slot meanwhile.
+        struct View {
+            const uint8_t* pixels = nullptr;
+            int width = 0;
+            int height = 0;
+            intptr_t stride = 0;
+            BLFormat format = BL_FORMAT_NONE;
+            unsigned int frameNum = 0;
+            uint64_t timeMicros = 0;
+            uint32_t slot = ofxBlend2DShmFormat::noSlot;
+            uint32_t sequence = 0;
+        };
+
+        ofxBlend2DShmReader() = default;
+        ~ofxBlend2DShmReader();
+        ofxBlend2DShmReader(const ofxBlend2DShmReader&) = delete;
+        ofxBlend2DShmReader& operator=(const ofxBlend2DShmReader&) = delete;
+
+        bool open(const std::string& name);
+        void close();
+        bool isOpen() const { return header!=nullptr; }
+
+        // Blocks until a frame newer than the last one read is published, returns false on timeout
+        bool waitForFrame(int timeoutMs);
+        // The latest published frame, false if there's none yet
+        bool getLatest(View& view);
+        bool isIntact(const View& view) const;
+        // Copies the latest frame (retries when overwritten while copying)
+        bool copyLatest(ofPixels& pixels);
+
+        uint32_t getPublishCount() const;
+
+    protected:
+        const ofxBlend2DShmFormat::SlotHeader* getSlotHeader(uint32_t slot) const;
+
+        uint8_t* data = nullptr;
+        std::size_t mappedSize = 0;
+        const ofxBlend2DShmFormat::Header* header = nullptr;
+        uint32_t lastPublishCount = 0;
+};
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__linux__)
+#   include <linux/futex.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#   include <ctime>
+#   include <climits>
+#endif
+
+// Bounded single-producer / single-consumer queue
+// - - - -
+// A lock-free ring for handing frames between two threads : one thread pushes, one thread pops.
+// Pushing and popping never lock, they're a couple of atomic loads and stores.
+// Blocking pops sleep on an event counter : a futex on Linux, a condition variable elsewhere,
+// which the producer only signals when the consumer is actually waiting.
+// Capacity must be a power of two. T needs to be default constructible and movable, popped slots are left moved-from.
+
+template<typename T, std::size_t Capacity>
+class ofxBlend2DSpscQueue {
+    static_assert(Capacity>=2 && (Capacity&(Capacity-1))==0, "Capacity must be a power of two");
+    static_assert(sizeof(std::atomic<uint32_t>)==sizeof(uint32_t), "The event counter is used as a futex word");
+
+    public:
+        ofxBlend2DSpscQueue() = default;
+        ofxBlend2DSpscQueue(const ofxBlend2DSpscQueue&) = delete;
+        ofxBlend2DSpscQueue& operator=(const ofxBlend2DSpscQueue&) = delete;
+
+        // Producer side. Returns false if the queue is full or closed.
+        bool tryPush(T&& value){
+            if(closed.load(std::memory_order_acquire)) return false;
+            const std::size_t t = tail.load(std::memory_order_relaxed);
+            if(t-head.load(std::memory_order_acquire)==Capacity) return false;
+            slots[t&(Capacity-1)] = std::move(value);
+            tail.store(t+1, std::memory_order_release);
+            signal();
+            return true;
+        }
+
+        // Consumer side. Returns false if the queue is empty.
+        bool tryPop(T& out){
+            const std::size_t h = head.load(std::memory_order_relaxed);
+            if(h==tail.load(std::memory_order_acquire)) return false;
+            out = std::move(slots[h&(Capacity-1)]);
+            head.store(h+1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side, blocks until a value arrives or the queue is closed (then returns false).
+        bool pop(T& out){
+            return popUntil(out, nullptr);
+        }
+
+        // Same, giving up after timeout
+        bool pop(T& out, std::chrono::milliseconds timeout){
+            const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now()+timeout;
+            return popUntil(out, &deadline);
+        }
+
+        // Wakes up and rejects the consumer and producer. Values still queued can be popped with tryPop().
+        void close(){
+            closed.store(true, std::memory_order_seq_cst);
+            sequence.fetch_add(1, std::memory_order_seq_cst);
+            wake();
+        }
+        bool isClosed() const {
+            return closed.load(std::memory_order_acquire);
+        }
+
+        // Approximate when called from a third thread
+        bool empty() const {
+            return head.load(std::memory_order_acquire)==tail.load(std::memory_order_acquire);
+        }
+        std::size_t size() const {
+            return tail.load(std::memory_order_acquire)-head.load(std::memory_order_acquire);
+        }
+        static constexpr std::size_t capacity() {
+            return Capacity;
+        }
+
+    protected:
+        bool popUntil(T& out, const std::chrono::steady_clock::time_point* deadline){
+            for(;;){
+                if(tryPop(out)) return true;
+                if(closed.load(std::memory_order_acquire)) return false;
+
+                // Register as waiter, then check again : a push between both is either seen here or signals us
+                const uint32_t key = sequence.load(std::memory_order_seq_cst);
+                waiters.fetch_add(1, std::memory_order_seq_cst);
+                if(tryPop(out)){
+                    waiters.fetch_sub(1, std::memory_order_seq_cst);
+                    return true;
+                }
+                const bool timedOut = !wait(key, deadline);
+                waiters.fetch_sub(1, std::memory_order_seq_cst);
+                if(timedOut) return tryPop(out);
+            }
+        }
+
+        void signal(){
+            sequence.fetch_add(1, std::memory_order_seq_cst);
+            if(waiters.load(std::memory_order_seq_cst)>0) wake();
+        }
+
+#if defined(__linux__)
+        // Returns false on timeout
+        bool wait(uint32_t key, const std::chrono::steady_clock::time_point* deadline){
+            struct timespec timeout;
+            struct timespec* timeoutPtr = nullptr;
+            if(deadline!=nullptr){
+                const auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(*deadline-std::chrono::steady_clock::now()).count();
+                if(remaining<=0) return false;
+                timeout.tv_sec = remaining/1000000000;
+                timeout.tv_nsec = remaining%1000000000;
+                timeoutPtr = &timeout;
+            }
+            // Returns immediately if the sequence moved since key (EAGAIN)
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&sequence), FUTEX_WAIT_PRIVATE, key, timeoutPtr, nullptr, 0);
+            return deadline==nullptr || std::chrono::steady_clock::now()<*deadline;
+        }
+        void wake(){
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&sequence), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+        }
+#else
+        // Parking : the mutex is only used while somebody waits
+        bool wait(uint32_t key, const std::chrono::steady_clock::time_point* deadline){
+            std::unique_lock<std::mutex> lock(parkMutex);
+            auto changed = [this, key](){ return sequence.load(std::memory_order_seq_cst)!=key; };
+            if(deadline==nullptr){
+                parkCondition.wait(lock, changed);
+                return true;
+            }
+            return parkCondition.wait_until(lock, *deadline, changed);
+        }
+        void wake(){
+            { std::lock_guard<std::mutex> lock(parkMutex); }
+            parkCondition.notify_all();
+        }
+        std::mutex parkMutex;
+        std::condition_variable parkCondition;
+#endif
+
+        // Indexes grow forever (wrapping is fine), on separate cache lines to avoid false sharing
+        alignas(64) std::atomic<std::size_t> head{0}; // Written by the consumer
+        alignas(64) std::atomic<std::size_t> tail{0}; // Written by the producer
+        alignas(64) std::atomic<uint32_t> sequence{0}; // Event counter, bumped on push and close
+        std::atomic<uint32_t> waiters{0};
+        std::atomic<bool> closed{false};
+        std::array<T, Capacity> slots;
+};
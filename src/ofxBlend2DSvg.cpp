@@ -0,0 +1,1002 @@
+#include "ofxBlend2DSvg.h"
+#include "ofLog.h"
+#include "ofUtils.h"
+#include "ofFileUtils.h" // ofToDataPath
+#include "ofMath.h"
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+// Lexing helpers
+// - - - -
+namespace {
+    inline bool isSpace(char c){
+        return c==' ' || c=='\t' || c=='\n' || c=='\r';
+    }
+    inline bool isDigit(char c){
+        return c>='0' && c<='9';
+    }
+    inline bool isAlpha(char c){
+        return (c>='a' && c<='z') || (c>='A' && c<='Z');
+    }
+    inline void skipSpaces(const char*& p, const char* end){
+        while(p<end && isSpace(*p)) ++p;
+    }
+    inline void skipSeparators(const char*& p, const char* end){
+        while(p<end && (isSpace(*p) || *p==',')) ++p;
+    }
+    std::string trim(const std::string& s){
+        std::size_t b = 0, e = s.size();
+        while(b<e && isSpace(s[b])) ++b;
+        while(e>b && isSpace(s[e-1])) --e;
+        return s.substr(b, e-b);
+    }
+    inline double degToRad(double deg){
+        return deg*3.14159265358979323846/180.0;
+    }
+
+    // Locale independent number parser (strtod depends on the C locale and is slow on big files)
+    bool parseNumber(const char*& p, const char* end, double& out){
+        const char* s = p;
+        if(s>=end) return false;
+        bool negative = false;
+        if(*s=='+' || *s=='-'){
+            negative = (*s=='-');
+            ++s;
+        }
+        uint64_t mantissa = 0;
+        int exponent = 0;
+        int numDigits = 0; // Significant ones, leading zeros don't use the 18 digits mantissa
+        bool hasDigits = false;
+        while(s<end && isDigit(*s)){
+            hasDigits = true;
+            if(numDigits==0 && *s=='0'){ ++s; continue; }
+            if(numDigits<18) mantissa = mantissa*10u + uint64_t(*s-'0');
+            else exponent++;
+            ++numDigits; ++s;
+        }
+        if(s<end && *s=='.'){
+            ++s;
+            while(s<end && isDigit(*s)){
+                hasDigits = true;
+                if(numDigits==0 && *s=='0'){
+                    exponent--;
+                    ++s;
+                    continue;
+                }
+                if(numDigits<18){
+                    mantissa = mantissa*10u + uint64_t(*s-'0');
+                    exponent--;
+                }
+                ++numDigits; ++s;
+            }
+        }
+        if(!hasDigits) return false;
+        // Exponent, only if followed by digits ("1em" is a unit)
+        if(s<end && (*s=='e' || *s=='E')){
+            const char* e = s+1;
+            bool expNegative = false;
+            if(e<end && (*e=='+' || *e=='-')){
+                expNegative = (*e=='-');
+                ++e;
+            }
+            if(e<end && isDigit(*e)){
+                int expValue = 0;
+                while(e<end && isDigit(*e)){
+                    if(expValue<10000) expValue = expValue*10 + (*e-'0');
+                    ++e;
+                }
+                exponent += expNegative ? -expValue : expValue;
+                s = e;
+            }
+        }
+        double value = double(mantissa);
+        if(exponent!=0) value *= std::pow(10.0, exponent);
+        out = negative ? -value : value;
+        p = s;
+        return true;
+    }
+
+    // Arc flags can be written without separators ("a1 1 0 00 1 1")
+    bool parseFlag(const char*& p, const char* end, bool& out){
+        skipSeparators(p, end);
+        if(p<end && (*p=='0' || *p=='1')){
+            out = (*p=='1');
+            ++p;
+            return true;
+        }
+        return false;
+    }
+
+    // Number with optional unit, converted to user units (px)
+    double parseLength(const std::string& value, double fallback=0.0){
+        const char* p = value.c_str();
+        const char* end = p+value.size();
+        skipSpaces(p, end);
+        double ret;
+        if(!parseNumber(p, end, ret)) return fallback;
+        if(end-p>=2){
+            if(std::strncmp(p, "pt", 2)==0) ret *= 96.0/72.0;
+            else if(std::strncmp(p, "pc", 2)==0) ret *= 16.0;
+            else if(std::strncmp(p, "mm", 2)==0) ret *= 96.0/25.4;
+            else if(std::strncmp(p, "cm", 2)==0) ret *= 96.0/2.54;
+            else if(std::strncmp(p, "in", 2)==0) ret *= 96.0;
+        }
+        return ret;
+    }
+
+    void parseNumberList(const std::string& value, std::vector<double>& out){
+        const char* p = value.c_str();
+        const char* end = p+value.size();
+        double v;
+        while(true){
+            skipSeparators(p, end);
+            if(!parseNumber(p, end, v)) break;
+            out.push_back(v);
+        }
+    }
+
+    bool isIdentity(const BLMatrix2D& m){
+        return m.m00==1.0 && m.m01==0.0 && m.m10==0.0 && m.m11==1.0 && m.m20==0.0 && m.m21==0.0;
+    }
+
+    void logUnsupportedOnce(std::atomic<bool>& flag, const char* what){
+        if(!flag.exchange(true)){
+            ofLogNotice("ofxBlend2DSvgLoader") << what << " is not supported, skipping it.";
+        }
+    }
+    std::atomic<bool> loggedPaintServer(false), loggedText(false), loggedUse(false), loggedStyleSheet(false);
+
+    // Inherited presentation state, immutable once pushed (shared between pending elements)
+    struct SvgState {
+        BLMatrix2D transform = BLMatrix2D::make_identity();
+        bool fillNone = false;
+        ofFloatColor fill = ofFloatColor::black;
+        float fillOpacity = 1.f;
+        BLFillRule fillRule = BL_FILL_RULE_NON_ZERO;
+        bool strokeNone = true;
+        ofFloatColor stroke = ofFloatColor::black;
+        float strokeOpacity = 1.f;
+        double strokeWidth = 1.0;
+        BLStrokeJoin strokeJoin = BL_STROKE_JOIN_MITER_BEVEL; // SVG miter falls back to bevel
+        BLStrokeCap strokeCap = BL_STROKE_CAP_BUTT;
+        double miterLimit = 4.0;
+        float opacity = 1.f; // Product of the ancestors' opacity : group opacity is folded into children (approximation)
+        float ownOpacity = 1.f; // Element's own opacity, set once (style replaces the attribute), multiplied when resolved
+        bool visible = true;
+        bool display = true;
+        BLCompOp compOp = BL_COMP_OP_SRC_OVER;
+    };
+
+    float parseOpacity(const std::string& value){
+        double v = parseLength(value, 1.0);
+        if(!value.empty() && value.back()=='%') v *= 0.01;
+        return float(std::min(1.0, std::max(0.0, v)));
+    }
+
+    BLCompOp parseBlendMode(const std::string& value){
+        static const std::pair<const char*, BLCompOp> modes[] = {
+            {"normal", BL_COMP_OP_SRC_OVER}, {"multiply", BL_COMP_OP_MULTIPLY}, {"screen", BL_COMP_OP_SCREEN},
+            {"overlay", BL_COMP_OP_OVERLAY}, {"darken", BL_COMP_OP_DARKEN}, {"lighten", BL_COMP_OP_LIGHTEN},
+            {"color-dodge", BL_COMP_OP_COLOR_DODGE}, {"color-burn", BL_COMP_OP_COLOR_BURN}, {"hard-light", BL_COMP_OP_HARD_LIGHT},
+            {"soft-light", BL_COMP_OP_SOFT_LIGHT}, {"difference", BL_COMP_OP_DIFFERENCE}, {"exclusion", BL_COMP_OP_EXCLUSION},
+            {"plus-lighter", BL_COMP_OP_PLUS},
+        };
+        for(const auto& mode : modes){
+            if(value==mode.first) return mode.second;
+        }
+        return BL_COMP_OP_SRC_OVER;
+    }
+
+    // Applies a presentation attribute or CSS declaration. Unknown names are ignored (geometry attributes pass trough here too).
+    void applyProperty(SvgState& state, const std::string& name, const std::string& rawValue){
+        if(name.empty() || name=="d" || name=="points") return; // Skip copying big geometry attributes
+        const std::string value = trim(rawValue);
+        if(value=="inherit") return;
+
+        if(name=="fill"){
+            if(value.compare(0, 4, "url(")==0) logUnsupportedOnce(loggedPaintServer, "Gradient/pattern paint");
+            state.fillNone = !ofxBlend2DSvgLoader::parseColor(value, state.fill);
+        }
+        else if(name=="stroke"){
+            if(value.compare(0, 4, "url(")==0) logUnsupportedOnce(loggedPaintServer, "Gradient/pattern paint");
+            state.strokeNone = !ofxBlend2DSvgLoader::parseColor(value, state.stroke);
+        }
+        else if(name=="fill-opacity") state.fillOpacity = parseOpacity(value);
+        else if(name=="stroke-opacity") state.strokeOpacity = parseOpacity(value);
+        else if(name=="opacity") state.ownOpacity = parseOpacity(value);
+        else if(name=="fill-rule") state.fillRule = (value=="evenodd") ? BL_FILL_RULE_EVEN_ODD : BL_FILL_RULE_NON_ZERO;
+        else if(name=="stroke-width") state.strokeWidth = std::max(0.0, parseLength(value, 1.0));
+        else if(name=="stroke-miterlimit") state.miterLimit = std::max(1.0, parseLength(value, 4.0));
+        else if(name=="stroke-linejoin"){
+            if(value=="round") state.strokeJoin = BL_STROKE_JOIN_ROUND;
+            else if(value=="bevel") state.strokeJoin = BL_STROKE_JOIN_BEVEL;
+            else if(value=="miter-clip") state.strokeJoin = BL_STROKE_JOIN_MITER_CLIP;
+            else state.strokeJoin = BL_STROKE_JOIN_MITER_BEVEL;
+        }
+        else if(name=="stroke-linecap"){
+            if(value=="round") state.strokeCap = BL_STROKE_CAP_ROUND;
+            else if(value=="square") state.strokeCap = BL_STROKE_CAP_SQUARE;
+            else state.strokeCap = BL_STROKE_CAP_BUTT;
+        }
+        else if(name=="display") state.display = (value!="none");
+        else if(name=="visibility") state.visible = (value=="visible");
+        else if(name=="mix-blend-mode") state.compOp = parseBlendMode(value);
+    }
+
+    // Inline style="a:b; c:d"
+    void applyStyleAttribute(SvgState& state, const std::string& style){
+        std::size_t pos = 0;
+        while(pos<style.size()){
+            std::size_t semi = style.find(';', pos);
+            if(semi==std::string::npos) semi = style.size();
+            std::size_t colon = style.find(':', pos);
+            if(colon!=std::string::npos && colon<semi){
+                applyProperty(state, trim(style.substr(pos, colon-pos)), style.substr(colon+1, semi-colon-1));
+            }
+            pos = semi+1;
+        }
+    }
+
+    enum class SvgElementType : uint8_t {
+        Path, Rect, Circle, Ellipse, Line, Polyline, Polygon
+    };
+    const char* svgElementTypeNames[] = {"path", "rect", "circle", "ellipse", "line", "polyline", "polygon"};
+
+    using SvgAttributes = std::vector<std::pair<std::string, std::string> >;
+
+    struct SvgPendingElement {
+        SvgElementType type;
+        SvgAttributes attributes;
+        std::shared_ptr<const SvgState> parent;
+    };
+
+    const std::string* findAttribute(const SvgAttributes& attributes, const char* name){
+        for(const auto& attr : attributes){
+            if(attr.first==name) return &attr.second;
+        }
+        return nullptr;
+    }
+    double getLengthAttribute(const SvgAttributes& attributes, const char* name, double fallback=0.0){
+        const std::string* value = findAttribute(attributes, name);
+        return value ? parseLength(*value, fallback) : fallback;
+    }
+
+    void appendUtf8(std::string& out, uint32_t code){
+        if(code<0x80) out.push_back(char(code));
+        else if(code<0x800){
+            out.push_back(char(0xC0 | (code>>6)));
+            out.push_back(char(0x80 | (code & 0x3F)));
+        }
+        else if(code<0x10000){
+            out.push_back(char(0xE0 | (code>>12)));
+            out.push_back(char(0x80 | ((code>>6) & 0x3F)));
+            out.push_back(char(0x80 | (code & 0x3F)));
+        }
+        else {
+            out.push_back(char(0xF0 | (code>>18)));
+            out.push_back(char(0x80 | ((code>>12) & 0x3F)));
+            out.push_back(char(0x80 | ((code>>6) & 0x3F)));
+            out.push_back(char(0x80 | (code & 0x3F)));
+        }
+    }
+
+    // Predefined XML entities and numeric character references (as UTF-8)
+    void decodeEntities(std::string& s){
+        if(s.find('&')==std::string::npos) return;
+        static const std::pair<const char*, char> entities[] = {
+            {"&amp;", '&'}, {"&lt;", '<'}, {"&gt;", '>'}, {"&quot;", '"'}, {"&apos;", '\''},
+        };
+        std::string ret;
+        ret.reserve(s.size());
+        for(std::size_t i=0; i<s.size(); ++i){
+            bool replaced = false;
+            if(s[i]=='&' && i+1<s.size() && s[i+1]=='#'){
+                // Numeric character reference : &#65; or &#x41;
+                const bool bHex = i+2<s.size() && (s[i+2]=='x' || s[i+2]=='X');
+                const std::size_t digits = i+(bHex ? 3 : 2);
+                const std::size_t semi = s.find(';', digits);
+                if(semi!=std::string::npos && semi>digits && semi-digits<=8){
+                    char* parseEnd = nullptr;
+                    const unsigned long code = std::strtoul(s.c_str()+digits, &parseEnd, bHex ? 16 : 10);
+                    if(parseEnd==s.c_str()+semi && code>0 && code<=0x10FFFF){
+                        appendUtf8(ret, uint32_t(code));
+                        i = semi;
+                        replaced = true;
+                    }
+                }
+            }
+            else if(s[i]=='&'){
+                for(const auto& entity : entities){
+                    const std::size_t len = std::strlen(entity.first);
+                    if(s.compare(i, len, entity.first)==0){
+                        ret.push_back(entity.second);
+                        i += len-1;
+                        replaced = true;
+                        break;
+                    }
+                }
+            }
+            if(!replaced) ret.push_back(s[i]);
+        }
+        s.swap(ret);
+    }
+
+    // Builds an element into a shape. Runs on worker threads : must only touch its own data.
+    bool parseSvgElement(const SvgPendingElement& element, ofxBlend2DSvgShape& out){
+        SvgState state = *element.parent;
+        const std::string* transformAttr = nullptr;
+        const std::string* styleAttr = nullptr;
+        for(const auto& attr : element.attributes){
+            if(attr.first=="transform") transformAttr = &attr.second;
+            else if(attr.first=="style") styleAttr = &attr.second;
+            else if(attr.first=="id") out.id = attr.second;
+            else applyProperty(state, attr.first, attr.second);
+        }
+        // Inline style has precedence over presentation attributes
+        if(styleAttr) applyStyleAttribute(state, *styleAttr);
+        if(!state.display) return false;
+
+        const SvgAttributes& attrs = element.attributes;
+        BLPath& path = out.path;
+        switch(element.type){
+            case SvgElementType::Path : {
+                const std::string* d = findAttribute(attrs, "d");
+                if(d==nullptr) return false;
+                if(!ofxBlend2DSvgLoader::parsePathData(*d, path)){
+                    // Per spec, render up to the error
+                    ofLogVerbose("ofxBlend2DSvgLoader") << "Malformed path data in element " << out.id;
+                }
+                break;
+            }
+            case SvgElementType::Rect : {
+                const double x = getLengthAttribute(attrs, "x");
+                const double y = getLengthAttribute(attrs, "y");
+                const double w = getLengthAttribute(attrs, "width");
+                const double h = getLengthAttribute(attrs, "height");
+                if(w<=0 || h<=0) return false;
+                double rx = getLengthAttribute(attrs, "rx", -1);
+                double ry = getLengthAttribute(attrs, "ry", -1);
+                if(rx<0) rx = ry;
+                if(ry<0) ry = rx;
+                rx = std::min(std::max(rx, 0.0), w*0.5);
+                ry = std::min(std::max(ry, 0.0), h*0.5);
+                if(rx>0 && ry>0) path.add_round_rect(BLRoundRect(x, y, w, h, rx, ry));
+                else path.add_rect(BLRect(x, y, w, h));
+                break;
+            }
+            case SvgElementType::Circle : {
+                const double r = getLengthAttribute(attrs, "r");
+                if(r<=0) return false;
+                path.add_circle(BLCircle(getLengthAttribute(attrs, "cx"), getLengthAttribute(attrs, "cy"), r));
+                break;
+            }
+            case SvgElementType::Ellipse : {
+                const double rx = getLengthAttribute(attrs, "rx");
+                const double ry = getLengthAttribute(attrs, "ry");
+                if(rx<=0 || ry<=0) return false;
+                path.add_ellipse(BLEllipse(getLengthAttribute(attrs, "cx"), getLengthAttribute(attrs, "cy"), rx, ry));
+                break;
+            }
+            case SvgElementType::Line : {
+                path.move_to(getLengthAttribute(attrs, "x1"), getLengthAttribute(attrs, "y1"));
+                path.line_to(getLengthAttribute(attrs, "x2"), getLengthAttribute(attrs, "y2"));
+                state.fillNone = true; // Lines have no area
+                break;
+            }
+            case SvgElementType::Polyline :
+            case SvgElementType::Polygon : {
+                const std::string* points = findAttribute(attrs, "points");
+                if(points==nullptr) return false;
+                std::vector<double> coords;
+                parseNumberList(*points, coords);
+                if(coords.size()<4) return false;
+                path.move_to(coords[0], coords[1]);
+                for(std::size_t i=2; i+1<coords.size(); i+=2){
+                    path.line_to(coords[i], coords[i+1]);
+                }
+                if(element.type==SvgElementType::Polygon) path.close();
+                break;
+            }
+        }
+        if(path.is_empty()) return false;
+
+        // Element transform applies first, then the inherited one
+        BLMatrix2D transform = state.transform;
+        if(transformAttr) transform.transform(ofxBlend2DSvgLoader::parseTransform(*transformAttr));
+        double strokeScale = 1.0;
+        if(!isIdentity(transform)){
+            path.transform(transform);
+            strokeScale = std::sqrt(std::abs(transform.m00*transform.m11 - transform.m01*transform.m10));
+        }
+        path.shrink();
+
+        ofxBlend2DPathStyle& style = out.style;
+        style.isVisible = state.visible;
+        style.isFilled = !state.fillNone;
+        style.fillColor = state.fill;
+        style.fillColor.a *= state.fillOpacity;
+        style.fillRule = state.fillRule;
+        style.hasStroke = !state.strokeNone;
+        style.strokeWidth = float(state.strokeWidth*strokeScale);
+        style.strokeColor = state.stroke;
+        style.strokeColor.a *= state.strokeOpacity;
+        style.strokeJoin = state.strokeJoin;
+        style.strokeCap = state.strokeCap;
+        style.miterLimit = float(state.miterLimit);
+        style.opacity = state.opacity*state.ownOpacity;
+        style.compOp = state.compOp;
+
+        out.type = svgElementTypeNames[int(element.type)];
+        return true;
+    }
+}
+
+// Streaming parser
+// - - - -
+class ofxBlend2DSvgLoader::Parser {
+    public:
+        Parser(ofxBlend2DSvgLoader& _loader, const ShapeCallback& _onShape) :
+            loader(_loader),
+            onShape(_onShape)
+        {
+            numThreads = loader.settings.numThreads;
+            if(numThreads==0) numThreads = std::max(1u, std::thread::hardware_concurrency());
+            batchSize = std::max<std::size_t>(1u, loader.settings.batchSize);
+            stateStack.push_back(std::make_shared<const SvgState>());
+            pending.reserve(batchSize);
+        }
+        ~Parser(){
+            // Never leave a batch running on our members
+            if(bInFlight) loader.pool.wait();
+        }
+
+        // Handles complete tags in buffer starting at pos. Returns where parsing stopped (start of an incomplete tag).
+        // The next call must start at that tag (pos) with more data appended : its scan resumes where this one stopped,
+        // so a huge attribute spanning many chunks isn't rescanned from its start each time.
+        std::size_t processBuffer(const std::string& buffer, std::size_t pos){
+            while(true){
+                const std::size_t lt = buffer.find('<', pos);
+                if(lt==std::string::npos) return buffer.size();
+                // Already scanned part of this tag
+                const std::size_t scanned = (lt==pos) ? resumeScanned : 0;
+                const char resumedQuote = (lt==pos) ? resumeQuote : 0;
+                resumeScanned = 0;
+                resumeQuote = 0;
+
+                // Markup to skip
+                std::size_t skipEnd = std::string::npos;
+                std::size_t skipFrom = 0;
+                const char* terminator = nullptr;
+                if(buffer.compare(lt, 4, "<!--")==0){ skipFrom = lt+4; terminator = "-->"; }
+                else if(buffer.compare(lt, 9, "<![CDATA[")==0){ skipFrom = lt+9; terminator = "]]>"; }
+                else if(buffer.compare(lt, 2, "<?")==0){ skipFrom = lt+2; terminator = "?>"; }
+                else if(buffer.compare(lt, 2, "<!")==0){ skipFrom = lt+2; terminator = ">"; }
+                if(terminator!=nullptr){
+                    // The terminator may straddle the previous end
+                    const std::size_t terminatorSize = std::strlen(terminator);
+                    if(scanned>terminatorSize) skipFrom = std::max(skipFrom, lt+scanned-terminatorSize);
+                    skipEnd = findEnd(buffer, skipFrom, terminator);
+                    if(skipEnd==std::string::npos){
+                        // Need more data
+                        resumeScanned = buffer.size()-lt;
+                        return lt;
+                    }
+                    pos = skipEnd;
+                    continue;
+                }
+
+                // Regular tag : find '>' outside quotes
+                char quote = resumedQuote;
+                std::size_t gt = std::max(lt+1, lt+scanned);
+                for(; gt<buffer.size(); ++gt){
+                    const char c = buffer[gt];
+                    if(quote){
+                        if(c==quote) quote = 0;
+                    }
+                    else if(c=='"' || c=='\'') quote = c;
+                    else if(c=='>') break;
+                }
+                if(gt>=buffer.size()){
+                    // Need more data
+                    resumeScanned = gt-lt;
+                    resumeQuote = quote;
+                    return lt;
+                }
+                handleTag(buffer.data()+lt+1, buffer.data()+gt);
+                pos = gt+1;
+            }
+        }
+
+        void finish(){
+            dispatchBatch();
+            finishInFlight();
+        }
+
+    protected:
+        static std::size_t findEnd(const std::string& buffer, std::size_t from, const char* terminator){
+            const std::size_t found = buffer.find(terminator, from);
+            return (found==std::string::npos) ? found : found+std::strlen(terminator);
+        }
+
+        void handleTag(const char* p, const char* end){
+            const bool isEndTag = (p<end && *p=='/');
+            if(isEndTag) ++p;
+            const bool isSelfClosing = (end>p && *(end-1)=='/');
+            if(isSelfClosing) --end;
+
+            // Name, without namespace prefix
+            const char* nameStart = p;
+            while(p<end && !isSpace(*p)) ++p;
+            std::string name(nameStart, p);
+            const std::size_t colon = name.find(':');
+            if(colon!=std::string::npos) name.erase(0, colon+1);
+
+            // Skipped subtrees (defs, text, etc.)
+            if(skipDepth>0){
+                if(isEndTag) skipDepth--;
+                else if(!isSelfClosing) skipDepth++;
+                return;
+            }
+
+            if(isEndTag){
+                if(isContainer(name) && stateStack.size()>1) stateStack.pop_back();
+                return;
+            }
+
+            if(isSkippedSubtree(name)){
+                if(name=="text"){
+                    logUnsupportedOnce(loggedText, "SVG text");
+                    loader.numSkipped++;
+                }
+                else if(name=="style") logUnsupportedOnce(loggedStyleSheet, "CSS stylesheet");
+                if(!isSelfClosing) skipDepth = 1;
+                return;
+            }
+            if(name=="use"){
+                logUnsupportedOnce(loggedUse, "SVG use element");
+                loader.numSkipped++;
+                return;
+            }
+
+            SvgElementType type;
+            const bool isShape = getShapeType(name, type);
+            const bool container = isContainer(name);
+            if(!isShape && !container) return; // Unknown/unsupported elements are ignored (their children are still parsed)
+
+            SvgAttributes attributes;
+            parseAttributes(p, end, attributes);
+
+            if(isShape){
+                loader.numElements++;
+                pending.push_back({type, std::move(attributes), stateStack.back()});
+                if(pending.size()>=batchSize) dispatchBatch();
+                return;
+            }
+
+            // Containers : resolve their state now, it's shared by all children
+            auto state = std::make_shared<SvgState>(*stateStack.back());
+            if(name=="svg"){
+                handleSvgElement(attributes, *state);
+            }
+            const std::string* styleAttr = nullptr;
+            for(const auto& attr : attributes){
+                if(attr.first=="transform") state->transform.transform(ofxBlend2DSvgLoader::parseTransform(attr.second));
+                else if(attr.first=="style") styleAttr = &attr.second;
+                else applyProperty(*state, attr.first, attr.second);
+            }
+            if(styleAttr) applyStyleAttribute(*state, *styleAttr);
+            state->opacity *= state->ownOpacity;
+            state->ownOpacity = 1.f;
+
+            if(!state->display){
+                if(!isSelfClosing) skipDepth = 1;
+                return;
+            }
+            if(!isSelfClosing) stateStack.push_back(std::move(state));
+        }
+
+        void handleSvgElement(const SvgAttributes& attributes, SvgState& state){
+            if(bRootParsed){
+                // Nested svg : only honour its position
+                state.transform.translate(getLengthAttribute(attributes, "x"), getLengthAttribute(attributes, "y"));
+                return;
+            }
+            bRootParsed = true;
+
+            std::vector<double> viewBox;
+            if(const std::string* vb = findAttribute(attributes, "viewBox")){
+                parseNumberList(*vb, viewBox);
+            }
+            const bool hasViewBox = viewBox.size()==4 && viewBox[2]>0 && viewBox[3]>0;
+            double width = getLengthAttribute(attributes, "width", hasViewBox ? viewBox[2] : 0);
+            double height = getLengthAttribute(attributes, "height", hasViewBox ? viewBox[3] : 0);
+            loader.documentSize = BLSize(width, height);
+
+            // viewBox with the default preserveAspectRatio (xMidYMid meet)
+            if(hasViewBox && width>0 && height>0){
+                const double scale = std::min(width/viewBox[2], height/viewBox[3]);
+                state.transform.translate((width-viewBox[2]*scale)*0.5, (height-viewBox[3]*scale)*0.5);
+                state.transform.scale(scale, scale);
+                state.transform.translate(-viewBox[0], -viewBox[1]);
+            }
+        }
+
+        static void parseAttributes(const char* p, const char* end, SvgAttributes& out){
+            while(p<end){
+                skipSpaces(p, end);
+                const char* nameStart = p;
+                while(p<end && *p!='=' && !isSpace(*p)) ++p;
+                std::string name(nameStart, p);
+                skipSpaces(p, end);
+                if(p>=end || *p!='='){
+                    if(p<end && name.empty()) ++p; // Garbage, avoid an infinite loop
+                    continue;
+                }
+                ++p;
+                skipSpaces(p, end);
+                if(p>=end) break;
+                const char quote = *p;
+                if(quote!='"' && quote!='\'') continue;
+                ++p;
+                const char* valueStart = p;
+                while(p<end && *p!=quote) ++p;
+                std::string value(valueStart, p);
+                if(p<end) ++p;
+                decodeEntities(value);
+                out.emplace_back(std::move(name), std::move(value));
+            }
+        }
+
+        static bool isContainer(const std::string& name){
+            return name=="g" || name=="svg" || name=="a" || name=="switch";
+        }
+        static bool isSkippedSubtree(const std::string& name){
+            static const char* names[] = {
+                "defs", "symbol", "clipPath", "mask", "pattern", "marker", "linearGradient", "radialGradient",
+                "filter", "style", "script", "text", "metadata", "title", "desc", "foreignObject",
+            };
+            for(const char* n : names){
+                if(name==n) return true;
+            }
+            return false;
+        }
+        static bool getShapeType(const std::string& name, SvgElementType& type){
+            for(int i=0; i<int(sizeof(svgElementTypeNames)/sizeof(svgElementTypeNames[0])); ++i){
+                if(name==svgElementTypeNames[i]){
+                    type = SvgElementType(i);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Batches : parse the previous batch in parallel while the next one is being scanned
+        void dispatchBatch(){
+            finishInFlight();
+            if(pending.empty()) return;
+            inFlightBatch.swap(pending);
+            pending.clear();
+            const std::size_t n = inFlightBatch.size();
+            inFlightShapes.clear();
+            inFlightShapes.resize(n);
+            inFlightValid.assign(n, 0);
+            // The pool's workers parse while this thread scans, it joins them in finishInFlight()
+            const unsigned int numWorkers = unsigned(std::min<std::size_t>(numThreads, (n+63)/64));
+            loader.pool.start(n, [this](std::size_t i){
+                inFlightValid[i] = parseSvgElement(inFlightBatch[i], inFlightShapes[i]) ? 1 : 0;
+            }, numWorkers+1);
+            bInFlight = true;
+        }
+
+        void finishInFlight(){
+            if(!bInFlight) return;
+            loader.pool.wait();
+            bInFlight = false;
+            for(std::size_t i=0; i<inFlightShapes.size(); ++i){
+                if(inFlightValid[i]) onShape(std::move(inFlightShapes[i]));
+                else loader.numSkipped++;
+            }
+            inFlightShapes.clear();
+            inFlightBatch.clear();
+        }
+
+        ofxBlend2DSvgLoader& loader;
+        const ShapeCallback& onShape;
+        unsigned int numThreads = 1;
+        std::size_t batchSize = 512;
+
+        // Scan state of the incomplete tag processBuffer() stopped at
+        std::size_t resumeScanned = 0;
+        char resumeQuote = 0;
+
+        std::vector<std::shared_ptr<const SvgState> > stateStack;
+        unsigned int skipDepth = 0;
+        bool bRootParsed = false;
+
+        std::vector<SvgPendingElement> pending;
+        std::vector<SvgPendingElement> inFlightBatch;
+        std::vector<ofxBlend2DSvgShape> inFlightShapes;
+        std::vector<uint8_t> inFlightValid;
+        bool bInFlight = false;
+};
+
+// Loader
+// - - - -
+void ofxBlend2DSvgLoader::clear(){
+    shapes.clear();
+    documentSize = BLSize(0, 0);
+    numElements = 0;
+    numSkipped = 0;
+    loadTimeMs = 0.f;
+}
+
+bool ofxBlend2DSvgLoader::load(const std::string& filePath){
+    shapes.clear();
+    return load(filePath, [this](ofxBlend2DSvgShape&& shape){
+        shapes.push_back(std::move(shape));
+    });
+}
+
+bool ofxBlend2DSvgLoader::load(const std::string& filePath, const ShapeCallback& onShape){
+    std::ifstream file(ofToDataPath(filePath), std::ios::binary);
+    if(!file.is_open()){
+        ofLogError("ofxBlend2DSvgLoader::load") << "Couldn't open " << filePath;
+        return false;
+    }
+    return parseStream(file, onShape);
+}
+
+bool ofxBlend2DSvgLoader::loadFromString(const std::string& svgData){
+    shapes.clear();
+    std::istringstream stream(svgData);
+    return parseStream(stream, [this](ofxBlend2DSvgShape&& shape){
+        shapes.push_back(std::move(shape));
+    });
+}
+
+bool ofxBlend2DSvgLoader::parseStream(std::istream& stream, const ShapeCallback& onShape){
+    const auto startTime = std::chrono::steady_clock::now();
+    documentSize = BLSize(0, 0);
+    numElements = 0;
+    numSkipped = 0;
+
+    Parser parser(*this, onShape);
+    std::vector<char> chunk(std::max<std::size_t>(1024u, settings.readChunkSize));
+    std::string buffer;
+    bool bEof = false;
+    while(!bEof){
+        stream.read(chunk.data(), chunk.size());
+        const std::streamsize numRead = stream.gcount();
+        if(numRead>0) buffer.append(chunk.data(), std::size_t(numRead));
+        bEof = !stream;
+
+        // Keep only the incomplete tail for the next chunk
+        const std::size_t consumed = parser.processBuffer(buffer, 0);
+        buffer.erase(0, consumed);
+    }
+    parser.finish();
+
+    if(!buffer.empty()){
+        ofLogWarning("ofxBlend2DSvgLoader") << "The SVG data ends with an incomplete tag, it might be truncated.";
+    }
+
+    loadTimeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now()-startTime).count();
+    ofLogVerbose("ofxBlend2DSvgLoader") << "Parsed " << numElements << " elements in " << loadTimeMs << " ms (" << numSkipped << " skipped).";
+    return true;
+}
+
+// Parsing primitives
+// - - - -
+bool ofxBlend2DSvgLoader::parsePathData(const char* data, std::size_t size, BLPath& out){
+    const char* p = data;
+    const char* end = data+size;
+    char cmd = 0;
+    char prevCmd = 0; // Uppercase, for smooth curve reflections
+    BLPoint cur(0, 0), start(0, 0), lastCtrl(0, 0);
+    double v[6];
+
+    auto readNumbers = [&](int n) -> bool {
+        for(int i=0; i<n; ++i){
+            skipSeparators(p, end);
+            if(!parseNumber(p, end, v[i])) return false;
+        }
+        return true;
+    };
+
+    while(true){
+        skipSeparators(p, end);
+        if(p>=end) break;
+        if(isAlpha(*p)){
+            cmd = *p;
+            ++p;
+        }
+        else if(cmd==0){
+            return false; // Data must start with a command, and Z takes no numbers
+        }
+
+        const bool isRelative = (cmd>='a' && cmd<='z');
+        const char command = isRelative ? char(cmd-'a'+'A') : cmd;
+        const BLPoint base = isRelative ? cur : BLPoint(0, 0);
+
+        switch(command){
+            case 'M':
+                if(!readNumbers(2)) return false;
+                cur = BLPoint(base.x+v[0], base.y+v[1]);
+                start = cur;
+                out.move_to(cur);
+                cmd = isRelative ? 'l' : 'L'; // Following pairs are implicit line-to
+                break;
+            case 'L':
+                if(!readNumbers(2)) return false;
+                cur = BLPoint(base.x+v[0], base.y+v[1]);
+                out.line_to(cur);
+                break;
+            case 'H':
+                if(!readNumbers(1)) return false;
+                cur.x = base.x+v[0];
+                out.line_to(cur);
+                break;
+            case 'V':
+                if(!readNumbers(1)) return false;
+                cur.y = base.y+v[0];
+                out.line_to(cur);
+                break;
+            case 'C': {
+                if(!readNumbers(6)) return false;
+                const BLPoint c1(base.x+v[0], base.y+v[1]);
+                lastCtrl = BLPoint(base.x+v[2], base.y+v[3]);
+                cur = BLPoint(base.x+v[4], base.y+v[5]);
+                out.cubic_to(c1, lastCtrl, cur);
+                break;
+            }
+            case 'S': {
+                if(!readNumbers(4)) return false;
+                const BLPoint c1 = (prevCmd=='C' || prevCmd=='S') ? BLPoint(2*cur.x-lastCtrl.x, 2*cur.y-lastCtrl.y) : cur;
+                lastCtrl = BLPoint(base.x+v[0], base.y+v[1]);
+                cur = BLPoint(base.x+v[2], base.y+v[3]);
+                out.cubic_to(c1, lastCtrl, cur);
+                break;
+            }
+            case 'Q':
+                if(!readNumbers(4)) return false;
+                lastCtrl = BLPoint(base.x+v[0], base.y+v[1]);
+                cur = BLPoint(base.x+v[2], base.y+v[3]);
+                out.quad_to(lastCtrl, cur);
+                break;
+            case 'T':
+                if(!readNumbers(2)) return false;
+                lastCtrl = (prevCmd=='Q' || prevCmd=='T') ? BLPoint(2*cur.x-lastCtrl.x, 2*cur.y-lastCtrl.y) : cur;
+                cur = BLPoint(base.x+v[0], base.y+v[1]);
+                out.quad_to(lastCtrl, cur);
+                break;
+            case 'A': {
+                bool largeArc, sweep;
+                if(!readNumbers(3)) return false;
+                const double rx = std::abs(v[0]), ry = std::abs(v[1]), rotation = v[2];
+                if(!parseFlag(p, end, largeArc) || !parseFlag(p, end, sweep)) return false;
+                if(!readNumbers(2)) return false;
+                cur = BLPoint(base.x+v[0], base.y+v[1]);
+                if(rx==0 || ry==0) out.line_to(cur);
+                else out.elliptic_arc_to(BLPoint(rx, ry), degToRad(rotation), largeArc, sweep, cur);
+                break;
+            }
+            case 'Z':
+                out.close();
+                cur = start;
+                cmd = 0;
+                break;
+            default:
+                return false;
+        }
+        prevCmd = command;
+    }
+    return true;
+}
+
+BLMatrix2D ofxBlend2DSvgLoader::parseTransform(const std::string& data){
+    BLMatrix2D ret = BLMatrix2D::make_identity();
+    const char* p = data.c_str();
+    const char* end = p+data.size();
+    while(p<end){
+        skipSeparators(p, end);
+        const char* nameStart = p;
+        while(p<end && isAlpha(*p)) ++p;
+        const std::string name(nameStart, p);
+        skipSpaces(p, end);
+        if(name.empty() || p>=end || *p!='(') break;
+        ++p;
+
+        double a[6] = {0};
+        int n = 0;
+        while(n<6){
+            skipSeparators(p, end);
+            if(!parseNumber(p, end, a[n])) break;
+            ++n;
+        }
+        while(p<end && *p!=')') ++p;
+        if(p<end) ++p;
+
+        // Each transform of the list applies before the previous ones
+        if(name=="matrix" && n==6) ret.transform(BLMatrix2D(a[0], a[1], a[2], a[3], a[4], a[5]));
+        else if(name=="translate" && n>=1) ret.translate(a[0], n>1 ? a[1] : 0.0);
+        else if(name=="scale" && n>=1) ret.scale(a[0], n>1 ? a[1] : a[0]);
+        else if(name=="rotate" && n>=1){
+            if(n>=3) ret.rotate(degToRad(a[0]), a[1], a[2]);
+            else ret.rotate(degToRad(a[0]));
+        }
+        else if(name=="skewX" && n>=1) ret.skew(degToRad(a[0]), 0.0);
+        else if(name=="skewY" && n>=1) ret.skew(0.0, degToRad(a[0]));
+    }
+    return ret;
+}
+
+bool ofxBlend2DSvgLoader::parseColor(const std::string& data, ofFloatColor& out){
+    const std::string value = trim(data);
+    if(value.empty() || value=="none" || value=="transparent") return false;
+
+    // Hex notations
+    if(value[0]=='#'){
+        auto hex = [](char c) -> int {
+            if(c>='0' && c<='9') return c-'0';
+            if(c>='a' && c<='f') return c-'a'+10;
+            if(c>='A' && c<='F') return c-'A'+10;
+            return 0;
+        };
+        const std::size_t len = value.size()-1;
+        int c[4] = {0, 0, 0, 255};
+        if(len==3 || len==4){
+            for(std::size_t i=0; i<len; ++i) c[i] = hex(value[1+i])*17;
+        }
+        else if(len==6 || len==8){
+            for(std::size_t i=0; i<len/2; ++i) c[i] = hex(value[1+i*2])*16 + hex(value[2+i*2]);
+        }
+        else return false;
+        out = ofFloatColor(c[0]/255.f, c[1]/255.f, c[2]/255.f, c[3]/255.f);
+        return true;
+    }
+
+    // Functional notations
+    if(value.compare(0, 4, "rgb(")==0 || value.compare(0, 5, "rgba(")==0){
+        const char* p = value.c_str()+value.find('(')+1;
+        const char* end = value.c_str()+value.size();
+        float c[4] = {0, 0, 0, 1};
+        for(int i=0; i<4; ++i){
+            while(p<end && (isSpace(*p) || *p==',' || *p=='/')) ++p;
+            double v;
+            if(!parseNumber(p, end, v)) break;
+            const bool isPercent = (p<end && *p=='%');
+            if(isPercent) ++p;
+            if(i<3) c[i] = float(isPercent ? v/100.0 : v/255.0);
+            else c[i] = float(isPercent ? v/100.0 : v);
+        }
+        out = ofFloatColor(ofClamp(c[0], 0, 1), ofClamp(c[1], 0, 1), ofClamp(c[2], 0, 1), ofClamp(c[3], 0, 1));
+        return true;
+    }
+
+    if(value.compare(0, 4, "url(")==0) return false;
+
+    // Some common names
+    static const std::pair<const char*, uint32_t> names[] = {
+        {"black", 0x000000}, {"white", 0xFFFFFF}, {"red", 0xFF0000}, {"lime", 0x00FF00}, {"green", 0x008000},
+        {"blue", 0x0000FF}, {"yellow", 0xFFFF00}, {"cyan", 0x00FFFF}, {"aqua", 0x00FFFF}, {"magenta", 0xFF00FF},
+        {"fuchsia", 0xFF00FF}, {"gray", 0x808080}, {"grey", 0x808080}, {"silver", 0xC0C0C0}, {"maroon", 0x800000},
+        {"olive", 0x808000}, {"navy", 0x000080}, {"purple", 0x800080}, {"teal", 0x008080}, {"orange", 0xFFA500},
+        {"brown", 0xA52A2A}, {"pink", 0xFFC0CB}, {"gold", 0xFFD700}, {"darkgray", 0xA9A9A9}, {"lightgray", 0xD3D3D3},
+        {"currentColor", 0x000000},
+    };
+    for(const auto& name : names){
+        if(value==name.first){
+            out = ofFloatColor::fromHex(name.second);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "blend2d/blend2d.h"
+#include "ofxBlend2DPathStyle.h"
+#include "ofxBlend2DWorkerPool.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+// Native SVG importer
+// - - - -
+// Parses SVG files straight into BLPaths + ofxBlend2DPathStyle, without an XML DOM nor intermediate ofPaths.
+// - The file is streamed in chunks, only the current chunk and the pending elements are held in memory.
+// - Elements are collected in batches which are parsed in parallel (geometry, style, transforms), then emitted in document order.
+//   Batches run on the loader's persistent ofxBlend2DWorkerPool, while the next batch is being scanned.
+// - Supported : path (all commands, including arcs and quads), rect, circle, ellipse, line, polyline, polygon,
+//   g/svg/a groups, transform attributes, presentation attributes and inline `style`, viewBox.
+// - Unsupported (skipped) : text, use, gradients/patterns (painted as none), CSS stylesheets, clipping and masks.
+
+struct ofxBlend2DSvgShape {
+    BLPath path; // In document coordinates (transforms are applied)
+    ofxBlend2DPathStyle style;
+    std::string id; // Element id attribute, if any
+    std::string type; // Element name : path, rect, circle...
+};
+
+class ofxBlend2DSvgLoader {
+    public:
+        struct Settings {
+            unsigned int numThreads = 0; // 0 = hardware concurrency
+            std::size_t batchSize = 512; // Elements per parallel batch
+            std::size_t readChunkSize = 1u<<16; // Bytes read from disk at once
+        };
+
+        ofxBlend2DSvgLoader() = default;
+        explicit ofxBlend2DSvgLoader(const Settings& _settings) : settings(_settings) {}
+
+        // Loads the file (relative to the data folder) and stores the shapes
+        bool load(const std::string& filePath);
+        bool loadFromString(const std::string& svgData);
+
+        // Streams shapes to a callback (in document order) instead of storing them
+        using ShapeCallback = std::function<void(ofxBlend2DSvgShape&& shape)>;
+        bool load(const std::string& filePath, const ShapeCallback& onShape);
+
+        void clear();
+
+        std::vector<ofxBlend2DSvgShape>& getShapes() { return shapes; }
+        const std::vector<ofxBlend2DSvgShape>& getShapes() const { return shapes; }
+
+        // Document info (from the root svg element)
+        const BLSize& getDocumentSize() const { return documentSize; }
+
+        // Stats of the last load
+        std::size_t getNumElements() const { return numElements; }
+        std::size_t getNumSkippedElements() const { return numSkipped; }
+        float getLoadTimeMs() const { return loadTimeMs; }
+
+        Settings settings;
+
+        // Parsing primitives, also usable standalone
+        // Parses SVG path data (the `d` attribute) into out. Returns false on malformed data (out contains what was parsed).
+        static bool parsePathData(const char* data, std::size_t size, BLPath& out);
+        static bool parsePathData(const std::string& data, BLPath& out){
+            return parsePathData(data.data(), data.size(), out);
+        }
+        // Parses an SVG transform list, returns the combined matrix
+        static BLMatrix2D parseTransform(const std::string& data);
+        // Parses an SVG color (#rgb, #rrggbb, rgb(), rgba(), some names). Returns false for none or unsupported paints.
+        static bool parseColor(const std::string& data, ofFloatColor& out);
+
+    protected:
+        class Parser;
+
+        bool parseStream(std::istream& stream, const ShapeCallback& onShape);
+
+        ofxBlend2DWorkerPool pool; // Parses the batches, kept between loads
+        std::vector<ofxBlend2DSvgShape> shapes;
+        BLSize documentSize = BLSize(0, 0);
+        std::size_t numElements = 0;
+        std::size_t numSkipped = 0;
+        float loadTimeMs = 0.f;
+};
@@ -0,0 +1,144 @@
+#include "ofxBlend2DThreadTuner.h"
+#include "ofxBlend2DUtils.h"
+#include "blend2d/blend2d.h"
+#include "ofUtils.h" // ofGetElapsedTimeMicros
+#include "ofLog.h"
+
+#include <algorithm>
+#include <thread>
+#include <limits>
+
+std::atomic<unsigned int> ofxBlend2DThreadTuner::numClaimedThreads{0};
+
+ofxBlend2DThreadTuner::ofxBlend2DThreadTuner(){
+    std::lock_guard<std::mutex> lock(mutex);
+    startProbing();
+}
+
+ofxBlend2DThreadTuner::~ofxBlend2DThreadTuner(){
+    numClaimedThreads -= claimedThreads;
+}
+
+void ofxBlend2DThreadTuner::setSettings(const Settings& _settings){
+    std::lock_guard<std::mutex> lock(mutex);
+    settings = _settings;
+    settings.samplesPerCandidate = std::max(1u, settings.samplesPerCandidate);
+    startProbing();
+}
+
+ofxBlend2DThreadTuner::Settings ofxBlend2DThreadTuner::getSettings() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return settings;
+}
+
+void ofxBlend2DThreadTuner::startProbing(){
+    // Our cores are shared with the other tuners
+    numClaimedThreads -= claimedThreads;
+    claimedThreads = 0;
+    const unsigned int numCores = std::max(1u, std::thread::hardware_concurrency());
+    const unsigned int numAvailable = numCores - std::min(numCores-1, numClaimedThreads.load());
+    const unsigned int maxThreads = std::min(settings.maxThreads>0 ? settings.maxThreads : numCores, numAvailable);
+
+    // 0 (synchronous), 1, 2, 4... and the maximum
+    candidates.clear();
+    for(unsigned int threadCount=0; threadCount<maxThreads; threadCount = threadCount==0 ? 1 : threadCount*2){
+        candidates.emplace_back();
+        candidates.back().threadCount = threadCount;
+    }
+    candidates.emplace_back();
+    candidates.back().threadCount = maxThreads;
+
+    samples.assign(candidates.size(), std::vector<float>());
+    nextCandidate = 0;
+    recentMs.clear();
+    bProbing = true;
+}
+
+void ofxBlend2DThreadTuner::settle(){
+    for(std::size_t i=0; i<candidates.size(); ++i){
+        candidates[i].medianMs = ofxBlend2D::GetMedian(samples[i]);
+        candidates[i].numSamples = samples[i].size();
+    }
+    // Candidates are sorted by thread count : more threads have to be clearly faster
+    const Candidate* best = &candidates[0];
+    for(const Candidate& candidate : candidates){
+        if(candidate.medianMs < best->medianMs*(1.f-settings.switchMargin)) best = &candidate;
+    }
+    bestThreadCount = best->threadCount;
+    settledMs = best->medianMs;
+    settledTime = ofGetElapsedTimeMicros();
+    bProbing = false;
+    recentMs.clear();
+
+    claimedThreads = bestThreadCount;
+    numClaimedThreads += claimedThreads;
+    ofLogVerbose("ofxBlend2DThreadTuner") << "Settled on " << bestThreadCount << " threads (render " << settledMs << " ms)";
+}
+
+uint32_t ofxBlend2DThreadTuner::getThreadCount(){
+    std::lock_guard<std::mutex> lock(mutex);
+    if(!bProbing){
+        if(settings.reprobeSeconds<=0.f || ofGetElapsedTimeMicros()-settledTime < uint64_t(settings.reprobeSeconds*1000000.f)){
+            return bestThreadCount;
+        }
+        startProbing();
+    }
+    // Interleaved candidates
+    const uint32_t threadCount = candidates[nextCandidate].threadCount;
+    nextCandidate = (nextCandidate+1)%candidates.size();
+    return threadCount;
+}
+
+void ofxBlend2DThreadTuner::addFrame(const ofxBlend2DFrameTimings& timings){
+    if(!bEnabled || timings.get(ofxBlend2DFrameTimings::FlushBegin)==0) return;
+    // Submit + flush : a synchronous context rasterizes while submitting
+    float renderMs = timings.getRenderDuration()/1000.f;
+    // Didn't get its threads : not a usable setting
+    if(timings.contextErrorFlags & BL_CONTEXT_ERROR_FLAG_THREAD_POOL_EXHAUSTED) renderMs = std::numeric_limits<float>::max();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if(bProbing){
+        bool bDone = true;
+        for(std::size_t i=0; i<candidates.size(); ++i){
+            if(candidates[i].threadCount==timings.threadCount){
+                samples[i].push_back(renderMs);
+                candidates[i].numSamples = samples[i].size();
+            }
+            bDone &= samples[i].size()>=settings.samplesPerCandidate;
+        }
+        if(bDone) settle();
+        return;
+    }
+
+    // Settled : watch for a slower machine (or heavier scene)
+    if(timings.threadCount!=bestThreadCount) return; // Submitted before settling
+    recentMs.push_back(renderMs);
+    if(recentMs.size()>=settings.samplesPerCandidate*2){
+        const float recentMedianMs = ofxBlend2D::GetMedian(recentMs);
+        recentMs.clear();
+        if(settings.driftRatio>0.f && recentMedianMs>settledMs*settings.driftRatio){
+            ofLogVerbose("ofxBlend2DThreadTuner") << "Render time drifted from " << settledMs << " to " << recentMedianMs << " ms, probing again";
+            startProbing();
+        }
+    }
+}
+
+void ofxBlend2DThreadTuner::invalidate(){
+    std::lock_guard<std::mutex> lock(mutex);
+    startProbing();
+}
+
+bool ofxBlend2DThreadTuner::isProbing() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bProbing;
+}
+
+uint32_t ofxBlend2DThreadTuner::getBestThreadCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bestThreadCount;
+}
+
+std::vector<ofxBlend2DThreadTuner::Candidate> ofxBlend2DThreadTuner::getCandidates() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return candidates;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "ofxBlend2DFrameProfiler.h"
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+// Thread count tuning
+// - - - -
+// The fastest BLContextCreateInfo::thread_count depends on the canvas size, the scene and the cores : too many threads slow down small canvases.
+// Probes candidate thread counts on real frames (interleaved, so a change of machine load affects all of them alike),
+// settles on the fastest one (fewer threads win unless more are clearly faster), then probes again :
+// periodically, when the canvas changes (invalidate()) and when the settled render time drifts (other apps loading the machine).
+// Frames are timed from submission to the end of the flush (without the queue wait) : synchronous contexts rasterize while submitting.
+// Tuners share the cores : thread counts settled by other instances (ex: other renderers) are subtracted from the candidates.
+//
+// ofxBlend2DThreadedRenderer owns one, enabled with setAutoThreads(true). Thread safe : frames are added by update(), begin() reads it.
+
+class ofxBlend2DThreadTuner {
+    public:
+        struct Settings {
+            unsigned int maxThreads = 0; // Largest candidate, 0 = hardware concurrency
+            unsigned int samplesPerCandidate = 8; // Probe frames per candidate (median)
+            float switchMargin = .1f; // More threads must be that much faster (ratio) to be chosen
+            float reprobeSeconds = 30.f; // 0 = only on changes
+            float driftRatio = 1.5f; // Probes again when the settled render time grows that much
+        };
+
+        // Probe result of one thread count
+        struct Candidate {
+            uint32_t threadCount = 0;
+            float medianMs = 0.f;
+            std::size_t numSamples = 0;
+        };
+
+        ofxBlend2DThreadTuner();
+        ~ofxBlend2DThreadTuner();
+
+        void setSettings(const Settings& settings);
+        Settings getSettings() const;
+
+        // Thread count for the next frame : a candidate while probing, the fastest one when settled
+        uint32_t getThreadCount();
+        // Feeds a received frame (timings.threadCount tells which candidate it measured)
+        void addFrame(const ofxBlend2DFrameTimings& timings);
+        // Probes again, ex: after a resize or a format change
+        void invalidate();
+
+        bool isProbing() const;
+        // The settled thread count (the last one until the first probe is done)
+        uint32_t getBestThreadCount() const;
+        // Candidates of the current probe (medians are set once it's done) or of the last one when settled
+        std::vector<Candidate> getCandidates() const;
+
+        std::atomic<bool> bEnabled{false}; // Read by the submitting and GL threads
+
+    protected:
+        void startProbing(); // Needs the mutex
+        void settle();
+
+        mutable std::mutex mutex;
+        Settings settings;
+        bool bProbing = true;
+        std::vector<Candidate> candidates;
+        std::vector<std::vector<float> > samples; // Per candidate, while probing
+        std::size_t nextCandidate = 0;
+        uint32_t bestThreadCount = 0;
+        float settledMs = 0.f;
+        std::vector<float> recentMs; // Settled frames, for drift detection
+        uint64_t settledTime = 0;
+
+        // Threads claimed by the settled tuners of this process
+        static std::atomic<unsigned int> numClaimedThreads;
+        unsigned int claimedThreads = 0;
+};
@@ -0,0 +1,48 @@
+#include "ofxBlend2DUtils.h"
+#include "ofConstants.h" // TARGET_*
+#include "ofLog.h"
+
+#if defined(TARGET_LINUX)
+#   include <fstream>
+#   include <unistd.h>
+#elif defined(TARGET_OSX)
+#   include <mach/mach.h>
+#elif defined(TARGET_WIN32)
+#   include <windows.h>
+#   include <psapi.h>
+#   ifdef _MSC_VER
+#       pragma comment(lib, "psapi.lib")
+#   endif
+#endif
+
+namespace ofxBlend2D {
+    uint64_t GetResidentBytes(){
+#if defined(TARGET_LINUX)
+        std::ifstream statm("/proc/self/statm");
+        uint64_t totalPages = 0, residentPages = 0;
+        if(!(statm >> totalPages >> residentPages)) return 0;
+        return residentPages * (uint64_t)sysconf(_SC_PAGESIZE);
+#elif defined(TARGET_OSX)
+        mach_task_basic_info info;
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if(task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count)!=KERN_SUCCESS) return 0;
+        return info.resident_size;
+#elif defined(TARGET_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+        if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+        return counters.WorkingSetSize;
+#else
+        return 0;
+#endif
+    }
+
+    BLResult BeginCanvasContext(BLContext& ctx, BLImage& canvas, uint32_t threadCount){
+        BLContextCreateInfo createInfo = {};
+        createInfo.thread_count = threadCount;
+        return ctx.begin(canvas, createInfo);
+    }
+
+    void LogNotAllocated(const char* module){
+        ofLogWarning(module) << "Not allocated, call allocate() first !";
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "blend2d/blend2d.h"
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+// Utilities
+// - - - -
+// Small helpers shared by the addon's tools and the benchmark / soak examples.
+
+namespace ofxBlend2D {
+    // Median of the values (upper one for an even count), 0 when empty. Takes a copy : the values are partially sorted.
+    template<typename T>
+    T GetMedian(std::vector<T> values){
+        if(values.empty()) return T(0);
+        std::nth_element(values.begin(), values.begin()+values.size()/2, values.end());
+        return values[values.size()/2];
+    }
+
+    // Resident memory of this process in bytes (0 if unsupported on this platform)
+    uint64_t GetResidentBytes();
+
+    // Begins a context on a canvas kept between frames, with threadCount Blend2D threads (0 = synchronous).
+    // If a previous frame's context still references the canvas, begin() gets a fresh copy of it (copy on write).
+    BLResult BeginCanvasContext(BLContext& ctx, BLImage& canvas, uint32_t threadCount);
+
+    // Warns that module was used before allocate()
+    void LogNotAllocated(const char* module);
+}
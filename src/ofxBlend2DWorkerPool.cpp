@@ -0,0 +1,91 @@
+#include "ofxBlend2DWorkerPool.h"
+
+#include <algorithm>
+
+ofxBlend2DWorkerPool::~ofxBlend2DWorkerPool(){
+    wait();
+    stop();
+}
+
+void ofxBlend2DWorkerPool::start(std::size_t numJobs, const JobFunction& job, unsigned int numThreads){
+    if(numJobs==0 || !job) return;
+
+    if(numThreads==0) numThreads = std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t threads = std::max<std::size_t>(1u, std::min<std::size_t>(numThreads, numJobs));
+
+    std::unique_lock<std::mutex> lock(mutex);
+    idleCondition.wait(lock, [this](){ return !bStarted && !bStop; });
+    bStarted = true;
+    currentJob = job;
+    currentNumJobs = numJobs;
+    nextJob = 0;
+
+    // Single thread : wait() runs everything, no need to wake anyone
+    numParticipants = threads-1;
+    numBusy = numParticipants;
+    if(numParticipants==0) return;
+
+    // Workers are kept for the next runs (new ones block on the mutex until the run is described)
+    while(workers.size()<numParticipants){
+        workers.emplace_back(&ofxBlend2DWorkerPool::workerFunction, this, workers.size());
+    }
+    ++generation;
+    lock.unlock();
+    startCondition.notify_all();
+}
+
+void ofxBlend2DWorkerPool::wait(){
+    std::unique_lock<std::mutex> lock(mutex);
+    if(!bStarted) return;
+    lock.unlock();
+
+    runJobs(currentJob, currentNumJobs); // Calling thread helps too
+
+    lock.lock();
+    doneCondition.wait(lock, [this](){ return numBusy==0; });
+    currentJob = nullptr;
+    bStarted = false;
+    lock.unlock();
+    idleCondition.notify_all();
+}
+
+void ofxBlend2DWorkerPool::stop(){
+    std::unique_lock<std::mutex> lock(mutex);
+    idleCondition.wait(lock, [this](){ return !bStarted && !bStop; });
+    bStop = true;
+    lock.unlock();
+    startCondition.notify_all();
+    for(std::thread& worker : workers){
+        if(worker.joinable()) worker.join();
+    }
+    workers.clear();
+
+    lock.lock();
+    bStop = false;
+    lock.unlock();
+    idleCondition.notify_all();
+}
+
+void ofxBlend2DWorkerPool::runJobs(const JobFunction& job, std::size_t numJobs){
+    for(std::size_t i=nextJob++; i<numJobs; i=nextJob++){
+        job(i);
+    }
+}
+
+void ofxBlend2DWorkerPool::workerFunction(std::size_t index){
+    uint64_t seenGeneration = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true){
+        startCondition.wait(lock, [this, &seenGeneration](){ return bStop || generation!=seenGeneration; });
+        if(bStop) return;
+        seenGeneration = generation;
+        // Runs with less jobs than workers leave the extra ones asleep
+        if(index>=numParticipants) continue;
+
+        const std::size_t numJobs = currentNumJobs;
+        lock.unlock();
+        runJobs(currentJob, numJobs); // Not modified before numBusy reaches 0
+        lock.lock();
+        if(--numBusy==0) doneCondition.notify_all();
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+// Worker pool
+// - - - -
+// Persistent threads running indexed jobs, so per-frame (or per-batch) parallel work doesn't create and join threads every call.
+// Workers are started on the first run which needs them and sleep between runs. The calling thread runs jobs too.
+// One run at a time : a run started from another thread waits for the current one to finish. Jobs must not start runs on the same pool.
+
+class ofxBlend2DWorkerPool {
+    public:
+        typedef std::function<void(std::size_t job)> JobFunction;
+
+        ofxBlend2DWorkerPool() = default;
+        ~ofxBlend2DWorkerPool();
+        ofxBlend2DWorkerPool(const ofxBlend2DWorkerPool&) = delete;
+        ofxBlend2DWorkerPool& operator=(const ofxBlend2DWorkerPool&) = delete;
+
+        // Runs job(0..numJobs-1) on up to numThreads threads (0 = hardware concurrency), the calling one included.
+        // Each thread grabs the next job, which keeps cores busy with uneven jobs. Returns when all jobs are done.
+        void run(std::size_t numJobs, const JobFunction& job, unsigned int numThreads = 0){
+            start(numJobs, job, numThreads);
+            wait();
+        }
+
+        // Same as run() in two steps, to keep working on the calling thread meanwhile :
+        // start() hands the jobs to the workers and returns, wait() helps with the remaining ones and returns when all are done.
+        // The same thread calls both.
+        void start(std::size_t numJobs, const JobFunction& job, unsigned int numThreads = 0);
+        void wait();
+
+        // Joins the workers (restarted by the next run)
+        void stop();
+
+        std::size_t getNumWorkers() const { return workers.size(); }
+
+    protected:
+        void workerFunction(std::size_t index);
+        void runJobs(const JobFunction& job, std::size_t numJobs);
+
+        std::vector<std::thread> workers;
+
+        std::mutex mutex; // Protects the run description below
+        std::condition_variable startCondition; // Workers wait for a new generation
+        std::condition_variable doneCondition; // wait() waits for the workers
+        std::condition_variable idleCondition; // start() and stop() wait for the current run
+        JobFunction currentJob;
+        std::size_t currentNumJobs = 0;
+        std::size_t numParticipants = 0; // Workers taking part in the current run
+        std::size_t numBusy = 0; // Participants not done yet
+        uint64_t generation = 0;
+        bool bStarted = false;
+        bool bStop = false;
+
+        std::atomic<std::size_t> nextJob{0};
+};